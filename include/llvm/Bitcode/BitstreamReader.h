@@ -257,6 +257,62 @@ public:
     }
   }
 
+  /// Reads \p NumElts fields of \p NumBits bits each into \p Vals. This is
+  /// equivalent to calling Read() \p NumElts times, but the fields that are
+  /// entirely in the current word are extracted without refill checks.
+  void readFixedArray(unsigned NumBits, unsigned NumElts,
+                      SmallVectorImpl<uint64_t> &Vals) {
+    assert(NumBits && NumBits <= MaxChunkSize && "Invalid field width");
+    const word_t Mask = ~word_t(0) >> (MaxChunkSize - NumBits);
+    // Use a mask to avoid undefined behavior when NumBits is the word size.
+    const unsigned Shift = NumBits & (MaxChunkSize - 1);
+    while (NumElts) {
+      unsigned InWord = std::min(BitsInCurWord / NumBits, NumElts);
+      for (unsigned I = 0; I != InWord; ++I) {
+        Vals.push_back(CurWord & Mask);
+        CurWord >>= Shift;
+      }
+      BitsInCurWord -= InWord * NumBits;
+      NumElts -= InWord;
+
+      // The next field straddles the end of the current word.
+      if (NumElts) {
+        Vals.push_back(Read(NumBits));
+        --NumElts;
+      }
+    }
+  }
+
+  /// Reads \p NumElts VBR values with chunks of \p NumBits bits into \p Vals.
+  /// This is equivalent to calling ReadVBR64() \p NumElts times, but the
+  /// values that fit in a single chunk, which are the vast majority, are
+  /// extracted from the current word directly.
+  void readVBRArray(unsigned NumBits, unsigned NumElts,
+                    SmallVectorImpl<uint64_t> &Vals) {
+    assert(NumBits && NumBits <= MaxChunkSize && "Invalid VBR chunk width");
+    const word_t Mask = ~word_t(0) >> (MaxChunkSize - NumBits);
+    const word_t ContinueBit = word_t(1) << (NumBits - 1);
+    // ReadVBR64() truncates wider chunks to 32 bits, keep that behavior.
+    const bool FastPath = NumBits <= 32;
+    for (; NumElts; --NumElts) {
+      if (FastPath && BitsInCurWord >= NumBits && !(CurWord & ContinueBit)) {
+        Vals.push_back(CurWord & Mask);
+        CurWord >>= NumBits;
+        BitsInCurWord -= NumBits;
+        continue;
+      }
+      Vals.push_back(ReadVBR64(NumBits));
+    }
+  }
+
+  /// Reads \p NumElts char6 encoded characters into \p Vals.
+  void readChar6Array(unsigned NumElts, SmallVectorImpl<uint64_t> &Vals) {
+    size_t Begin = Vals.size();
+    readFixedArray(6, NumElts, Vals);
+    for (size_t I = Begin, E = Vals.size(); I != E; ++I)
+      Vals[I] = BitCodeAbbrevOp::DecodeChar6(Vals[I]);
+  }
+
   void SkipToFourByteBoundary() {
     // If word_t is 64-bits and if we've read less than 32 bits, just dump
     // the bits we have up to the next 32-bit boundary.
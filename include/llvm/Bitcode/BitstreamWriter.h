@@ -248,6 +248,52 @@ public:
     BlockScope.pop_back();
   }
 
+  /// Emits a copy of a block that another BitstreamWriter wrote at the top
+  /// level of its stream, which starts at the beginning of \p Block. The
+  /// block may only use the abbreviations it defines itself and those of a
+  /// BLOCKINFO_BLOCK shared with this stream (see copyBlockInfo).
+  ///
+  /// This lets independent blocks be encoded concurrently into separate
+  /// buffers and then be stitched together.
+  void emitEncodedBlock(ArrayRef<char> Block) {
+    uint64_t BitNo = 0;
+    auto Read = [&](unsigned NumBits) {
+      uint32_t Val = 0;
+      for (unsigned I = 0; I != NumBits; ++I, ++BitNo)
+        Val |= uint32_t((uint8_t(Block[BitNo / 8]) >> (BitNo % 8)) & 1) << I;
+      return Val;
+    };
+    auto ReadVBR = [&](unsigned NumBits) {
+      uint32_t Val = 0;
+      for (unsigned Shift = 0;; Shift += NumBits - 1) {
+        uint32_t Piece = Read(NumBits);
+        Val |= (Piece & ((1U << (NumBits - 1)) - 1)) << Shift;
+        if (!(Piece & (1U << (NumBits - 1))))
+          return Val;
+      }
+    };
+
+    // Decode the header of the block, which was written with the abbrev width
+    // of the top level:
+    //    [ENTER_SUBBLOCK, blockid, newcodelen, <align4bytes>, blocklen]
+    unsigned Code = Read(2);
+    (void)Code;
+    assert(Code == bitc::ENTER_SUBBLOCK && "Expected a top-level block");
+    unsigned BlockID = ReadVBR(bitc::BlockIDWidth);
+    unsigned CodeLen = ReadVBR(bitc::CodeLenWidth);
+    size_t SizeWordOffset = (BitNo + 31) / 32 * 4;
+    assert((Block.size() & 3) == 0 && Block.size() > SizeWordOffset &&
+           "Expected a complete block");
+
+    // Re-encode the header with the abbrev width of the current block. The
+    // block size and contents are word aligned, so they are copied as is.
+    EmitCode(bitc::ENTER_SUBBLOCK);
+    EmitVBR(BlockID, bitc::BlockIDWidth);
+    EmitVBR(CodeLen, bitc::CodeLenWidth);
+    FlushToWord();
+    Out.append(Block.begin() + SizeWordOffset, Block.end());
+  }
+
   //===--------------------------------------------------------------------===//
   // Record Emission
   //===--------------------------------------------------------------------===//
@@ -507,6 +553,14 @@ public:
     BlockInfoCurBID = ~0U;
     BlockInfoRecords.clear();
   }
+
+  /// Makes the abbreviations that were emitted to the BLOCKINFO_BLOCK of
+  /// \p Other available to the blocks of this stream, without emitting them.
+  /// This is meant for streams whose blocks are copied into \p Other with
+  /// emitEncodedBlock.
+  void copyBlockInfo(const BitstreamWriter &Other) {
+    BlockInfoRecords = Other.BlockInfoRecords;
+  }
 private:
   /// SwitchToBlockID - If we aren't already talking about the specified block
   /// ID, emit a BLOCKINFO_CODE_SETBID record.
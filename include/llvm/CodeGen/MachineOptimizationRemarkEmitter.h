@@ -159,7 +159,7 @@ public:
   /// (1) to filter trivial false positives or (2) to provide more context so
   /// that non-trivial false positives can be quickly detected by the user.
   bool allowExtraAnalysis(StringRef PassName) const {
-    return (MF.getFunction()->getContext().getDiagnosticsOutputFile() ||
+    return (MF.getFunction()->getContext().hasDiagnosticsOutput() ||
             MF.getFunction()->getContext()
             .getDiagHandlerPtr()->isAnyRemarkEnabled(PassName));
   }
@@ -35,13 +35,16 @@ class raw_pwrite_stream;
 /// Writes bitcode for individual partitions into output streams in BCOSs, if
 /// BCOSs is not empty.
 ///
+/// If BalanceBySize is true, the partitions are balanced by estimated code size
+/// rather than by the number of globals (see SplitModule).
+///
 /// \returns M if OSs.size() == 1, otherwise returns std::unique_ptr<Module>().
 std::unique_ptr<Module>
 splitCodeGen(std::unique_ptr<Module> M, ArrayRef<raw_pwrite_stream *> OSs,
              ArrayRef<llvm::raw_pwrite_stream *> BCOSs,
              const std::function<std::unique_ptr<TargetMachine>()> &TMFactory,
              TargetMachine::CodeGenFileType FT = TargetMachine::CGFT_ObjectFile,
-             bool PreserveLocals = false);
+             bool PreserveLocals = false, bool BalanceBySize = false);
 
 } // namespace llvm
 
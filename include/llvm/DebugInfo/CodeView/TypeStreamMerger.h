@@ -83,6 +83,53 @@ Error mergeTypeAndIdRecords(TypeTableBuilder &DestIds,
                             SmallVectorImpl<TypeIndex> &SourceToDest,
                             const CVTypeArray &IdsAndTypes);
 
+/// \brief Merge the type streams of several object files or PDBs at once.
+/// The result is the same as calling the single stream version of this method
+/// on each stream in order, but most of the work is done in parallel.
+///
+/// Every record is identified by a hash of its contents in which the type
+/// indices it refers to are replaced by the hashes of the referenced records,
+/// so that the hash doesn't depend on the type indices of the source stream.
+/// The streams are hashed up front and their records inserted into a shared
+/// hash table on a thread pool. Only the first copy of each record is then
+/// re-written and added to the destination table, in stream order, so the
+/// destination type indices are deterministic. Streams that can't be hashed
+/// this way, such as streams that aren't topologically sorted, make the whole
+/// merge fall back to merging the streams one after another.
+///
+/// \param Dest The table to store the re-written type records into.
+///
+/// \param SourceToDest One vector per stream, indexed by the TypeIndex in the
+/// source type stream, that contains the index of the corresponding type
+/// record in the destination stream.
+///
+/// \param Types The type streams to merge in.
+///
+/// \param Threads The number of threads to use, or 0 for one per core.
+///
+/// \returns Error::success() if the operation succeeded, otherwise an
+/// appropriate error code.
+Error mergeTypeRecords(TypeTableBuilder &Dest,
+                       MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+                       ArrayRef<CVTypeArray> Types, unsigned Threads = 0);
+
+/// \brief Merge the id streams of several object files or PDBs at once. See
+/// the parallel version of mergeTypeRecords.
+///
+/// \param Types One mapping per stream to use for the type records that its
+/// id records refer to.
+Error mergeIdRecords(TypeTableBuilder &Dest,
+                     ArrayRef<SmallVector<TypeIndex, 0>> Types,
+                     MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+                     ArrayRef<CVTypeArray> Ids, unsigned Threads = 0);
+
+/// \brief Merge the unified type and id streams of several object files at
+/// once. See the parallel version of mergeTypeRecords.
+Error mergeTypeAndIdRecords(
+    TypeTableBuilder &DestIds, TypeTableBuilder &DestTypes,
+    MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+    ArrayRef<CVTypeArray> IdsAndTypes, unsigned Threads = 0);
+
 } // end namespace codeview
 } // end namespace llvm
 
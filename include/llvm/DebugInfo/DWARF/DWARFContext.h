@@ -136,7 +136,14 @@ public:
     dump(OS, DumpOpts, DumpOffsets);
   }
 
-  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts = {}) override;
+  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts = {}) override {
+    return verify(OS, DumpOpts, 1);
+  }
+
+  /// Verify the debug info, checking up to \p NumThreads units or tables
+  /// concurrently (0 means one per core). The output doesn't depend on the
+  /// number of threads.
+  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts, unsigned NumThreads);
 
   using cu_iterator_range = DWARFUnitSection<DWARFCompileUnit>::iterator_range;
   using tu_iterator_range = DWARFUnitSection<DWARFTypeUnit>::iterator_range;
@@ -257,6 +264,11 @@ public:
   /// Get a pointer to a parsed line table corresponding to a compile unit.
   const DWARFDebugLine::LineTable *getLineTableForUnit(DWARFUnit *cu);
 
+  /// Limit the number of line table rows kept in memory for address lookups.
+  /// Those lookups only index the sequences of each line table, and parse
+  /// rows one sequence at a time.
+  void setMaxCachedLineTableRows(size_t MaxRows);
+
   DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
   DILineInfoTable getLineInfoForAddressRange(uint64_t Address, uint64_t Size,
@@ -264,6 +276,13 @@ public:
   DIInliningInfo getInliningInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
 
+  /// Returns the range of addresses around \p Address for which
+  /// getLineInfoForAddress() and getInliningInfoForAddress() give the same
+  /// results as for \p Address: the intersection of its line table row with
+  /// the range that has the same inlined chain. If there is no line table row
+  /// for \p Address, the range only holds \p Address.
+  DWARFAddressRange getLineInfoRangeForAddress(uint64_t Address);
+
   bool isLittleEndian() const { return DObj->isLittleEndian(); }
   static bool isSupportedVersion(unsigned version) {
     return version == 2 || version == 3 || version == 4 || version == 5;
@@ -297,6 +316,25 @@ private:
   /// Return the compile unit which contains instruction with provided
   /// address.
   DWARFCompileUnit *getCompileUnitForAddress(uint64_t Address);
+
+  /// Return the line table of a compile unit for address lookups: the fully
+  /// parsed table if there is one, and otherwise only its prologue and
+  /// sequence index.
+  const DWARFDebugLine::LineTable *getLineTableIndexForUnit(DWARFUnit *U);
+
+  /// Look up the file/line info for an address in a line table returned by
+  /// getLineTableIndexForUnit().
+  bool getFileLineInfoForAddress(DWARFUnit *U,
+                                 const DWARFDebugLine::LineTable &LineTable,
+                                 uint64_t Address,
+                                 DILineInfoSpecifier::FileLineInfoKind Kind,
+                                 DILineInfo &Result);
+
+  /// Look up the address range of the line table row for an address in a
+  /// line table returned by getLineTableIndexForUnit().
+  bool getRowRangeForAddress(DWARFUnit *U,
+                             const DWARFDebugLine::LineTable &LineTable,
+                             uint64_t Address, uint64_t &Begin, uint64_t &End);
 };
 
 } // end namespace llvm
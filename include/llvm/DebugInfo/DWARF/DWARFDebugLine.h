@@ -10,12 +10,15 @@
 #ifndef LLVM_DEBUGINFO_DWARFDEBUGLINE_H
 #define LLVM_DEBUGINFO_DWARFDEBUGLINE_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDataExtractor.h"
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/DebugInfo/DWARF/DWARFRelocMap.h"
 #include <cstdint>
+#include <list>
 #include <map>
 #include <string>
 #include <vector>
@@ -25,6 +28,8 @@ namespace llvm {
 class raw_ostream;
 
 class DWARFDebugLine {
+  struct ParsingState;
+
 public:
   struct FileNameEntry {
     FileNameEntry() = default;
@@ -165,6 +170,10 @@ public:
     uint64_t HighPC;
     unsigned FirstRowIndex;
     unsigned LastRowIndex;
+    /// The opcodes describing the sequence are at offsets
+    /// [ProgramOffset, ProgramEndOffset) of the line table section.
+    uint32_t ProgramOffset;
+    uint32_t ProgramEndOffset;
     bool Empty;
 
     void reset();
@@ -186,6 +195,11 @@ public:
     /// Represents an invalid row
     const uint32_t UnknownRowIndex = UINT32_MAX;
 
+    using RowVector = std::vector<Row>;
+    using RowIter = RowVector::const_iterator;
+    using SequenceVector = std::vector<Sequence>;
+    using SequenceIter = SequenceVector::const_iterator;
+
     void appendRow(const DWARFDebugLine::Row &R) { Rows.push_back(R); }
 
     void appendSequence(const DWARFDebugLine::Sequence &S) {
@@ -220,10 +234,30 @@ public:
     bool parse(const DWARFDataExtractor &DebugLineData, uint32_t *OffsetPtr,
                raw_ostream *OS = nullptr);
 
-    using RowVector = std::vector<Row>;
-    using RowIter = RowVector::const_iterator;
-    using SequenceVector = std::vector<Sequence>;
-    using SequenceIter = SequenceVector::const_iterator;
+    /// Parse the prologue and the address range and location of each
+    /// sequence, without keeping any rows. The rows of individual sequences
+    /// can then be read with parseSequenceRows().
+    bool parseSequenceIndex(const DWARFDataExtractor &DebugLineData,
+                            uint32_t *OffsetPtr);
+
+    /// Parse the rows of \p Seq, one of the sequences of a table built by
+    /// parseSequenceIndex(), into \p Result.
+    void parseSequenceRows(const DWARFDataExtractor &DebugLineData,
+                           const Sequence &Seq, RowVector &Result) const;
+
+    /// Returns the sequence containing \p Address, or nullptr.
+    const Sequence *findSequence(uint64_t Address) const;
+
+    /// Returns the index in \p SeqRows, the rows of a single sequence, of the
+    /// row with file/line info for \p Address, or UnknownRowIndex.
+    uint32_t findRowInSequenceRows(ArrayRef<Row> SeqRows,
+                                   uint64_t Address) const;
+
+    /// Fills the Result argument with the file and line information of \p R.
+    /// Returns true on success.
+    bool getFileLineInfoForRow(const Row &R, const char *CompDir,
+                               DILineInfoSpecifier::FileLineInfoKind Kind,
+                               DILineInfo &Result) const;
 
     struct Prologue Prologue;
     RowVector Rows;
@@ -232,12 +266,46 @@ public:
   private:
     uint32_t findRowInSeq(const DWARFDebugLine::Sequence &Seq,
                           uint64_t Address) const;
+    bool parseImpl(const DWARFDataExtractor &DebugLineData,
+                   uint32_t *OffsetPtr, raw_ostream *OS, bool KeepRows);
+    void parseProgram(const DWARFDataExtractor &DebugLineData,
+                      uint32_t *OffsetPtr, uint32_t EndOffset,
+                      ParsingState &State, raw_ostream *OS);
   };
 
   const LineTable *getLineTable(uint32_t Offset) const;
   const LineTable *getOrParseLineTable(const DWARFDataExtractor &DebugLineData,
                                        uint32_t Offset);
 
+  /// Returns the line table at \p Offset for use in address lookups: the
+  /// fully parsed table if there is one, and otherwise a table holding only
+  /// the prologue and the sequence index (see LineTable::parseSequenceIndex).
+  const LineTable *
+  getOrParseSequenceIndex(const DWARFDataExtractor &DebugLineData,
+                          uint32_t Offset);
+
+  /// Fills the Result argument with the file and line information
+  /// corresponding to Address in \p LT, a table returned by one of the
+  /// functions above. The rows of an indexed table are parsed one sequence at
+  /// a time, as needed, and cached. Returns true on success.
+  bool getFileLineInfoForAddress(const DWARFDataExtractor &DebugLineData,
+                                 const LineTable &LT, uint64_t Address,
+                                 const char *CompDir,
+                                 DILineInfoSpecifier::FileLineInfoKind Kind,
+                                 DILineInfo &Result);
+
+  /// Sets \p Begin and \p End to the address range of the row of \p LT that
+  /// holds the file and line information for \p Address, parsing the rows of
+  /// an indexed table as getFileLineInfoForAddress() does. Returns false if
+  /// there is no such row.
+  bool getRowRangeForAddress(const DWARFDataExtractor &DebugLineData,
+                             const LineTable &LT, uint64_t Address,
+                             uint64_t &Begin, uint64_t &End);
+
+  /// Limits the number of rows of individually parsed sequences kept in
+  /// memory. The least recently used sequences are evicted first.
+  void setMaxCachedSequenceRows(size_t MaxRows);
+
 private:
   struct ParsingState {
     ParsingState(struct LineTable *LT);
@@ -252,6 +320,10 @@ private:
     unsigned RowNumber = 0;
     struct Row Row;
     struct Sequence Sequence;
+    /// Whether rows and sequences are appended to the line table, or only
+    /// counted.
+    bool KeepRows = true;
+    bool KeepSequences = true;
   };
 
   using LineTableMapTy = std::map<uint32_t, LineTable>;
@@ -259,6 +331,25 @@ private:
   using LineTableConstIter = LineTableMapTy::const_iterator;
 
   LineTableMapTy LineTableMap;
+
+  /// Line tables parsed by getOrParseSequenceIndex(), with no rows.
+  LineTableMapTy SequenceIndexMap;
+
+  /// Rows of sequences of indexed tables, most recently used first.
+  using CachedSequenceKey = std::pair<const LineTable *, const Sequence *>;
+  using CachedSequenceList =
+      std::list<std::pair<CachedSequenceKey, LineTable::RowVector>>;
+  CachedSequenceList CachedSequences;
+
+  /// Returns the rows of \p Seq, a sequence of the indexed table \p LT,
+  /// parsing them if they are not cached.
+  const LineTable::RowVector &
+  getOrParseSequenceRows(const DWARFDataExtractor &DebugLineData,
+                         const LineTable &LT, const Sequence &Seq);
+
+  DenseMap<CachedSequenceKey, CachedSequenceList::iterator> CachedSequenceMap;
+  size_t NumCachedRows = 0;
+  size_t MaxCachedRows = 1 << 20;
 };
 
 } // end namespace llvm
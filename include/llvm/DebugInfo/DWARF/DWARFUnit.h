@@ -335,6 +335,11 @@ public:
   void getInlinedChainForAddress(uint64_t Address,
                                  SmallVectorImpl<DWARFDie> &InlinedChain);
 
+  /// Returns the range of addresses around \p Address that have the same
+  /// inlined chain as \p Address.
+  std::pair<uint64_t, uint64_t>
+  getInlinedChainRangeForAddress(uint64_t Address);
+
   /// getUnitSection - Return the DWARFUnitSection containing this unit.
   const DWARFUnitSectionBase &getUnitSection() const { return UnitSection; }
 
@@ -416,6 +421,10 @@ private:
   /// encompassing the provided address. The pointer is alive as long as parsed
   /// compile unit DIEs are not cleared.
   DWARFDie getSubroutineForAddress(uint64_t Address);
+
+  /// Returns the range of addresses around \p Address that
+  /// getSubroutineForAddress() maps to the same DIE, or to no DIE.
+  std::pair<uint64_t, uint64_t> getSubroutineRangeForAddress(uint64_t Address);
 };
 
 } // end namespace llvm
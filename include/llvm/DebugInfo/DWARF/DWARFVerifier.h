@@ -10,12 +10,17 @@
 #ifndef LLVM_DEBUGINFO_DWARF_DWARFVERIFIER_H
 #define LLVM_DEBUGINFO_DWARF_DWARFVERIFIER_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/DebugInfo/DIContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugLine.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugRangeList.h"
 #include "llvm/DebugInfo/DWARF/DWARFDie.h"
 
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 
 namespace llvm {
@@ -87,19 +92,45 @@ public:
   };
 
 private:
+  /// A compile unit and its line table, which is parsed by the verifier
+  /// rather than taken from the context.
+  struct UnitLineTable {
+    DWARFUnit *Unit;
+    std::unique_ptr<DWARFDebugLine::LineTable> LineTable;
+  };
+
   raw_ostream &OS;
   DWARFContext &DCtx;
   DIDumpOptions DumpOpts;
+  /// The maximum number of units or tables verified concurrently.
+  unsigned NumThreads;
+  /// Serializes the operations that may lazily parse more of DCtx, such as
+  /// dumping a DIE, between the verifiers of concurrent tasks.
+  std::shared_ptr<std::mutex> ContextMutex;
   /// A map that tracks all references (converted absolute references) so we
   /// can verify each reference points to a valid DIE and not an offset that
   /// lies between to valid DIEs.
   std::map<uint64_t, std::set<uint32_t>> ReferenceToDIEOffsets;
   uint32_t NumDebugLineErrors = 0;
 
+  /// Creates a verifier that reports to \p S on behalf of \p Parent, for use
+  /// by a single task of a parallel verification.
+  DWARFVerifier(raw_ostream &S, const DWARFVerifier &Parent);
+
   raw_ostream &error() const;
   raw_ostream &warn() const;
   raw_ostream &note() const;
 
+  /// Dumps \p Die to OS while holding the context lock.
+  void dump(const DWARFDie &Die, DIDumpOptions Opts = DIDumpOptions()) const;
+
+  /// Runs \p Task(I, V) for each I in [0, \p NumTasks), using up to
+  /// NumThreads threads. Each task reports to its own verifier V, and the
+  /// reports are printed to OS in index order once all tasks are done, so the
+  /// output doesn't depend on the number of threads.
+  void runTasks(size_t NumTasks,
+                function_ref<void(size_t, DWARFVerifier &)> Task);
+
   /// Verifies the abbreviations section.
   ///
   /// This function currently checks that:
@@ -187,16 +218,19 @@ private:
   /// references for the .debug_info section
   unsigned verifyDebugInfoReferences();
 
+  /// Parse the line table of each compile unit, concurrently.
+  std::vector<UnitLineTable> parseLineTables();
+
   /// Verify the the DW_AT_stmt_list encoding and value and ensure that no
   /// compile units that have the same DW_AT_stmt_list value.
-  void verifyDebugLineStmtOffsets();
+  void verifyDebugLineStmtOffsets(ArrayRef<UnitLineTable> LineTables);
 
   /// Verify that all of the rows in the line table are valid.
   ///
   /// This function currently checks for:
   /// - addresses within a sequence that decrease in value
   /// - invalid file indexes
-  void verifyDebugLineRows();
+  void verifyDebugLineRows(const UnitLineTable &LT);
 
   /// Verify that an Apple-style accelerator table is valid.
   ///
@@ -219,9 +253,12 @@ private:
                             DataExtractor *StrData, const char *SectionName);
 
 public:
+  /// \param NumThreads The maximum number of units or tables to verify
+  /// concurrently; 0 means one per core. The output is the same for any
+  /// number of threads.
   DWARFVerifier(raw_ostream &S, DWARFContext &D,
-                DIDumpOptions DumpOpts = DIDumpOptions::getForSingleDIE())
-      : OS(S), DCtx(D), DumpOpts(std::move(DumpOpts)) {}
+                DIDumpOptions DumpOpts = DIDumpOptions::getForSingleDIE(),
+                unsigned NumThreads = 1);
   /// Verify the information in any of the following sections, if available:
   /// .debug_abbrev, debug_abbrev.dwo
   ///
@@ -21,6 +21,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <mutex>
 #include <vector>
 
 namespace llvm {
@@ -85,6 +86,7 @@ public:
 private:
   Error initializeModInfo(BinaryStreamRef ModInfo);
   Error initializeFileInfo(BinaryStreamRef FileInfo);
+  uint32_t getModuleDescriptorOffset(uint32_t Modi) const;
 
   VarStreamArray<DbiModuleDescriptor> Descriptors;
 
@@ -100,10 +102,14 @@ private:
   // ModFileCountArray.
   std::vector<uint32_t> ModuleInitialFileIndex;
 
-  // In order to provide random access into the Descriptors array, we iterate it
-  // once up front to find the offsets of the individual items and store them in
-  // this array.
-  std::vector<uint32_t> ModuleDescriptorOffsets;
+  // In order to provide random access into the Descriptors array, we record
+  // the offsets of the individual items in this array.  Descriptors are
+  // variable length, so it is filled in on demand, only as far as the highest
+  // module looked up so far, so that looking up one module of a large PDB
+  // doesn't read every descriptor.  Modules may be looked up from several
+  // threads, so the array is guarded by ModuleDescriptorOffsetsMutex.
+  mutable std::vector<uint32_t> ModuleDescriptorOffsets;
+  mutable std::mutex ModuleDescriptorOffsetsMutex;
 
   const FileInfoSubstreamHeader *FileInfoHeader = nullptr;
 
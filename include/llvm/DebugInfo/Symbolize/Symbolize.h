@@ -14,6 +14,8 @@
 #ifndef LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
 #define LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Object/ObjectFile.h"
@@ -22,6 +24,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,8 +34,12 @@ namespace symbolize {
 
 using namespace object;
 
+class SymbolizationCache;
+
 using FunctionNameKind = DILineInfoSpecifier::FunctionNameKind;
 
+/// Symbolizes addresses in binaries, caching the loaded modules. All the
+/// symbolize functions may be called from several threads at once.
 class LLVMSymbolizer {
 public:
   struct Options {
@@ -42,6 +49,9 @@ public:
     bool RelativeAddresses : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// Directory holding persistent code symbolization results, keyed by the
+    /// build ID of each binary. Caching is disabled if empty.
+    std::string CachePath;
 
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
@@ -51,11 +61,8 @@ public:
           DefaultArch(std::move(DefaultArch)) {}
   };
 
-  LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
-
-  ~LLVMSymbolizer() {
-    flush();
-  }
+  LLVMSymbolizer(const Options &Opts = Options());
+  ~LLVMSymbolizer();
 
   Expected<DILineInfo> symbolizeCode(const std::string &ModuleName,
                                      uint64_t ModuleOffset,
@@ -65,6 +72,31 @@ public:
                                                 StringRef DWPName = "");
   Expected<DIGlobal> symbolizeData(const std::string &ModuleName,
                                    uint64_t ModuleOffset);
+
+  /// A module and an offset in it to symbolize.
+  struct SymbolizeRequest {
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+  };
+
+  /// Symbolizes a batch of code addresses, possibly in many modules, on up to
+  /// \p Threads threads (0 means one per core). The requests are grouped by
+  /// module and the addresses of each module are resolved in address order,
+  /// so that queries against the same compile unit are adjacent. Modules are
+  /// resolved concurrently, and the addresses of a module with DWARF debug
+  /// info are further split into contiguous address ranges, each resolved
+  /// with its own DWARF context. The I-th result corresponds to the I-th
+  /// request. As with the single address versions, an error loading a module
+  /// is only returned for the first request against it.
+  std::vector<Expected<DILineInfo>>
+  symbolizeCode(ArrayRef<SymbolizeRequest> Requests, StringRef DWPName = "",
+                unsigned Threads = 0);
+  std::vector<Expected<DIInliningInfo>>
+  symbolizeInlinedCode(ArrayRef<SymbolizeRequest> Requests,
+                       StringRef DWPName = "", unsigned Threads = 0);
+
+  /// Writes back any symbolization cache and drops all loaded modules. Must
+  /// not be called while other threads are symbolizing.
   void flush();
 
   static std::string
@@ -83,6 +115,43 @@ private:
   Expected<SymbolizableModule *>
   getOrCreateModuleInfo(const std::string &ModuleName, StringRef DWPName = "");
 
+  /// Returns a new module for \p ModuleName, which must already have been
+  /// loaded, with a DWARF context of its own, or nullptr if that fails. The
+  /// object files are shared with the cached module.
+  std::unique_ptr<SymbolizableModule>
+  createDWARFModuleInfo(const std::string &ModuleName, StringRef DWPName);
+
+  DILineInfo symbolizeCodeInModule(SymbolizableModule *Info,
+                                   uint64_t ModuleOffset) const;
+  DIInliningInfo symbolizeInlinedCodeInModule(SymbolizableModule *Info,
+                                              uint64_t ModuleOffset) const;
+
+  template <typename T>
+  std::vector<Expected<T>> symbolizeBatch(
+      ArrayRef<SymbolizeRequest> Requests, StringRef DWPName, unsigned Threads,
+      function_ref<bool(SymbolizationCache &, uint64_t, T &)> Lookup,
+      function_ref<T(SymbolizableModule *, uint64_t)> Compute,
+      function_ref<void(SymbolizationCache &, uint64_t, uint64_t, const T &)>
+          Add);
+
+  /// Returns the range of module offsets around \p ModuleOffset that have the
+  /// same code symbolization results, to be cached together.
+  std::pair<uint64_t, uint64_t> getCodeRange(SymbolizableModule *Info,
+                                             uint64_t ModuleOffset) const;
+
+  /// Splits a "path:arch" module name into the binary path and architecture.
+  std::pair<std::string, std::string>
+  getBinaryAndArchName(const std::string &ModuleName) const;
+
+  /// Returns the on-disk symbolization cache for a module, or nullptr if
+  /// caching is disabled or the module has no build ID. Only the binary
+  /// itself is opened to compute the key; its debug info is left untouched.
+  SymbolizationCache *getOrCreateCache(const std::string &ModuleName,
+                                       StringRef DWPName);
+
+  /// Returns a hash of the options that affect code symbolization results.
+  uint32_t getCacheFingerprint(StringRef DWPName) const;
+
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
@@ -100,8 +169,15 @@ private:
   Expected<ObjectFile *> getOrCreateObject(const std::string &Path,
                                           const std::string &ArchName);
 
+  /// Guards the maps below. Each module guards its own debug info context.
+  std::mutex Mutex;
+
   std::map<std::string, std::unique_ptr<SymbolizableModule>> Modules;
 
+  /// \brief Contains the symbolization cache for each module, or nullptr if
+  /// the module cannot be cached.
+  std::map<std::string, std::unique_ptr<SymbolizationCache>> Caches;
+
   /// \brief Contains cached results of getOrCreateObjectPair().
   std::map<std::pair<std::string, std::string>, ObjectPair>
       ObjectPairForPathArch;
@@ -0,0 +1,234 @@
+//===- BinaryRemarks.h - Binary optimization remarks format -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains data definitions and a reader and writer for a binary
+// representation of optimization remarks. It is a compact alternative to the
+// YAML optimization record file written with -pass-remarks-output: the pass,
+// remark and function names, the file names and the argument strings that
+// remarks share are written once, so the file is a fraction of the size of the
+// YAML file and much cheaper to produce.
+//
+// The file is a header followed by arrays of fixed size records and a string
+// table. The arguments of a remark are contiguous. A reader maps the file into
+// memory and reads any remark in place; remarks can be converted to YAML
+// records identical to the ones written by the compiler, for tools such as
+// opt-viewer.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_BINARYREMARKS_H
+#define LLVM_IR_BINARYREMARKS_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class raw_ostream;
+
+namespace yaml {
+class Output;
+} // end namespace yaml
+
+namespace remarks {
+
+/// The kind of a remark, which is the tag of its YAML record.
+enum class RemarkKind : uint8_t {
+  Passed,
+  Missed,
+  Analysis,
+  AnalysisFPCommute,
+  AnalysisAliasing,
+  Failure,
+};
+
+/// A source location attached to a remark or to one of its arguments.
+struct RemarkLocation {
+  StringRef File;
+  unsigned Line = 0;
+  unsigned Column = 0;
+};
+
+/// A key-value argument of a remark.
+struct RemarkArgument {
+  StringRef Key;
+  StringRef Val;
+  Optional<RemarkLocation> Loc;
+};
+
+/// A remark as it is saved in an optimization record file. The strings are
+/// owned by whoever produced the remark: the diagnostic it was created from,
+/// or the buffer it was read from.
+struct Remark {
+  RemarkKind Kind = RemarkKind::Passed;
+  StringRef PassName;
+  StringRef RemarkName;
+  StringRef FunctionName;
+  Optional<RemarkLocation> Loc;
+  Optional<uint64_t> Hotness;
+  SmallVector<RemarkArgument, 4> Args;
+};
+
+namespace storage {
+
+// The data structures in this namespace define the low-level serialization
+// format. Clients that just want to read remarks should use the
+// remarks::Reader class.
+
+using Word = support::ulittle32_t;
+using DWord = support::ulittle64_t;
+
+/// A reference to a string in the string table.
+struct Str {
+  Word Offset, Size;
+
+  StringRef get(StringRef Strtab) const {
+    return {Strtab.data() + Offset, Size};
+  }
+};
+
+/// A reference to a range of objects in the file.
+template <typename T> struct Range {
+  Word Offset, Size;
+
+  ArrayRef<T> get(StringRef Data) const {
+    return {reinterpret_cast<const T *>(Data.data() + Offset), Size};
+  }
+};
+
+/// A source location. A location with an empty file name is absent.
+struct Location {
+  Str File;
+  Word Line, Column;
+};
+
+struct Argument {
+  Str Key, Val;
+  Location Loc;
+};
+
+/// A remark, with the range of its arguments within Header::Args.
+struct Remark {
+  Word Flags;
+  enum FlagBits {
+    FB_kind,                // 4 bits
+    FB_has_hotness = FB_kind + 4,
+  };
+
+  Str PassName, RemarkName, FunctionName;
+  Location Loc;
+  DWord Hotness;
+  Word ArgsBegin, ArgsEnd;
+};
+
+struct Header {
+  char Magic[8];
+
+  /// Version number of the binary remarks format. This number should be
+  /// incremented when the format changes.
+  Word Version;
+  enum { kCurrentVersion = 1 };
+
+  Range<Remark> Remarks;
+  Range<Argument> Args;
+  Range<char> Strtab;
+};
+
+} // end namespace storage
+
+/// Returns true if \p Data starts with the magic bytes of a binary remarks
+/// file.
+bool isBinaryRemarks(StringRef Data);
+
+/// Collects remarks and writes them to a stream in the binary format. The file
+/// can only be written once all the remarks are known, so the remarks are kept
+/// in memory, in their compact form, until finalize() is called.
+class Writer {
+  raw_ostream &OS;
+  bool Finalized = false;
+
+  std::vector<storage::Remark> Remarks;
+  std::vector<storage::Argument> Args;
+  std::string Strtab;
+  StringMap<uint32_t> StrtabOffsets;
+
+  void setStr(storage::Str &S, StringRef Value);
+  void setLoc(storage::Location &L, const Optional<RemarkLocation> &Loc);
+
+public:
+  explicit Writer(raw_ostream &OS) : OS(OS) {}
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  /// Adds \p R to the file. The strings of the remark are copied.
+  void emit(const Remark &R);
+
+  /// Returns the number of remarks emitted so far.
+  size_t size() const { return Remarks.size(); }
+
+  /// Writes the file to the stream. The stream must still be open, so this has
+  /// to be called before the output file is closed. Calling it again does
+  /// nothing, and no remark may be emitted afterwards.
+  void finalize();
+};
+
+/// This class can be used to read the remarks of a binary remarks file in
+/// place.
+class Reader {
+  ArrayRef<storage::Remark> Remarks;
+  ArrayRef<storage::Argument> Args;
+  StringRef Strtab;
+
+  StringRef str(storage::Str S) const { return S.get(Strtab); }
+  Optional<RemarkLocation> loc(const storage::Location &L) const;
+
+  explicit Reader(StringRef Data);
+
+public:
+  Reader() = default;
+
+  /// Checks that \p Data holds a well formed binary remarks file and returns a
+  /// reader for it. \p Data must outlive the reader.
+  static Expected<Reader> create(StringRef Data);
+
+  /// Returns the number of remarks in the file.
+  size_t size() const { return Remarks.size(); }
+
+  /// Returns the remark at index \p I, in the order the remarks were emitted.
+  /// The strings of the remark point into the file.
+  Remark getRemark(size_t I) const;
+};
+
+/// A binary remarks file that owns its (usually memory mapped) buffer.
+struct MappedFile {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  Reader TheReader;
+};
+
+/// Maps the binary remarks file at \p Path into memory.
+Expected<MappedFile> mapFile(StringRef Path);
+
+/// Writes \p R to \p Out as the YAML optimization record that
+/// -pass-remarks-output writes for it.
+void writeYAML(yaml::Output &Out, const Remark &R);
+
+} // end namespace remarks
+} // end namespace llvm
+
+#endif // LLVM_IR_BINARYREMARKS_H
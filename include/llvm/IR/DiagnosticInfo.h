@@ -39,6 +39,10 @@ class LLVMContext;
 class Module;
 class SMDiagnostic;
 
+namespace remarks {
+struct Remark;
+} // end namespace remarks
+
 /// \brief Defines the different supported severity of a diagnostic.
 enum DiagnosticSeverity : char {
   DS_Error,
@@ -446,6 +450,10 @@ public:
   /// \see DiagnosticInfo::print.
   void print(DiagnosticPrinter &DP) const override;
 
+  /// Return the remark saved in the optimization record file for this
+  /// diagnostic. The strings of the remark refer to this diagnostic.
+  remarks::Remark getRemark() const;
+
   /// Return true if this optimization remark is enabled by one of
   /// of the LLVM command line flags (-pass-remarks, -pass-remarks-missed,
   /// or -pass-remarks-analysis). Note that this only handles the LLVM
@@ -37,6 +37,12 @@ class SMDiagnostic;
 class StringRef;
 class Twine;
 
+namespace remarks {
+
+class Writer;
+
+} // end namespace remarks
+
 namespace yaml {
 
 class Output;
@@ -254,6 +260,19 @@ public:
   /// set, the handler is invoked for each diagnostic message.
   void setDiagnosticsOutputFile(std::unique_ptr<yaml::Output> F);
 
+  /// \brief Return the writer used by the backend to save optimization
+  /// diagnostics in the binary remarks format, or null. The writer is used in
+  /// addition to the YAML file, if both are set.
+  remarks::Writer *getDiagnosticsBinaryOutput();
+  /// Set the writer used to save optimization diagnostics in the binary
+  /// remarks format. The file is only written when the writer is finalized,
+  /// which is up to the owner of the output stream.
+  void setDiagnosticsBinaryOutput(std::unique_ptr<remarks::Writer> W);
+
+  /// \brief Return true if optimization diagnostics are saved to a file, in
+  /// any format.
+  bool hasDiagnosticsOutput() const;
+
   /// \brief Get the prefix that should be printed in front of a diagnostic of
   ///        the given \p Severity
   static const char *getDiagnosticMessagePrefix(DiagnosticSeverity Severity);
@@ -428,6 +428,8 @@ public:
       TIdInfo = llvm::make_unique<TypeIdInfo>();
     TIdInfo->TypeTests.push_back(Guid);
   }
+
+  friend class ModuleSummaryIndex;
 };
 
 template <> struct DenseMapInfo<FunctionSummary::VFuncId> {
@@ -798,6 +800,13 @@ public:
   /// Summary).
   void collectDefinedGVSummariesPerModule(
       StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries) const;
+
+  /// Move the modules, summaries, original names and CFI functions of
+  /// \p Other, which holds the summary of a single module, into this index.
+  /// The result is the same as reading the summary of that module into this
+  /// index directly, so summaries can be read into separate indexes
+  /// concurrently and merged in a deterministic order. \p Other is left empty.
+  void mergeFrom(ModuleSummaryIndex &Other);
 };
 
 } // end namespace llvm
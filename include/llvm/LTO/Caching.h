@@ -7,8 +7,8 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines the localCache function, which allows clients to add a
-// filesystem cache to ThinLTO.
+// This file defines the localCache and compressedLocalCache functions, which
+// allow clients to add a filesystem cache to ThinLTO.
 //
 //===----------------------------------------------------------------------===//
 
@@ -16,6 +16,7 @@
 #define LLVM_LTO_CACHING_H
 
 #include "llvm/LTO/LTO.h"
+#include "llvm/Support/CachePruning.h"
 #include <string>
 
 namespace llvm {
@@ -39,6 +40,25 @@ typedef std::function<void(unsigned Task, std::unique_ptr<MemoryBuffer> MB,
 Expected<NativeObjectCache> localCache(StringRef CacheDirectoryPath,
                                        AddBufferFn AddBuffer);
 
+/// Create a local file system cache like localCache(), but which stores each
+/// native object once per distinct contents, compressed with zlib if it is
+/// available. The entry for a key ("llvmcache-<key>") names the object it maps
+/// to ("llvmcache-z-<content hash>"), and each object records the time it took
+/// to create it, which the "prune_by=cost" pruning policy uses once
+/// setCompressedCachePruningCallbacks() has been applied to the policy.
+/// Objects are validated when loaded, and a corrupted or missing object is
+/// treated as a cache miss.
+///
+/// The buffers passed to AddBuffer are decompressed in memory, so the Path
+/// argument is always empty; clients that need a file must write one.
+Expected<NativeObjectCache> compressedLocalCache(StringRef CacheDirectoryPath,
+                                                 AddBufferFn AddBuffer);
+
+/// Sets the callbacks through which pruneCache() understands the objects of a
+/// compressedLocalCache(): they record their last use in their modification
+/// time, and their cost in their header.
+void setCompressedCachePruningCallbacks(CachePruningPolicy &Policy);
+
 } // namespace lto
 } // namespace llvm
 
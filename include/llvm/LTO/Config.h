@@ -52,6 +52,18 @@ struct Config {
   /// Disable entirely the optimizer, including importing for ThinLTO
   bool CodeGenOnly = false;
 
+  /// Run the function-level part of the regular LTO optimization pipeline on
+  /// the code generation partitions of the module, concurrently, once the
+  /// whole-program passes are done. This only has an effect with more than
+  /// one code generation partition, with the legacy pass manager and the
+  /// default pipeline, and without optimization remarks.
+  bool ParallelOpt = false;
+
+  /// Balance the code generation partitions by estimated code size rather
+  /// than by the number of global values in them. Always done when
+  /// ParallelOpt is in effect.
+  bool BalanceCodeGenPartitions = false;
+
   /// If this field is set, the set of passes run in the middle-end optimizer
   /// will be the one specified by the string. Only works with the new pass
   /// manager as the old one doesn't have this ability.
@@ -82,6 +94,25 @@ struct Config {
   /// Whether to emit the pass manager debuggging informations.
   bool DebugPassManager = false;
 
+  /// Whether to report the wall time each in-process ThinLTO backend took,
+  /// along with its estimated cost, to the info output file.
+  bool TimeThinLTOBackends = false;
+
+  /// If this field is set, the results of the ThinLTO thin link (liveness,
+  /// import and export lists, and linkage changes) are cached in this
+  /// directory, keyed by the hashes of the modules with summaries and by the
+  /// symbol resolutions. A link whose inputs are unchanged then reuses them
+  /// instead of running the whole-program analyses. Links with a module
+  /// without a hash, or with a CombinedIndexHook, are not cached.
+  std::string ThinLinkCacheDir;
+
+  /// The number of threads that read the summaries of the modules added with
+  /// LTO::add() in the background. The summaries are merged into the combined
+  /// index in the order the modules were added, so the result doesn't depend
+  /// on this number, but errors in the summaries are then reported by
+  /// LTO::run(). 0 reads each summary within LTO::add().
+  unsigned InputThreads = 0;
+
   bool ShouldDiscardValueNames = true;
   DiagnosticHandlerFunction DiagHandler;
 
@@ -40,6 +40,7 @@ class MemoryBufferRef;
 class Module;
 class Target;
 class raw_pwrite_stream;
+class ThreadPool;
 
 /// Resolve Weak and LinkOnce values in the \p Index. Linkage changes recorded
 /// in the index and the ThinLTO backends must apply the changes to the Module
@@ -301,6 +302,16 @@ private:
     ModuleSummaryIndex CombinedIndex;
     MapVector<StringRef, BitcodeModule> ModuleMap;
     DenseMap<GlobalValue::GUID, StringRef> PrevailingModuleForGUID;
+
+    /// The results of the thin link for each module, either computed by
+    /// runThinLTO() or loaded from the thin link cache.
+    StringMap<FunctionImporter::ImportMapTy> ImportLists;
+    StringMap<FunctionImporter::ExportSetTy> ExportLists;
+    StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>>
+        ResolvedODR;
+    /// The linkage of each summary in the combined index after the thin link,
+    /// in index order, when it is loaded from the thin link cache.
+    std::vector<GlobalValue::LinkageTypes> CachedLinkages;
   } ThinLTO;
 
   // The global resolution for a particular (mangled) symbol name. This is in
@@ -351,6 +362,29 @@ private:
   // Global mapping from mangled symbol names to resolutions.
   StringMap<GlobalResolution> GlobalResolutions;
 
+  /// A summary read in the background when Conf.InputThreads is nonzero.
+  struct PendingSummary {
+    /// The module path under which the summary is read.
+    std::string ModulePath;
+    /// An index holding only this module's summary.
+    ModuleSummaryIndex Index;
+    Error Err = Error::success();
+    /// The GUIDs of the symbols the linker redefined, whose summaries are made
+    /// weak once they are merged (see addThinLTO()).
+    std::vector<GlobalValue::GUID> LinkerRedefined;
+  };
+  /// The summaries being read, in the order their modules were added.
+  std::vector<std::unique_ptr<PendingSummary>> PendingSummaries;
+  std::unique_ptr<ThreadPool> SummaryReaders;
+
+  /// Starts reading the summary of BM in the background.
+  PendingSummary *readSummaryInBackground(BitcodeModule BM,
+                                          StringRef ModulePath,
+                                          uint64_t ModuleId);
+  /// Waits for the summaries being read and merges them into the combined
+  /// index, in order. Returns the first error in any of them.
+  Error mergePendingSummaries();
+
   void addModuleToGlobalRes(ArrayRef<InputFile::Symbol> Syms,
                             ArrayRef<SymbolResolution> Res, unsigned Partition,
                             bool InSummary);
@@ -373,7 +407,17 @@ private:
 
   Error runRegularLTO(AddStreamFn AddStream);
   Error runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
-                   bool HasRegularLTO);
+                   bool HasRegularLTO, bool ThinLinkCached,
+                   StringRef ThinLinkCachePath);
+
+  /// Returns the path of the thin link results for this link in
+  /// Conf.ThinLinkCacheDir, or an empty string if they can't be cached.
+  std::string getThinLinkCachePath() const;
+  /// Loads the thin link results saved at Path and applies them to the
+  /// combined index. Returns false, leaving the index untouched, if they are
+  /// missing or don't match the index.
+  bool loadThinLink(StringRef Path);
+  Error saveThinLink(StringRef Path) const;
 
   mutable bool CalledGetMaxTasks = false;
 };
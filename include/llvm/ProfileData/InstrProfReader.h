@@ -278,6 +278,15 @@ enum class HashT : uint32_t;
 
 } // end namespace IndexedInstrProf
 
+/// A record of an indexed profile, read in place from the profile buffer
+/// without decoding it.
+struct IndexedInstrProfRecordRef {
+  uint64_t Hash = 0;
+  ArrayRef<support::ulittle64_t> Counts;
+  /// The serialized value profile data of the record, empty if it has none.
+  ArrayRef<uint8_t> ValueProfData;
+};
+
 /// Trait for lookups into the on-disk hash table for the binary instrprof
 /// format.
 class InstrProfLookupTrait {
@@ -323,6 +332,16 @@ public:
                               const unsigned char *const End);
   data_type ReadData(StringRef K, const unsigned char *D, offset_type N);
 
+  /// Find the record with the given structural hash in the data of an entry,
+  /// without decoding any of the records. Returns false if the data is
+  /// malformed, and sets \p Found if there is such a record.
+  bool findRecord(const unsigned char *D, offset_type N, uint64_t FuncHash,
+                  IndexedInstrProfRecordRef &Record, bool &Found) const;
+
+  support::endianness getValueProfDataEndianness() const {
+    return ValueProfDataEndianness;
+  }
+
   // Used for testing purpose only.
   void setValueProfDataEndianness(support::endianness Endianness) {
     ValueProfDataEndianness = Endianness;
@@ -339,9 +358,15 @@ struct InstrProfReaderIndexBase {
   // Read all the profile records with the key equal to FuncName
   virtual Error getRecords(StringRef FuncName,
                                      ArrayRef<NamedInstrProfRecord> &Data) = 0;
+
+  // Find the profile record with the given name and structural hash, without
+  // decoding it.
+  virtual Error getRecordRef(StringRef FuncName, uint64_t FuncHash,
+                             IndexedInstrProfRecordRef &Record) = 0;
   virtual void advanceToNextKey() = 0;
   virtual bool atEnd() const = 0;
   virtual void setValueProfDataEndianness(support::endianness Endianness) = 0;
+  virtual support::endianness getValueProfDataEndianness() const = 0;
   virtual uint64_t getVersion() const = 0;
   virtual bool isIRLevelProfile() const = 0;
   virtual Error populateSymtab(InstrProfSymtab &) = 0;
@@ -367,6 +392,8 @@ public:
   Error getRecords(ArrayRef<NamedInstrProfRecord> &Data) override;
   Error getRecords(StringRef FuncName,
                    ArrayRef<NamedInstrProfRecord> &Data) override;
+  Error getRecordRef(StringRef FuncName, uint64_t FuncHash,
+                     IndexedInstrProfRecordRef &Record) override;
   void advanceToNextKey() override { RecordIterator++; }
 
   bool atEnd() const override {
@@ -377,6 +404,10 @@ public:
     HashTable->getInfoObj().setValueProfDataEndianness(Endianness);
   }
 
+  support::endianness getValueProfDataEndianness() const override {
+    return HashTable->getInfoObj().getValueProfDataEndianness();
+  }
+
   uint64_t getVersion() const override { return GET_VERSION(FormatVersion); }
 
   bool isIRLevelProfile() const override {
@@ -425,6 +456,12 @@ public:
   Expected<InstrProfRecord> getInstrProfRecord(StringRef FuncName,
                                                uint64_t FuncHash);
 
+  /// Return the record associated with FuncName and FuncHash as it is laid
+  /// out in the profile buffer. Nothing is decoded or copied, so this is the
+  /// cheapest way to read the counts of a function.
+  Expected<IndexedInstrProfRecordRef> getInstrProfRecordRef(StringRef FuncName,
+                                                            uint64_t FuncHash);
+
   /// Fill Counts with the profile data for the given function name.
   Error getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                           std::vector<uint64_t> &Counts);
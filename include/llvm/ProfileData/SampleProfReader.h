@@ -204,11 +204,36 @@
 //          in the text format documentation above).
 //        FUNCTION BODY
 //          A FUNCTION BODY entry describing the inlined function.
+//
+//
+// Compact binary format
+// ---------------------
+//
+// This is the binary format with a table of the top-level function bodies
+// appended, so that a reader can load the profiles of only the functions it
+// needs. The magic identifier is SPMagic(SPF_Compact_Binary) and the header,
+// name table and function bodies are encoded as above. They are followed by:
+//
+// FUNCTION OFFSET TABLE
+//    SIZE (uint64_t)
+//        Number of entries in the table.
+//    ENTRIES
+//        A list of SIZE entries, one for each top-level function body:
+//          NAME_MD5 (uint64_t)
+//            MD5 hash of the function name.
+//          OFFSET (uint64_t)
+//            Offset of the FUNCTION BODY (including its HEAD_SAMPLES) from
+//            the start of the file.
+//
+// TABLE_OFFSET (uint64_t, 8 bytes, little endian)
+//    Offset of the FUNCTION OFFSET TABLE from the start of the file.
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_PROFILEDATA_SAMPLEPROFREADER_H
 #define LLVM_PROFILEDATA_SAMPLEPROFREADER_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
@@ -231,6 +256,7 @@
 
 namespace llvm {
 
+class Module;
 class raw_ostream;
 
 namespace sampleprof {
@@ -275,6 +301,10 @@ public:
   /// \brief Read sample profiles from the associated file.
   virtual std::error_code read() = 0;
 
+  /// \brief Restrict the profiles loaded by read() to the functions defined
+  /// in \p M, for the formats that can load functions selectively.
+  virtual void collectFuncsToUse(const Module &M) {}
+
   /// \brief Print the profile for \p FName on stream \p OS.
   void dumpFunctionProfile(StringRef FName, raw_ostream &OS = dbgs());
 
@@ -387,6 +417,12 @@ protected:
   /// Read the contents of the given profile instance.
   std::error_code readProfile(FunctionSamples &FProfile);
 
+  /// Read the profile of a top-level function, including its head samples.
+  std::error_code readFuncProfile();
+
+  /// Return true if \p Magic identifies the format read by this class.
+  virtual bool verifySPMagic(uint64_t Magic) { return Magic == SPMagic(); }
+
   /// \brief Points to the current location in the buffer.
   const uint8_t *Data = nullptr;
 
@@ -403,6 +439,44 @@ private:
   std::error_code readSummary();
 };
 
+class SampleProfileReaderCompactBinary : public SampleProfileReaderBinary {
+public:
+  SampleProfileReaderCompactBinary(std::unique_ptr<MemoryBuffer> B,
+                                   LLVMContext &C)
+      : SampleProfileReaderBinary(std::move(B), C) {}
+
+  /// \brief Read and validate the file header and the function offset table.
+  std::error_code readHeader() override;
+
+  /// \brief Read the sample profiles of the functions to use, or of all the
+  /// functions if collectFuncsToUse() was not called.
+  std::error_code read() override;
+
+  /// \brief Only load the profiles of the functions defined in \p M.
+  void collectFuncsToUse(const Module &M) override;
+
+  /// \brief Return true if \p Buffer is in the format supported by this class.
+  static bool hasFormat(const MemoryBuffer &Buffer);
+
+protected:
+  bool verifySPMagic(uint64_t Magic) override {
+    return Magic == SPMagic(SPF_Compact_Binary);
+  }
+
+private:
+  std::error_code readFuncOffsetTable();
+
+  /// The offset of each top-level function profile in the buffer, keyed by
+  /// the MD5 hash of the function name.
+  DenseMap<uint64_t, uint64_t> FuncOffsetTable;
+
+  /// The MD5 hashes of the names of the functions whose profiles to load.
+  DenseSet<uint64_t> FuncsToUse;
+
+  /// Whether to load every profile, as no module was given.
+  bool UseAllFuncs = true;
+};
+
 using InlineCallStack = SmallVector<FunctionSamples *, 10>;
 
 // Supported histogram types in GCC.  Currently, we only need support for
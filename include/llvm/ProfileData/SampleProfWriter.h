@@ -28,8 +28,6 @@
 namespace llvm {
 namespace sampleprof {
 
-enum SampleProfileFormat { SPF_None = 0, SPF_Text, SPF_Binary, SPF_GCC };
-
 /// \brief Sample-based profile writer. Base class.
 class SampleProfileWriter {
 public:
@@ -43,7 +41,7 @@ public:
   /// Write all the sample profiles in the given map of samples.
   ///
   /// \returns status code of the file update operation.
-  std::error_code write(const StringMap<FunctionSamples> &ProfileMap);
+  virtual std::error_code write(const StringMap<FunctionSamples> &ProfileMap);
 
   raw_ostream &getOutputStream() { return *OutputStream; }
 
@@ -112,6 +110,7 @@ protected:
 
   std::error_code
   writeHeader(const StringMap<FunctionSamples> &ProfileMap) override;
+  virtual void writeMagicIdent();
   std::error_code writeSummary();
   std::error_code writeNameIdx(StringRef FName);
   std::error_code writeBody(const FunctionSamples &S);
@@ -127,6 +126,34 @@ private:
                               SampleProfileFormat Format);
 };
 
+/// \brief Sample-based profile writer (compact binary format).
+///
+/// This is the binary format followed by a table of the offsets of the
+/// top-level function profiles, which lets the reader load the profiles of
+/// only some of the functions.
+class SampleProfileWriterCompactBinary : public SampleProfileWriterBinary {
+public:
+  std::error_code write(const FunctionSamples &S) override;
+  std::error_code
+  write(const StringMap<FunctionSamples> &ProfileMap) override;
+
+protected:
+  SampleProfileWriterCompactBinary(std::unique_ptr<raw_ostream> &OS)
+      : SampleProfileWriterBinary(OS) {}
+
+  void writeMagicIdent() override;
+  std::error_code writeFuncOffsetTable();
+
+private:
+  /// The offset of each top-level function profile in the file, keyed by the
+  /// MD5 hash of the function name.
+  MapVector<uint64_t, uint64_t> FuncOffsetTable;
+
+  friend ErrorOr<std::unique_ptr<SampleProfileWriter>>
+  SampleProfileWriter::create(std::unique_ptr<raw_ostream> &OS,
+                              SampleProfileFormat Format);
+};
+
 } // end namespace sampleprof
 } // end namespace llvm
 
@@ -15,8 +15,10 @@
 #ifndef LLVM_SUPPORT_CACHE_PRUNING_H
 #define LLVM_SUPPORT_CACHE_PRUNING_H
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringRef.h"
 #include <chrono>
+#include <functional>
 
 namespace llvm {
 
@@ -46,13 +48,32 @@ struct CachePruningPolicy {
   /// of available space on the disk will be reduced to the amount of available
   /// space. A value of 0 disables the absolute size-based pruning.
   uint64_t MaxSizeBytes = 0;
+
+  /// Whether size-based pruning weighs the size of an entry against the time
+  /// it took to create it, as returned by GetEntryCost, and removes the
+  /// entries that free the most space per unit of recreation time first. Only
+  /// the entries with a known cost are removed this way; the others are only
+  /// subject to expiration. When false, or when GetEntryCost is not set, the
+  /// largest entries are removed first.
+  bool PruneByCost = false;
+
+  /// If set, returns the time it took to create the cache file at the given
+  /// path, in milliseconds, or None if it is unknown. Only used with
+  /// PruneByCost.
+  std::function<Optional<uint32_t>(StringRef Path)> GetEntryCost;
+
+  /// If set, returns whether the cache file at the given path records its last
+  /// use in its modification time rather than in its access time, e.g.
+  /// because GetEntryCost reads it. Expiration is then based on the former.
+  std::function<bool(StringRef Path)> UsesModificationTime;
 };
 
 /// Parse the given string as a cache pruning policy. Defaults are taken from a
 /// default constructed CachePruningPolicy object.
 /// For example: "prune_interval=30s:prune_after=24h:cache_size=50%"
 /// which means a pruning interval of 30 seconds, expiration time of 24 hours
-/// and maximum cache size of 50% of available disk space.
+/// and maximum cache size of 50% of available disk space. The "prune_by" key
+/// selects the size-based pruning order, either "size" or "cost".
 Expected<CachePruningPolicy> parseCachePruningPolicy(StringRef PolicyStr);
 
 /// Peform pruning using the supplied policy, returns true if pruning
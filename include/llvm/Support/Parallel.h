@@ -44,6 +44,20 @@ constexpr parallel_execution_policy par{};
 
 namespace detail {
 
+/// The executors a TaskGroup can schedule its tasks on.
+enum class ExecutorKind {
+  /// A pool of workers that each own a task deque. Workers run their own
+  /// tasks newest first and steal the oldest tasks of other workers when
+  /// they run out. TaskGroups synced from inside a task keep running queued
+  /// tasks while they wait, so nested parallelism neither deadlocks nor
+  /// spawns additional threads. This is the default.
+  WorkStealing,
+  /// A pool of workers sharing a single mutex-protected task stack. Kept to
+  /// allow comparing against the work-stealing executor; nested TaskGroups
+  /// must not be synced from inside its tasks.
+  SharedQueue
+};
+
 #if LLVM_ENABLE_THREADS
 
 class Latch {
@@ -70,15 +84,25 @@ public:
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  bool done() const {
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 
 class TaskGroup {
   Latch L;
+  ExecutorKind Kind;
 
 public:
+  explicit TaskGroup(ExecutorKind Kind = ExecutorKind::WorkStealing)
+      : Kind(Kind) {}
+  ~TaskGroup() { sync(); }
+
   void spawn(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  void sync() const;
 };
 
 #if defined(_MSC_VER)
@@ -147,42 +171,57 @@ void parallel_sort(RandomAccessIterator Start, RandomAccessIterator End,
                       llvm::Log2_64(std::distance(Start, End)) + 1);
 }
 
+/// \brief Runs \p Fn on [Begin, End) by repeatedly handing the upper half of
+/// the range to \p TG and keeping the lower half, down to \p GrainSize
+/// elements. A worker runs its own, smallest, halves first while idle workers
+/// steal the oldest, largest, ones, so the range is divided according to how
+/// busy the workers are rather than into fixed chunks up front, and the
+/// spawn() calls are spread over the workers.
 template <class IterTy, class FuncTy>
-void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
-  // TaskGroup has a relatively high overhead, so we want to reduce
-  // the number of spawn() calls. We'll create up to 1024 tasks here.
-  // (Note that 1024 is an arbitrary number. This code probably needs
-  // improving to take the number of available cores into account.)
-  ptrdiff_t TaskSize = std::distance(Begin, End) / 1024;
-  if (TaskSize == 0)
-    TaskSize = 1;
-
-  TaskGroup TG;
-  while (TaskSize < std::distance(Begin, End)) {
-    TG.spawn([=, &Fn] { std::for_each(Begin, Begin + TaskSize, Fn); });
-    Begin += TaskSize;
+void parallel_for_each_split(IterTy Begin, IterTy End, FuncTy &Fn,
+                             ptrdiff_t GrainSize, TaskGroup &TG) {
+  while (std::distance(Begin, End) > GrainSize) {
+    IterTy Mid = Begin + std::distance(Begin, End) / 2;
+    TG.spawn([=, &Fn, &TG] {
+      parallel_for_each_split(Mid, End, Fn, GrainSize, TG);
+    });
+    End = Mid;
   }
   std::for_each(Begin, End, Fn);
 }
 
 template <class IndexTy, class FuncTy>
-void parallel_for_each_n(IndexTy Begin, IndexTy End, FuncTy Fn) {
-  ptrdiff_t TaskSize = (End - Begin) / 1024;
-  if (TaskSize == 0)
-    TaskSize = 1;
-
-  TaskGroup TG;
-  IndexTy I = Begin;
-  for (; I + TaskSize < End; I += TaskSize) {
-    TG.spawn([=, &Fn] {
-      for (IndexTy J = I, E = I + TaskSize; J != E; ++J)
-        Fn(J);
+void parallel_for_each_n_split(IndexTy Begin, IndexTy End, FuncTy &Fn,
+                               ptrdiff_t GrainSize, TaskGroup &TG) {
+  while (Begin < End && static_cast<ptrdiff_t>(End - Begin) > GrainSize) {
+    IndexTy Mid = Begin + (End - Begin) / 2;
+    TG.spawn([=, &Fn, &TG] {
+      parallel_for_each_n_split(Mid, End, Fn, GrainSize, TG);
     });
+    End = Mid;
   }
-  for (IndexTy J = I; J < End; ++J)
+  for (IndexTy J = Begin; J < End; ++J)
     Fn(J);
 }
 
+template <class IterTy, class FuncTy>
+void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
+  // TaskGroup has a relatively high overhead, so we want to reduce
+  // the number of spawn() calls. We'll create up to 2048 tasks here.
+  ptrdiff_t GrainSize =
+      std::max<ptrdiff_t>(std::distance(Begin, End) / 1024, 1);
+  TaskGroup TG;
+  parallel_for_each_split(Begin, End, Fn, GrainSize, TG);
+}
+
+template <class IndexTy, class FuncTy>
+void parallel_for_each_n(IndexTy Begin, IndexTy End, FuncTy Fn) {
+  ptrdiff_t GrainSize =
+      Begin < End ? std::max<ptrdiff_t>((End - Begin) / 1024, 1) : 1;
+  TaskGroup TG;
+  parallel_for_each_n_split(Begin, End, Fn, GrainSize, TG);
+}
+
 #endif
 
 #endif
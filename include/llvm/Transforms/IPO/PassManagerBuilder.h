@@ -185,6 +185,8 @@ private:
                          legacy::PassManagerBase &PM) const;
   void addInitialAliasAnalysisPasses(legacy::PassManagerBase &PM) const;
   void addLTOOptimizationPasses(legacy::PassManagerBase &PM);
+  void addLTOIPOPasses(legacy::PassManagerBase &PM);
+  void addLTOFunctionOptimizationPasses(legacy::PassManagerBase &PM);
   void addLateLTOOptimizationPasses(legacy::PassManagerBase &PM);
   void addPGOInstrPasses(legacy::PassManagerBase &MPM);
   void addFunctionSimplificationPasses(legacy::PassManagerBase &MPM);
@@ -200,6 +202,13 @@ public:
   void populateModulePassManager(legacy::PassManagerBase &MPM);
   void populateLTOPassManager(legacy::PassManagerBase &PM);
   void populateThinLTOPassManager(legacy::PassManagerBase &PM);
+
+  /// populateLTOIPOPassManager - The whole-program part of the LTO pipeline,
+  /// after which the module may be split into partitions, each of which is
+  /// optimized with populateLTOPartitionPassManager. Together they stand for
+  /// populateLTOPassManager.
+  void populateLTOIPOPassManager(legacy::PassManagerBase &PM);
+  void populateLTOPartitionPassManager(legacy::PassManagerBase &PM);
 };
 
 /// Registers a function for adding a standard set of passes.  This should be
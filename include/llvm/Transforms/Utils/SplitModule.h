@@ -34,10 +34,16 @@ class StringRef;
 ///   module.
 /// - Internal symbols defined in module-level inline asm should be visible to
 ///   each partition.
+///
+/// If BalanceBySize is true, definitions are packed into the partitions by
+/// their estimated size (largest first, into the least loaded partition)
+/// instead of being distributed by the hash of their names. This keeps the
+/// partitions close in code generation cost when a module contains a few very
+/// large functions.
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals = false);
+    bool PreserveLocals = false, bool BalanceBySize = false);
 
 } // End llvm namespace
 
@@ -14,9 +14,12 @@
 #define LLVM_XRAY_TRACE_H
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/iterator.h"
+#include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/XRay/XRayRecord.h"
@@ -65,6 +68,82 @@ public:
 /// |Filename|.
 Expected<Trace> loadTraceFile(StringRef Filename, bool Sort = false);
 
+/// A TraceStream reads the records of an XRay log file one at a time, in the
+/// order they appear in the file, instead of materializing all of them like a
+/// Trace does. The file is memory mapped and the binary formats are decoded on
+/// demand, so that the memory used doesn't grow with the size of the log. FDR
+/// logs are decoded one thread buffer after the other, skipping the unused
+/// tail of each buffer. YAML logs are still parsed entirely when opened.
+///
+/// Usage:
+///
+///   if (auto StreamOrErr = openTraceFile("xray-log.something.xray")) {
+///     auto &S = *StreamOrErr;
+///     Error Err = Error::success();
+///     for (const XRayRecord &R : S.records(Err)) {
+///       // ... do something with R here.
+///     }
+///     if (Err)
+///       // Handle the error here, R was the last valid record.
+///   }
+///
+class TraceStream {
+public:
+  /// Decodes the records of one of the supported formats.
+  class RecordReader;
+
+  /// An input iterator over the records of a TraceStream. Reaching the end of
+  /// the log or a malformed record both end the iteration; in the latter case
+  /// the error is reported through the Error passed to records().
+  class record_iterator
+      : public iterator_facade_base<record_iterator, std::input_iterator_tag,
+                                    const XRayRecord> {
+    TraceStream *S = nullptr;
+    Error *Err = nullptr;
+    XRayRecord Record;
+
+  public:
+    record_iterator() = default;
+    record_iterator(TraceStream *S, Error *Err) : S(S), Err(Err) { ++*this; }
+
+    const XRayRecord &operator*() const { return Record; }
+    bool operator==(const record_iterator &Other) const {
+      return S == Other.S;
+    }
+    record_iterator &operator++();
+  };
+
+  TraceStream(TraceStream &&Other);
+  TraceStream &operator=(TraceStream &&Other);
+  ~TraceStream();
+
+  /// Provides access to the XRay trace file header.
+  const XRayFileHeader &getFileHeader() const { return FileHeader; }
+
+  /// Returns the records that are still to be read. Iterating over the
+  /// returned range consumes the records, so it can only be done once.
+  iterator_range<record_iterator> records(Error &Err) {
+    return make_range(record_iterator(this, &Err), record_iterator());
+  }
+
+  /// Reads the next record into \p Record. Returns false at the end of the
+  /// log.
+  Expected<bool> readNext(XRayRecord &Record);
+
+private:
+  TraceStream();
+
+  std::unique_ptr<sys::fs::mapped_file_region> MappedFile;
+  XRayFileHeader FileHeader;
+  std::unique_ptr<RecordReader> Reader;
+
+  friend Expected<TraceStream> openTraceFile(StringRef);
+};
+
+/// This function will attempt to open the XRay log file |Filename| for reading
+/// its records one at a time.
+Expected<TraceStream> openTraceFile(StringRef Filename);
+
 } // namespace xray
 } // namespace llvm
 
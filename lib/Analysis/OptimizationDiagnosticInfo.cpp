@@ -16,6 +16,7 @@
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/LazyBlockFrequencyInfo.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Dominators.h"
@@ -169,6 +170,9 @@ void OptimizationRemarkEmitter::emit(
     auto *P = &OptDiagBase;
     *Out << P;
   }
+  if (remarks::Writer *BinaryOut =
+          F->getContext().getDiagnosticsBinaryOutput())
+    BinaryOut->emit(OptDiagBase.getRemark());
   // FIXME: now that IsVerbose is part of DI, filtering for this will be moved
   // from here to clang.
   if (!OptDiag.isVerbose() || shouldEmitVerbose())
@@ -70,6 +70,8 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -92,6 +94,11 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static cl::opt<unsigned> ReaderThreads(
+    "bitcode-reader-threads", cl::init(1), cl::Hidden,
+    cl::desc("Number of threads used to decode function blocks ahead of their "
+             "parsing when materializing a whole module (0 = one per core)"));
+
 namespace {
 
 enum {
@@ -437,6 +444,101 @@ BitcodeReaderBase::readNameFromStrtab(ArrayRef<uint64_t> Record) {
 
 namespace {
 
+/// The entries of a function block, decoded by a worker thread ahead of the
+/// parsing of the function body. The records of the block are decoded, and
+/// its sub-blocks are skipped; BitcodeReader::parseFunctionBody replays the
+/// records and parses the sub-blocks from the stream as usual.
+class DecodedFunctionBlock {
+  struct Entry {
+    decltype(BitstreamEntry::Kind) Kind;
+    /// The record code, or the ID of a sub-block.
+    unsigned ID;
+    /// The position of a sub-block after its ID, or of the end of the block.
+    uint64_t Bit;
+    /// The operands of a record, in Ops.
+    size_t OpsBegin, OpsEnd;
+  };
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Ops;
+  size_t NextEntry = 0;
+  bool Valid = false;
+
+public:
+  /// Signals that the block has been decoded.
+  std::shared_future<void> Ready;
+
+  /// Decodes the function block whose ID ends at \p Bit of \p Stream.
+  void decode(BitstreamCursor Stream, uint64_t Bit);
+
+  /// Returns false if the block is malformed, in which case it should be
+  /// parsed from the stream to diagnose it.
+  bool isValid() const { return Valid; }
+
+  /// Returns the next entry of the block, like BitstreamCursor::advance. If it
+  /// is a sub-block or the end of the block, \p Stream is moved to it.
+  BitstreamEntry advance(BitstreamCursor &Stream);
+
+  /// Reads the record returned by the last call to advance, like
+  /// BitstreamCursor::readRecord.
+  unsigned readRecord(SmallVectorImpl<uint64_t> &Vals) const;
+};
+
+void DecodedFunctionBlock::decode(BitstreamCursor Stream, uint64_t Bit) {
+  Stream.JumpToBit(Bit);
+  if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+    return;
+
+  SmallVector<uint64_t, 64> Record;
+  while (true) {
+    uint64_t EntryBit = Stream.GetCurrentBitNo();
+    BitstreamEntry Entry = Stream.advance();
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return;
+    case BitstreamEntry::EndBlock:
+      Entries.push_back({Entry.Kind, 0, EntryBit, 0, 0});
+      Valid = true;
+      return;
+    case BitstreamEntry::SubBlock:
+      Entries.push_back(
+          {Entry.Kind, Entry.ID, Stream.GetCurrentBitNo(), 0, 0});
+      if (Stream.SkipBlock())
+        return;
+      continue;
+    case BitstreamEntry::Record:
+      Record.clear();
+      unsigned Code = Stream.readRecord(Entry.ID, Record);
+      Entries.push_back(
+          {Entry.Kind, Code, 0, Ops.size(), Ops.size() + Record.size()});
+      Ops.insert(Ops.end(), Record.begin(), Record.end());
+      continue;
+    }
+  }
+}
+
+BitstreamEntry DecodedFunctionBlock::advance(BitstreamCursor &Stream) {
+  assert(NextEntry < Entries.size() && "Read past the end of the block");
+  const Entry &E = Entries[NextEntry++];
+  switch (E.Kind) {
+  case BitstreamEntry::SubBlock:
+    Stream.JumpToBit(E.Bit);
+    return BitstreamEntry::getSubBlock(E.ID);
+  case BitstreamEntry::EndBlock:
+    // Let the stream read the end of the block, and leave it.
+    Stream.JumpToBit(E.Bit);
+    return Stream.advance();
+  default:
+    return BitstreamEntry::getRecord(0);
+  }
+}
+
+unsigned DecodedFunctionBlock::readRecord(SmallVectorImpl<uint64_t> &Vals) const {
+  const Entry &E = Entries[NextEntry - 1];
+  assert(E.Kind == BitstreamEntry::Record && "Expected a record");
+  Vals.append(Ops.begin() + E.OpsBegin, Ops.begin() + E.OpsEnd);
+  return E.ID;
+}
+
 class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   LLVMContext &Context;
   Module *TheModule = nullptr;
@@ -493,6 +595,11 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   /// where to find deferred function body in the stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// When the whole module is materialized with -bitcode-reader-threads, the
+  /// function blocks that are being decoded ahead of their parsing.
+  DenseMap<Function *, std::unique_ptr<DecodedFunctionBlock>>
+      DecodedFunctionBlocks;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -671,6 +778,7 @@ private:
   Error rememberAndSkipMetadata();
   Error typeCheckLoadStoreInst(Type *ValType, Type *PtrType);
   Error parseFunctionBody(Function *F);
+  void decodeFunctionBlockAhead(ThreadPool &Pool, Function *F);
   Error globalCleanup();
   Error resolveGlobalAndIndirectSymbolInits();
   Error parseUseLists();
@@ -3341,11 +3449,22 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
 
   std::vector<OperandBundleDef> OperandBundles;
 
+  // If the block was decoded ahead of time, replay its records.
+  std::unique_ptr<DecodedFunctionBlock> Decoded;
+  auto DFBI = DecodedFunctionBlocks.find(F);
+  if (DFBI != DecodedFunctionBlocks.end()) {
+    DFBI->second->Ready.wait();
+    if (DFBI->second->isValid())
+      Decoded = std::move(DFBI->second);
+    DecodedFunctionBlocks.erase(DFBI);
+  }
+
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
 
   while (true) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry =
+        Decoded ? Decoded->advance(Stream) : Stream.advance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -3393,7 +3512,8 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = nullptr;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = Decoded ? Decoded->readRecord(Record)
+                               : Stream.readRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return error("Invalid value");
@@ -4694,6 +4814,21 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   return materializeForwardReferencedFunctions();
 }
 
+/// Starts decoding the block of \p F on \p Pool. Decoding only reads the
+/// immutable bitcode buffer and block info, so it can run concurrently with the
+/// parsing of other function bodies.
+void BitcodeReader::decodeFunctionBlockAhead(ThreadPool &Pool, Function *F) {
+  auto &Block = DecodedFunctionBlocks[F];
+  Block = llvm::make_unique<DecodedFunctionBlock>();
+  BitstreamCursor Cursor(Stream.getBitcodeBytes());
+  Cursor.setBlockInfo(&BlockInfo);
+  DecodedFunctionBlock *B = Block.get();
+  uint64_t Bit = DeferredFunctionInfo.lookup(F);
+  Block->Ready = Pool.async(
+      [B, Bit](BitstreamCursor &Cursor) { B->decode(std::move(Cursor), Bit); },
+      std::move(Cursor));
+}
+
 Error BitcodeReader::materializeModule() {
   if (Error Err = materializeMetadata())
     return Err;
@@ -4701,12 +4836,38 @@ Error BitcodeReader::materializeModule() {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  // With -bitcode-reader-threads, decode the blocks of the functions whose
+  // position is known on worker threads, a window of functions ahead of the
+  // one being parsed. Only building the IR, which uses the context, has to be
+  // done on this thread.
+  std::vector<Function *> ToDecode;
+  unsigned NumThreads =
+      ReaderThreads ? ReaderThreads : heavyweight_hardware_concurrency();
+  if (NumThreads > 1)
+    for (Function &F : *TheModule)
+      if (F.isMaterializable() && DeferredFunctionInfo.lookup(&F))
+        ToDecode.push_back(&F);
+  Optional<ThreadPool> Decoders;
+  if (ToDecode.size() > 1)
+    Decoders.emplace(NumThreads);
+  size_t NumParsed = 0, NumDecoded = 0;
+  const size_t Window = NumThreads * 16;
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Function &F : *TheModule) {
+    if (Decoders) {
+      if (NumParsed < ToDecode.size() && ToDecode[NumParsed] == &F)
+        ++NumParsed;
+      for (; NumDecoded < std::min(NumParsed + Window, ToDecode.size());
+           ++NumDecoded)
+        decodeFunctionBlockAhead(*Decoders, ToDecode[NumDecoded]);
+    }
     if (Error Err = materialize(&F))
       return Err;
   }
+  Decoders.reset();
+  DecodedFunctionBlocks.clear();
   // At this point, if there are any function bodies, parse the rest of
   // the bits in the module past the last function block we have recorded
   // through either lazy scanning or the VST.
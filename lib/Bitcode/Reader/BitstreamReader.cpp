@@ -182,8 +182,7 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
     unsigned NumElts = ReadVBR(6);
-    for (unsigned i = 0; i != NumElts; ++i)
-      Vals.push_back(ReadVBR64(6));
+    readVBRArray(6, NumElts, Vals);
     return Code;
   }
 
@@ -232,16 +231,13 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
       default:
         report_fatal_error("Array element type can't be an Array or a Blob");
       case BitCodeAbbrevOp::Fixed:
-        for (; NumElts; --NumElts)
-          Vals.push_back(Read((unsigned)EltEnc.getEncodingData()));
+        readFixedArray((unsigned)EltEnc.getEncodingData(), NumElts, Vals);
         break;
       case BitCodeAbbrevOp::VBR:
-        for (; NumElts; --NumElts)
-          Vals.push_back(ReadVBR64((unsigned)EltEnc.getEncodingData()));
+        readVBRArray((unsigned)EltEnc.getEncodingData(), NumElts, Vals);
         break;
       case BitCodeAbbrevOp::Char6:
-        for (; NumElts; --NumElts)
-          Vals.push_back(BitCodeAbbrevOp::DecodeChar6(Read(6)));
+        readChar6Array(NumElts, Vals);
       }
       continue;
     }
@@ -1358,15 +1358,26 @@ Error MetadataLoader::MetadataLoaderImpl::parseOneMetadata(
     if (Record.size() < 14 || Record.size() > 19)
       return error("Invalid record");
 
+    // When lazy-loading for ThinLTO importing, the enums, retained types,
+    // globals and macros are dropped from the imported compile unit by the
+    // IRMover anyway. Don't load these lists and everything they reference:
+    // their elements are only loaded if reached from the imported IR.
+    bool SkipUnitLists = IsImporting && !GlobalMetadataBitPosIndex.empty();
+    auto getUnitListOrNull = [&](unsigned ID) -> Metadata * {
+      if (SkipUnitLists)
+        return nullptr;
+      return getMDOrNull(ID);
+    };
+
     // Ignore Record[0], which indicates whether this compile unit is
     // distinct.  It's always distinct.
     IsDistinct = true;
     auto *CU = DICompileUnit::getDistinct(
         Context, Record[1], getMDOrNull(Record[2]), getMDString(Record[3]),
         Record[4], getMDString(Record[5]), Record[6], getMDString(Record[7]),
-        Record[8], getMDOrNull(Record[9]), getMDOrNull(Record[10]),
-        getMDOrNull(Record[12]), getMDOrNull(Record[13]),
-        Record.size() <= 15 ? nullptr : getMDOrNull(Record[15]),
+        Record[8], getUnitListOrNull(Record[9]), getUnitListOrNull(Record[10]),
+        getUnitListOrNull(Record[12]), getMDOrNull(Record[13]),
+        Record.size() <= 15 ? nullptr : getUnitListOrNull(Record[15]),
         Record.size() <= 14 ? 0 : Record[14],
         Record.size() <= 16 ? true : Record[16],
         Record.size() <= 17 ? false : Record[17],
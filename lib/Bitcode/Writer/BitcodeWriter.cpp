@@ -67,6 +67,8 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -86,6 +88,11 @@ static cl::opt<unsigned>
                    cl::desc("Number of metadatas above which we emit an index "
                             "to enable lazy-loading"));
 
+static cl::opt<unsigned> WriterThreads(
+    "bitcode-writer-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to encode function blocks "
+             "(0 = one per core)"));
+
 namespace {
 
 /// These are manifest constants used by the bitcode writer. They do not need to
@@ -194,6 +201,16 @@ public:
               assignValueId(CallEdge.first.getGUID());
   }
 
+  /// Constructs a ModuleBitcodeWriterBase object that shares the module-level
+  /// state of \p Parent and writes functions to \p Stream, for use by one of
+  /// the tasks that encode function blocks concurrently.
+  ModuleBitcodeWriterBase(const ModuleBitcodeWriterBase &Parent,
+                          BitstreamWriter &Stream,
+                          UseListOrderStack UseListOrders)
+      : BitcodeWriterBase(Stream, Parent.StrtabBuilder), M(Parent.M),
+        VE(Parent.VE, std::move(UseListOrders)), Index(nullptr),
+        GlobalValueId(Parent.GlobalValueId) {}
+
 protected:
   void writePerModuleGlobalValueSummary();
 
@@ -265,6 +282,15 @@ public:
   void write();
 
 private:
+  /// Constructs a ModuleBitcodeWriter object that writes the bodies of some
+  /// of the functions of \p Parent to \p Buffer.
+  ModuleBitcodeWriter(const ModuleBitcodeWriter &Parent,
+                      SmallVectorImpl<char> &Buffer, BitstreamWriter &Stream,
+                      UseListOrderStack UseListOrders)
+      : ModuleBitcodeWriterBase(Parent, Stream, std::move(UseListOrders)),
+        Buffer(Buffer), GenerateHash(false), ModHash(nullptr),
+        BitcodeStartBit(0) {}
+
   uint64_t bitcodeStartBit() { return BitcodeStartBit; }
 
   size_t addToStrtab(StringRef Str);
@@ -375,6 +401,8 @@ private:
   void
   writeFunction(const Function &F,
                 DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void
+  writeFunctions(DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
   void writeBlockInfo();
   void writeModuleHash(size_t BlockStartPos);
 
@@ -3046,6 +3074,77 @@ void ModuleBitcodeWriter::writeFunction(
   Stream.ExitBlock();
 }
 
+/// Emit the bodies of the defined functions to the module stream, in module
+/// order. The function blocks only depend on the module-level state of the
+/// writer, so with -bitcode-writer-threads they are encoded concurrently into
+/// separate buffers, each task using its own copy of the ValueEnumerator, and
+/// then copied into the module stream. The output is the same either way.
+void ModuleBitcodeWriter::writeFunctions(
+    DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex) {
+  std::vector<const Function *> Functions;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+
+  unsigned NumTasks =
+      WriterThreads ? WriterThreads : heavyweight_hardware_concurrency();
+  NumTasks = std::min<size_t>(NumTasks, Functions.size());
+  if (NumTasks <= 1) {
+    for (const Function *F : Functions)
+      writeFunction(*F, FunctionToBitcodeIndex);
+    return;
+  }
+
+  // Each task writes a contiguous range of the functions, and takes the
+  // use-list orders of these functions. The orders are stacked so that those
+  // of the first function are at the back.
+  std::vector<size_t> TaskBegin;
+  std::vector<UseListOrderStack> TaskUseListOrders(NumTasks);
+  DenseMap<const Function *, unsigned> FunctionTask;
+  for (unsigned T = 0; T != NumTasks; ++T) {
+    TaskBegin.push_back(Functions.size() * T / NumTasks);
+    size_t End = Functions.size() * (T + 1) / NumTasks;
+    for (size_t I = TaskBegin.back(); I != End; ++I)
+      FunctionTask[Functions[I]] = T;
+  }
+  TaskBegin.push_back(Functions.size());
+  for (UseListOrder &Order : VE.UseListOrders)
+    TaskUseListOrders[FunctionTask.lookup(Order.F)].push_back(
+        std::move(Order));
+  VE.UseListOrders.clear();
+
+  // The blocks of the functions of each task, and the offset of the block of
+  // each function in the buffer of its task.
+  std::vector<SmallVector<char, 0>> TaskBuffers(NumTasks);
+  std::vector<size_t> BlockOffsets(Functions.size() + NumTasks);
+  {
+    ThreadPool Pool(NumTasks);
+    for (unsigned T = 0; T != NumTasks; ++T)
+      Pool.async([&](unsigned T) {
+        SmallVector<char, 0> &Buffer = TaskBuffers[T];
+        BitstreamWriter FnStream(Buffer);
+        FnStream.copyBlockInfo(Stream);
+        ModuleBitcodeWriter FnWriter(*this, Buffer, FnStream,
+                                     std::move(TaskUseListOrders[T]));
+        DenseMap<const Function *, uint64_t> Unused;
+        for (size_t I = TaskBegin[T]; I != TaskBegin[T + 1]; ++I) {
+          BlockOffsets[I + T] = Buffer.size();
+          FnWriter.writeFunction(*Functions[I], Unused);
+        }
+        BlockOffsets[TaskBegin[T + 1] + T] = Buffer.size();
+      }, T);
+  }
+
+  for (unsigned T = 0; T != NumTasks; ++T)
+    for (size_t I = TaskBegin[T]; I != TaskBegin[T + 1]; ++I) {
+      FunctionToBitcodeIndex[Functions[I]] = Stream.GetCurrentBitNo();
+      Stream.emitEncodedBlock(
+          makeArrayRef(TaskBuffers[T])
+              .slice(BlockOffsets[I + T],
+                     BlockOffsets[I + T + 1] - BlockOffsets[I + T]));
+    }
+}
+
 // Emit blockinfo, which defines the standard abbreviations etc.
 void ModuleBitcodeWriter::writeBlockInfo() {
   // We only want to emit block info records for blocks that have multiple
@@ -3824,9 +3923,7 @@ void ModuleBitcodeWriter::write() {
 
   // Emit function bodies.
   DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
-  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
-    if (!F->isDeclaration())
-      writeFunction(*F, FunctionToBitcodeIndex);
+  writeFunctions(FunctionToBitcodeIndex);
 
   // Need to write after the above call to WriteFunction which populates
   // the summary information in the index.
@@ -440,6 +440,22 @@ ValueEnumerator::ValueEnumerator(const Module &M,
   organizeMetadata();
 }
 
+ValueEnumerator::ValueEnumerator(const ValueEnumerator &VE,
+                                 UseListOrderStack UseListOrders)
+    : UseListOrders(std::move(UseListOrders)), TypeMap(VE.TypeMap),
+      Types(VE.Types), ValueMap(VE.ValueMap), Values(VE.Values),
+      Comdats(VE.Comdats), MDs(VE.MDs), FunctionMDs(VE.FunctionMDs),
+      MetadataMap(VE.MetadataMap), FunctionMDInfo(VE.FunctionMDInfo),
+      ShouldPreserveUseListOrder(VE.ShouldPreserveUseListOrder),
+      AttributeGroupMap(VE.AttributeGroupMap),
+      AttributeGroups(VE.AttributeGroups),
+      AttributeListMap(VE.AttributeListMap),
+      AttributeLists(VE.AttributeLists), InstructionCount(0),
+      NumModuleValues(VE.NumModuleValues), NumModuleMDs(VE.NumModuleMDs),
+      NumMDStrings(VE.NumMDStrings) {
+  assert(VE.BasicBlocks.empty() && "Expected no incorporated function");
+}
+
 unsigned ValueEnumerator::getInstructionID(const Instruction *Inst) const {
   InstructionMapType::const_iterator I = InstructionMap.find(Inst);
   assert(I != InstructionMap.end() && "Instruction is not mapped!");
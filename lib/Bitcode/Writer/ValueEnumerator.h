@@ -139,6 +139,12 @@ private:
 
 public:
   ValueEnumerator(const Module &M, bool ShouldPreserveUseListOrder);
+
+  /// Creates a copy of the module-level state of \p VE, which must not have
+  /// a function incorporated, so that functions can be incorporated into
+  /// several enumerators concurrently. The copy takes the use-list orders of
+  /// the functions it is going to write, \p UseListOrders.
+  ValueEnumerator(const ValueEnumerator &VE, UseListOrderStack UseListOrders);
   ValueEnumerator(const ValueEnumerator &) = delete;
   ValueEnumerator &operator=(const ValueEnumerator &) = delete;
 
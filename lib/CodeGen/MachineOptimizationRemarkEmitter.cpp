@@ -16,6 +16,7 @@
 #include "llvm/CodeGen/MachineOptimizationRemarkEmitter.h"
 #include "llvm/CodeGen/LazyMachineBlockFrequencyInfo.h"
 #include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/LLVMContext.h"
@@ -65,6 +66,8 @@ void MachineOptimizationRemarkEmitter::emit(
     auto *P = &const_cast<DiagnosticInfoOptimizationBase &>(OptDiagCommon);
     *Out << P;
   }
+  if (remarks::Writer *BinaryOut = Ctx.getDiagnosticsBinaryOutput())
+    BinaryOut->emit(OptDiagCommon.getRemark());
   // FIXME: now that IsVerbose is part of DI, filtering for this will be moved
   // from here to clang.
   if (!OptDiag.isVerbose() || shouldEmitVerbose())
@@ -40,7 +40,8 @@ std::unique_ptr<Module> llvm::splitCodeGen(
     std::unique_ptr<Module> M, ArrayRef<llvm::raw_pwrite_stream *> OSs,
     ArrayRef<llvm::raw_pwrite_stream *> BCOSs,
     const std::function<std::unique_ptr<TargetMachine>()> &TMFactory,
-    TargetMachine::CodeGenFileType FileType, bool PreserveLocals) {
+    TargetMachine::CodeGenFileType FileType, bool PreserveLocals,
+    bool BalanceBySize) {
   assert(BCOSs.empty() || BCOSs.size() == OSs.size());
 
   if (OSs.size() == 1) {
@@ -93,7 +94,7 @@ std::unique_ptr<Module> llvm::splitCodeGen(
               // copied into the thread's context.
               std::move(BC));
         },
-        PreserveLocals);
+        PreserveLocals, BalanceBySize);
   }
 
   return {};
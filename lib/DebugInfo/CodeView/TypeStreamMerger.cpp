@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/DebugInfo/CodeView/TypeStreamMerger.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/DebugInfo/CodeView/TypeDeserializer.h"
@@ -15,8 +16,18 @@
 #include "llvm/DebugInfo/CodeView/TypeIndexDiscovery.h"
 #include "llvm/DebugInfo/CodeView/TypeRecord.h"
 #include "llvm/DebugInfo/CodeView/TypeTableBuilder.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/ScopedPrinter.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 using namespace llvm;
 using namespace llvm::codeview;
@@ -55,10 +66,19 @@ namespace {
 /// streams: an item (or IPI) stream and a type stream, as this is what is
 /// actually stored in the final PDB. We choose which records go where by
 /// looking at the record kind.
+///
+/// When several streams are merged at once, the duplicate records may already
+/// be known. They are then mapped to the destination index of their first copy
+/// without being re-written.
 class TypeStreamMerger {
 public:
-  explicit TypeStreamMerger(SmallVectorImpl<TypeIndex> &SourceToDest)
-      : IndexMap(SourceToDest) {
+  /// Returns the destination index of the first copy of the record with the
+  /// given source index, or None if the record is the first copy.
+  using DuplicateFinder = function_ref<Optional<TypeIndex>(uint32_t)>;
+
+  explicit TypeStreamMerger(SmallVectorImpl<TypeIndex> &SourceToDest,
+                            DuplicateFinder FindDuplicate = DuplicateFinder())
+      : FindDuplicate(FindDuplicate), IndexMap(SourceToDest) {
     SourceToDest.clear();
   }
 
@@ -120,6 +140,8 @@ private:
   // type records.
   ArrayRef<TypeIndex> TypeLookup;
 
+  DuplicateFinder FindDuplicate;
+
   /// Map from source type index to destination type index. Indexed by source
   /// type index minus 0x1000.
   SmallVectorImpl<TypeIndex> &IndexMap;
@@ -261,9 +283,17 @@ Error TypeStreamMerger::doit(const CVTypeArray &Types) {
 }
 
 Error TypeStreamMerger::remapAllTypes(const CVTypeArray &Types) {
-  for (const CVType &Type : Types)
+  for (const CVType &Type : Types) {
+    if (FindDuplicate) {
+      if (Optional<TypeIndex> Idx = FindDuplicate(slotForIndex(CurIndex))) {
+        addMapping(*Idx);
+        ++CurIndex;
+        continue;
+      }
+    }
     if (auto EC = remapType(Type))
       return EC;
+  }
   return Error::success();
 }
 
@@ -306,6 +336,240 @@ bool TypeStreamMerger::remapIndices(RemappedType &Record,
   return Success;
 }
 
+namespace {
+
+/// A hash of a type record that doesn't depend on the type indices of its
+/// stream: every type index the record refers to is replaced by the hash of
+/// the referenced record. Two records have the same hash when they are
+/// identical once merged into one stream, whichever streams they come from.
+struct GlobalTypeHash {
+  std::array<uint8_t, 20> Hash;
+
+  uint64_t getProbe() const { return support::endian::read64le(Hash.data()); }
+
+  bool operator==(const GlobalTypeHash &Other) const {
+    return Hash == Other.Hash;
+  }
+};
+
+/// Implementation of the parallel merging of several type streams.
+///
+/// - Hash the records of every stream, one stream per task.
+/// - Insert every record into a lock free hash table keyed by its hash, which
+///   keeps the location (stream and record index) of the first copy of the
+///   record in stream order.
+/// - Look up the first copy of every record, one stream per task.
+/// - Merge the streams in order with TypeStreamMerger, which only re-writes
+///   the first copies and maps the other records to them.
+class ParallelTypeStreamMerger {
+public:
+  using StreamMerger =
+      function_ref<Error(size_t, TypeStreamMerger::DuplicateFinder)>;
+
+  ParallelTypeStreamMerger(
+      ArrayRef<CVTypeArray> Streams,
+      ArrayRef<SmallVector<TypeIndex, 0>> TypeLookups,
+      MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+      unsigned Threads)
+      : Streams(Streams), TypeLookups(TypeLookups),
+        SourceToDest(SourceToDest),
+        Threads(Threads ? Threads : heavyweight_hardware_concurrency()) {
+    assert(SourceToDest.size() == Streams.size() &&
+           "need one index map per stream");
+    assert((TypeLookups.empty() || TypeLookups.size() == Streams.size()) &&
+           "need one type index map per id stream");
+  }
+
+  /// Merges every stream with \p MergeStream, in order.
+  Error merge(StreamMerger MergeStream);
+
+private:
+  bool hashStream(size_t Stream);
+
+  void insert(uint64_t Loc);
+  uint64_t find(uint64_t Loc) const;
+
+  static uint64_t makeLoc(size_t Stream, uint32_t Record) {
+    return uint64_t(Stream) << 32 | Record;
+  }
+
+  const GlobalTypeHash &hashAt(uint64_t Loc) const {
+    return Hashes[Loc >> 32][uint32_t(Loc)];
+  }
+
+  ArrayRef<CVTypeArray> Streams;
+  ArrayRef<SmallVector<TypeIndex, 0>> TypeLookups;
+  MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest;
+  unsigned Threads;
+
+  std::vector<std::vector<GlobalTypeHash>> Hashes;
+
+  /// The location of the first copy of every record of every stream.
+  std::vector<std::vector<uint64_t>> FirstCopies;
+
+  /// Open addressing hash table of the first copy of every record. A cell
+  /// holds the location of the record plus one, or zero if it is empty.
+  std::unique_ptr<std::atomic<uint64_t>[]> Cells;
+  uint64_t Mask = 0;
+};
+
+} // end anonymous namespace
+
+/// Computes the global hashes of the records of a stream. Returns false if a
+/// record refers to a type index that isn't that of a prior record, in which
+/// case the stream has to be merged the slow way.
+bool ParallelTypeStreamMerger::hashStream(size_t Stream) {
+  std::vector<GlobalTypeHash> &StreamHashes = Hashes[Stream];
+  ArrayRef<TypeIndex> TypeLookup;
+  if (!TypeLookups.empty())
+    TypeLookup = TypeLookups[Stream];
+
+  // Each index is tagged so that an index and a hash can't be confused.
+  static const uint8_t IndexTag = 0;
+  static const uint8_t HashTag = 1;
+  SHA1 Hasher;
+  auto HashIndex = [&Hasher](TypeIndex TI) {
+    Hasher.update(makeArrayRef(IndexTag));
+    Hasher.update(makeArrayRef(reinterpret_cast<const uint8_t *>(&TI),
+                               sizeof(TypeIndex)));
+  };
+
+  SmallVector<TiReference, 32> Refs;
+  for (const CVType &Type : Streams[Stream]) {
+    Refs.clear();
+    discoverTypeIndices(Type.RecordData, Refs);
+    ArrayRef<uint8_t> Content = Type.content();
+
+    Hasher.init();
+    Hasher.update(Type.RecordData.take_front(sizeof(RecordPrefix)));
+    uint32_t Offset = 0;
+    for (const TiReference &Ref : Refs) {
+      uint32_t End = Ref.Offset + Ref.Count * sizeof(TypeIndex);
+      if (Ref.Offset < Offset || End > Content.size())
+        return false;
+      Hasher.update(Content.slice(Offset, Ref.Offset - Offset));
+
+      ArrayRef<TypeIndex> TIs(
+          reinterpret_cast<const TypeIndex *>(Content.data() + Ref.Offset),
+          Ref.Count);
+      for (TypeIndex TI : TIs) {
+        if (TI.isSimple()) {
+          HashIndex(TI);
+          continue;
+        }
+        uint32_t Slot = TI.toArrayIndex();
+        if (Ref.Kind == TiRefKind::TypeRef && !TypeLookups.empty()) {
+          // The types an id stream refers to are already merged, so their
+          // destination index identifies them.
+          if (Slot >= TypeLookup.size() ||
+              TypeLookup[Slot] == TypeStreamMerger::Untranslated)
+            return false;
+          HashIndex(TypeLookup[Slot]);
+          continue;
+        }
+        if (Slot >= StreamHashes.size())
+          return false;
+        Hasher.update(makeArrayRef(HashTag));
+        Hasher.update(StreamHashes[Slot].Hash);
+      }
+      Offset = End;
+    }
+    Hasher.update(Content.drop_front(Offset));
+
+    StreamHashes.emplace_back();
+    StringRef Hash = Hasher.final();
+    memcpy(StreamHashes.back().Hash.data(), Hash.data(), Hash.size());
+  }
+  return true;
+}
+
+void ParallelTypeStreamMerger::insert(uint64_t Loc) {
+  const GlobalTypeHash &Hash = hashAt(Loc);
+  uint64_t NewCell = Loc + 1;
+  for (uint64_t Slot = Hash.getProbe() & Mask;; Slot = (Slot + 1) & Mask) {
+    uint64_t Cell = Cells[Slot].load();
+    if (Cell == 0) {
+      if (Cells[Slot].compare_exchange_strong(Cell, NewCell))
+        return;
+      // Another copy of this record, or another record that collides with
+      // it, took the cell first.
+    }
+    if (hashAt(Cell - 1) == Hash) {
+      // Keep the copy that comes first in stream order.
+      while (NewCell < Cell &&
+             !Cells[Slot].compare_exchange_weak(Cell, NewCell))
+        ;
+      return;
+    }
+  }
+}
+
+uint64_t ParallelTypeStreamMerger::find(uint64_t Loc) const {
+  const GlobalTypeHash &Hash = hashAt(Loc);
+  for (uint64_t Slot = Hash.getProbe() & Mask;; Slot = (Slot + 1) & Mask) {
+    uint64_t Cell = Cells[Slot].load(std::memory_order_relaxed);
+    assert(Cell && "record was not inserted");
+    if (hashAt(Cell - 1) == Hash)
+      return Cell - 1;
+  }
+}
+
+Error ParallelTypeStreamMerger::merge(StreamMerger MergeStream) {
+  ThreadPool Pool(Threads);
+
+  Hashes.resize(Streams.size());
+  std::vector<char> Hashed(Streams.size());
+  for (size_t I = 0, E = Streams.size(); I != E; ++I)
+    Pool.async([this, &Hashed, I] { Hashed[I] = hashStream(I); });
+  Pool.wait();
+
+  if (!all_of(Hashed, [](char H) { return H; })) {
+    for (size_t I = 0, E = Streams.size(); I != E; ++I)
+      if (auto EC = MergeStream(I, TypeStreamMerger::DuplicateFinder()))
+        return EC;
+    return Error::success();
+  }
+
+  size_t NumRecords = 0;
+  for (const std::vector<GlobalTypeHash> &StreamHashes : Hashes)
+    NumRecords += StreamHashes.size();
+  uint64_t Capacity = PowerOf2Ceil(std::max<uint64_t>(2 * NumRecords, 16));
+  Mask = Capacity - 1;
+  Cells.reset(new std::atomic<uint64_t>[Capacity]);
+  for (uint64_t I = 0; I != Capacity; ++I)
+    Cells[I].store(0, std::memory_order_relaxed);
+
+  for (size_t I = 0, E = Streams.size(); I != E; ++I)
+    Pool.async([this, I] {
+      for (uint32_t R = 0, RE = Hashes[I].size(); R != RE; ++R)
+        insert(makeLoc(I, R));
+    });
+  Pool.wait();
+
+  FirstCopies.resize(Streams.size());
+  for (size_t I = 0, E = Streams.size(); I != E; ++I)
+    Pool.async([this, I] {
+      FirstCopies[I].resize(Hashes[I].size());
+      for (uint32_t R = 0, RE = Hashes[I].size(); R != RE; ++R)
+        FirstCopies[I][R] = find(makeLoc(I, R));
+    });
+  Pool.wait();
+
+  // The first copy of a record is in an earlier stream, or earlier in the same
+  // stream, so its destination index is known by the time it is needed.
+  for (size_t I = 0, E = Streams.size(); I != E; ++I) {
+    auto FindDuplicate = [this, I](uint32_t R) -> Optional<TypeIndex> {
+      uint64_t First = FirstCopies[I][R];
+      if (First == makeLoc(I, R))
+        return None;
+      return SourceToDest[First >> 32][uint32_t(First)];
+    };
+    if (auto EC = MergeStream(I, FindDuplicate))
+      return EC;
+  }
+  return Error::success();
+}
+
 Error llvm::codeview::mergeTypeRecords(TypeTableBuilder &Dest,
                                        SmallVectorImpl<TypeIndex> &SourceToDest,
                                        const CVTypeArray &Types) {
@@ -327,3 +591,39 @@ Error llvm::codeview::mergeTypeAndIdRecords(
   TypeStreamMerger M(SourceToDest);
   return M.mergeTypesAndIds(DestIds, DestTypes, IdsAndTypes);
 }
+
+Error llvm::codeview::mergeTypeRecords(
+    TypeTableBuilder &Dest,
+    MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+    ArrayRef<CVTypeArray> Types, unsigned Threads) {
+  ParallelTypeStreamMerger PM(Types, None, SourceToDest, Threads);
+  return PM.merge(
+      [&](size_t I, TypeStreamMerger::DuplicateFinder FindDuplicate) {
+        TypeStreamMerger M(SourceToDest[I], FindDuplicate);
+        return M.mergeTypeRecords(Dest, Types[I]);
+      });
+}
+
+Error llvm::codeview::mergeIdRecords(
+    TypeTableBuilder &Dest, ArrayRef<SmallVector<TypeIndex, 0>> Types,
+    MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+    ArrayRef<CVTypeArray> Ids, unsigned Threads) {
+  ParallelTypeStreamMerger PM(Ids, Types, SourceToDest, Threads);
+  return PM.merge(
+      [&](size_t I, TypeStreamMerger::DuplicateFinder FindDuplicate) {
+        TypeStreamMerger M(SourceToDest[I], FindDuplicate);
+        return M.mergeIdRecords(Dest, Types[I], Ids[I]);
+      });
+}
+
+Error llvm::codeview::mergeTypeAndIdRecords(
+    TypeTableBuilder &DestIds, TypeTableBuilder &DestTypes,
+    MutableArrayRef<SmallVector<TypeIndex, 0>> SourceToDest,
+    ArrayRef<CVTypeArray> IdsAndTypes, unsigned Threads) {
+  ParallelTypeStreamMerger PM(IdsAndTypes, None, SourceToDest, Threads);
+  return PM.merge(
+      [&](size_t I, TypeStreamMerger::DuplicateFinder FindDuplicate) {
+        TypeStreamMerger M(SourceToDest[I], FindDuplicate);
+        return M.mergeTypesAndIds(DestIds, DestTypes, IdsAndTypes[I]);
+      });
+}
@@ -483,9 +483,10 @@ DWARFDie DWARFContext::getDIEForOffset(uint32_t Offset) {
   return DWARFDie();
 }
 
-bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts) {
+bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts,
+                          unsigned NumThreads) {
   bool Success = true;
-  DWARFVerifier verifier(OS, *this, DumpOpts);
+  DWARFVerifier verifier(OS, *this, DumpOpts, NumThreads);
 
   Success &= verifier.handleDebugAbbrev();
   if (DumpOpts.DumpType & DIDT_DebugInfo)
@@ -685,6 +686,54 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
   return Line->getOrParseLineTable(lineData, stmtOffset);
 }
 
+const DWARFLineTable *DWARFContext::getLineTableIndexForUnit(DWARFUnit *U) {
+  if (!Line)
+    Line.reset(new DWARFDebugLine);
+
+  auto UnitDIE = U->getUnitDIE();
+  if (!UnitDIE)
+    return nullptr;
+
+  auto Offset = toSectionOffset(UnitDIE.find(DW_AT_stmt_list));
+  if (!Offset)
+    return nullptr; // No line table for this compile unit.
+
+  uint32_t stmtOffset = *Offset + U->getLineTableOffset();
+  // Make sure the offset is good before we try to parse.
+  if (stmtOffset >= U->getLineSection().Data.size())
+    return nullptr;
+
+  DWARFDataExtractor lineData(*DObj, U->getLineSection(), isLittleEndian(),
+                              U->getAddressByteSize());
+  return Line->getOrParseSequenceIndex(lineData, stmtOffset);
+}
+
+bool DWARFContext::getFileLineInfoForAddress(DWARFUnit *U,
+                                             const DWARFLineTable &LineTable,
+                                             uint64_t Address,
+                                             FileLineInfoKind Kind,
+                                             DILineInfo &Result) {
+  DWARFDataExtractor lineData(*DObj, U->getLineSection(), isLittleEndian(),
+                              U->getAddressByteSize());
+  return Line->getFileLineInfoForAddress(lineData, LineTable, Address,
+                                         U->getCompilationDir(), Kind, Result);
+}
+
+bool DWARFContext::getRowRangeForAddress(DWARFUnit *U,
+                                         const DWARFLineTable &LineTable,
+                                         uint64_t Address, uint64_t &Begin,
+                                         uint64_t &End) {
+  DWARFDataExtractor lineData(*DObj, U->getLineSection(), isLittleEndian(),
+                              U->getAddressByteSize());
+  return Line->getRowRangeForAddress(lineData, LineTable, Address, Begin, End);
+}
+
+void DWARFContext::setMaxCachedLineTableRows(size_t MaxRows) {
+  if (!Line)
+    Line.reset(new DWARFDebugLine);
+  Line->setMaxCachedSequenceRows(MaxRows);
+}
+
 void DWARFContext::parseCompileUnits() {
   CUs.parse(*this, DObj->getInfoSection());
 }
@@ -762,9 +811,8 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
                                         Result.FunctionName,
                                         Result.StartLine);
   if (Spec.FLIKind != FileLineInfoKind::None) {
-    if (const DWARFLineTable *LineTable = getLineTableForUnit(CU))
-      LineTable->getFileLineInfoForAddress(Address, CU->getCompilationDir(),
-                                           Spec.FLIKind, Result);
+    if (const DWARFLineTable *LineTable = getLineTableIndexForUnit(CU))
+      getFileLineInfoForAddress(CU, *LineTable, Address, Spec.FLIKind, Result);
   }
   return Result;
 }
@@ -832,10 +880,9 @@ DWARFContext::getInliningInfoForAddress(uint64_t Address,
     // try to at least get file/line info from symbol table.
     if (Spec.FLIKind != FileLineInfoKind::None) {
       DILineInfo Frame;
-      LineTable = getLineTableForUnit(CU);
-      if (LineTable &&
-          LineTable->getFileLineInfoForAddress(Address, CU->getCompilationDir(),
-                                               Spec.FLIKind, Frame))
+      LineTable = getLineTableIndexForUnit(CU);
+      if (LineTable && getFileLineInfoForAddress(CU, *LineTable, Address,
+                                                 Spec.FLIKind, Frame))
         InliningInfo.addFrame(Frame);
     }
     return InliningInfo;
@@ -854,11 +901,11 @@ DWARFContext::getInliningInfoForAddress(uint64_t Address,
       if (i == 0) {
         // For the topmost frame, initialize the line table of this
         // compile unit and fetch file/line info from it.
-        LineTable = getLineTableForUnit(CU);
+        LineTable = getLineTableIndexForUnit(CU);
         // For the topmost routine, get file/line info from line table.
         if (LineTable)
-          LineTable->getFileLineInfoForAddress(Address, CU->getCompilationDir(),
-                                               Spec.FLIKind, Frame);
+          getFileLineInfoForAddress(CU, *LineTable, Address, Spec.FLIKind,
+                                    Frame);
       } else {
         // Otherwise, use call file, call line and call column from
         // previous DIE in inlined chain.
@@ -880,6 +927,24 @@ DWARFContext::getInliningInfoForAddress(uint64_t Address,
   return InliningInfo;
 }
 
+DWARFAddressRange DWARFContext::getLineInfoRangeForAddress(uint64_t Address) {
+  DWARFAddressRange Range(Address, Address + 1);
+  DWARFCompileUnit *CU = getCompileUnitForAddress(Address);
+  if (!CU)
+    return Range;
+  const DWARFLineTable *LineTable = getLineTableIndexForUnit(CU);
+  uint64_t Begin, End;
+  if (!LineTable || !getRowRangeForAddress(CU, *LineTable, Address, Begin, End))
+    return Range;
+  // The function names, declaration lines and call sites of the frames come
+  // from the inlined chain.
+  std::pair<uint64_t, uint64_t> ChainRange =
+      CU->getInlinedChainRangeForAddress(Address);
+  Range.LowPC = std::max(Begin, ChainRange.first);
+  Range.HighPC = std::min(End, ChainRange.second);
+  return Range;
+}
+
 std::shared_ptr<DWARFContext>
 DWARFContext::getDWOContext(StringRef AbsolutePath) {
   if (auto S = DWP.lock()) {
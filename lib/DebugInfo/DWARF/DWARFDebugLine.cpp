@@ -319,6 +319,8 @@ void DWARFDebugLine::Sequence::reset() {
   HighPC = 0;
   FirstRowIndex = 0;
   LastRowIndex = 0;
+  ProgramOffset = 0;
+  ProgramEndOffset = 0;
   Empty = true;
 }
 
@@ -360,12 +362,14 @@ void DWARFDebugLine::ParsingState::appendRowToMatrix(uint32_t Offset) {
     Sequence.FirstRowIndex = RowNumber;
   }
   ++RowNumber;
-  LineTable->appendRow(Row);
+  if (KeepRows)
+    LineTable->appendRow(Row);
   if (Row.EndSequence) {
     // Record the end of instruction sequence.
     Sequence.HighPC = Row.Address;
     Sequence.LastRowIndex = RowNumber;
-    if (Sequence.isValid())
+    Sequence.ProgramEndOffset = Offset;
+    if (KeepSequences && Sequence.isValid())
       LineTable->appendSequence(Sequence);
     Sequence.reset();
   }
@@ -393,8 +397,139 @@ DWARFDebugLine::getOrParseLineTable(const DWARFDataExtractor &DebugLineData,
   return LT;
 }
 
+const DWARFDebugLine::LineTable *DWARFDebugLine::getOrParseSequenceIndex(
+    const DWARFDataExtractor &DebugLineData, uint32_t Offset) {
+  if (const LineTable *LT = getLineTable(Offset))
+    return LT;
+  std::pair<LineTableIter, bool> Pos =
+      SequenceIndexMap.insert(LineTableMapTy::value_type(Offset, LineTable()));
+  LineTable *LT = &Pos.first->second;
+  if (Pos.second) {
+    if (!LT->parseSequenceIndex(DebugLineData, &Offset))
+      return nullptr;
+  }
+  return LT;
+}
+
+const DWARFDebugLine::LineTable::RowVector &
+DWARFDebugLine::getOrParseSequenceRows(const DWARFDataExtractor &DebugLineData,
+                                       const LineTable &LT,
+                                       const Sequence &Seq) {
+  CachedSequenceKey Key(&LT, &Seq);
+  auto I = CachedSequenceMap.find(Key);
+  if (I != CachedSequenceMap.end()) {
+    // Move the sequence to the front of the list.
+    CachedSequences.splice(CachedSequences.begin(), CachedSequences,
+                           I->second);
+  } else {
+    LineTable::RowVector SeqRows;
+    LT.parseSequenceRows(DebugLineData, Seq, SeqRows);
+    NumCachedRows += SeqRows.size();
+    CachedSequences.emplace_front(Key, std::move(SeqRows));
+    CachedSequenceMap[Key] = CachedSequences.begin();
+    // Evict the least recently used sequences, but always keep this one.
+    while (NumCachedRows > MaxCachedRows && CachedSequences.size() > 1) {
+      NumCachedRows -= CachedSequences.back().second.size();
+      CachedSequenceMap.erase(CachedSequences.back().first);
+      CachedSequences.pop_back();
+    }
+  }
+  return CachedSequences.front().second;
+}
+
+bool DWARFDebugLine::getFileLineInfoForAddress(
+    const DWARFDataExtractor &DebugLineData, const LineTable &LT,
+    uint64_t Address, const char *CompDir, FileLineInfoKind Kind,
+    DILineInfo &Result) {
+  if (!LT.Rows.empty())
+    return LT.getFileLineInfoForAddress(Address, CompDir, Kind, Result);
+
+  const Sequence *Seq = LT.findSequence(Address);
+  if (!Seq)
+    return false;
+
+  const LineTable::RowVector &SeqRows =
+      getOrParseSequenceRows(DebugLineData, LT, *Seq);
+  uint32_t RowIndex = LT.findRowInSequenceRows(SeqRows, Address);
+  if (RowIndex == LT.UnknownRowIndex)
+    return false;
+  return LT.getFileLineInfoForRow(SeqRows[RowIndex], CompDir, Kind, Result);
+}
+
+bool DWARFDebugLine::getRowRangeForAddress(
+    const DWARFDataExtractor &DebugLineData, const LineTable &LT,
+    uint64_t Address, uint64_t &Begin, uint64_t &End) {
+  ArrayRef<Row> Rows;
+  uint32_t RowIndex;
+  if (!LT.Rows.empty()) {
+    Rows = LT.Rows;
+    RowIndex = LT.lookupAddress(Address);
+  } else {
+    const Sequence *Seq = LT.findSequence(Address);
+    if (!Seq)
+      return false;
+    Rows = getOrParseSequenceRows(DebugLineData, LT, *Seq);
+    RowIndex = LT.findRowInSequenceRows(Rows, Address);
+  }
+  if (RowIndex == LT.UnknownRowIndex)
+    return false;
+  // The range ends at the first following row with a greater address. The
+  // end_sequence row always stops the scan within the sequence of Address.
+  uint32_t NextIndex = RowIndex + 1;
+  while (NextIndex < Rows.size() && Rows[NextIndex].Address <= Address)
+    ++NextIndex;
+  if (NextIndex >= Rows.size())
+    return false;
+  Begin = Rows[RowIndex].Address;
+  End = Rows[NextIndex].Address;
+  // When several rows share an address, a lookup of exactly that address
+  // finds the first of them and a lookup past it finds the last, so the two
+  // get separate ranges.
+  if (NextIndex > RowIndex + 1)
+    End = Address + 1;
+  else if (RowIndex > 0 && Rows[RowIndex - 1].Address == Begin)
+    Begin = Begin + 1;
+  return true;
+}
+
+void DWARFDebugLine::setMaxCachedSequenceRows(size_t MaxRows) {
+  MaxCachedRows = MaxRows;
+  while (NumCachedRows > MaxCachedRows && !CachedSequences.empty()) {
+    NumCachedRows -= CachedSequences.back().second.size();
+    CachedSequenceMap.erase(CachedSequences.back().first);
+    CachedSequences.pop_back();
+  }
+}
+
 bool DWARFDebugLine::LineTable::parse(const DWARFDataExtractor &DebugLineData,
                                       uint32_t *OffsetPtr, raw_ostream *OS) {
+  return parseImpl(DebugLineData, OffsetPtr, OS, /*KeepRows=*/true);
+}
+
+bool DWARFDebugLine::LineTable::parseSequenceIndex(
+    const DWARFDataExtractor &DebugLineData, uint32_t *OffsetPtr) {
+  return parseImpl(DebugLineData, OffsetPtr, nullptr, /*KeepRows=*/false);
+}
+
+void DWARFDebugLine::LineTable::parseSequenceRows(
+    const DWARFDataExtractor &DebugLineData, const Sequence &Seq,
+    RowVector &Result) const {
+  // Every sequence starts from the initial state of the registers, so its
+  // opcodes can be run on their own. They are run against a copy of the
+  // prologue, as they may define files that the index already holds.
+  LineTable Scratch;
+  Scratch.Prologue = Prologue;
+  ParsingState State(&Scratch);
+  State.KeepSequences = false;
+  uint32_t Offset = Seq.ProgramOffset;
+  Scratch.parseProgram(DebugLineData, &Offset, Seq.ProgramEndOffset, State,
+                       nullptr);
+  Result = std::move(Scratch.Rows);
+}
+
+bool DWARFDebugLine::LineTable::parseImpl(
+    const DWARFDataExtractor &DebugLineData, uint32_t *OffsetPtr,
+    raw_ostream *OS, bool KeepRows) {
   const uint32_t DebugLineOffset = *OffsetPtr;
 
   clear();
@@ -412,7 +547,32 @@ bool DWARFDebugLine::LineTable::parse(const DWARFDataExtractor &DebugLineData,
       DebugLineOffset + Prologue.TotalLength + Prologue.sizeofTotalLength();
 
   ParsingState State(this);
+  State.KeepRows = KeepRows;
+  parseProgram(DebugLineData, OffsetPtr, EndOffset, State, OS);
 
+  if (!State.Sequence.Empty) {
+    fprintf(stderr, "warning: last sequence in debug line table is not"
+                    "terminated!\n");
+  }
+
+  // Sort all sequences so that address lookup will work faster.
+  if (!Sequences.empty()) {
+    std::sort(Sequences.begin(), Sequences.end(), Sequence::orderByLowPC);
+    // Note: actually, instruction address ranges of sequences should not
+    // overlap (in shared objects and executables). If they do, the address
+    // lookup would still work, though, but result would be ambiguous.
+    // We don't report warning in this case. For example,
+    // sometimes .so compiled from multiple object files contains a few
+    // rudimentary sequences for address ranges [0x0, 0xsomething).
+  }
+
+  return EndOffset;
+}
+
+void DWARFDebugLine::LineTable::parseProgram(
+    const DWARFDataExtractor &DebugLineData, uint32_t *OffsetPtr,
+    uint32_t EndOffset, ParsingState &State, raw_ostream *OS) {
+  State.Sequence.ProgramOffset = *OffsetPtr;
   while (*OffsetPtr < EndOffset) {
     if (OS)
       *OS << format("0x%08.08" PRIx32 ": ", *OffsetPtr);
@@ -449,6 +609,7 @@ bool DWARFDebugLine::LineTable::parse(const DWARFDataExtractor &DebugLineData,
           State.Row.dump(*OS);
         }
         State.resetRowAndSequence();
+        State.Sequence.ProgramOffset = *OffsetPtr;
         break;
 
       case DW_LNE_set_address:
@@ -712,44 +873,25 @@ bool DWARFDebugLine::LineTable::parse(const DWARFDataExtractor &DebugLineData,
     if(OS)
       *OS << "\n";
   }
-
-  if (!State.Sequence.Empty) {
-    fprintf(stderr, "warning: last sequence in debug line table is not"
-                    "terminated!\n");
-  }
-
-  // Sort all sequences so that address lookup will work faster.
-  if (!Sequences.empty()) {
-    std::sort(Sequences.begin(), Sequences.end(), Sequence::orderByLowPC);
-    // Note: actually, instruction address ranges of sequences should not
-    // overlap (in shared objects and executables). If they do, the address
-    // lookup would still work, though, but result would be ambiguous.
-    // We don't report warning in this case. For example,
-    // sometimes .so compiled from multiple object files contains a few
-    // rudimentary sequences for address ranges [0x0, 0xsomething).
-  }
-
-  return EndOffset;
 }
 
-uint32_t
-DWARFDebugLine::LineTable::findRowInSeq(const DWARFDebugLine::Sequence &Seq,
-                                        uint64_t Address) const {
-  if (!Seq.containsPC(Address))
+uint32_t DWARFDebugLine::LineTable::findRowInSequenceRows(
+    ArrayRef<Row> SeqRows, uint64_t Address) const {
+  if (SeqRows.empty())
     return UnknownRowIndex;
   // Search for instruction address in the rows describing the sequence.
   // Rows are stored in a vector, so we may use arithmetical operations with
   // iterators.
   DWARFDebugLine::Row Row;
   Row.Address = Address;
-  RowIter FirstRow = Rows.begin() + Seq.FirstRowIndex;
-  RowIter LastRow = Rows.begin() + Seq.LastRowIndex;
-  LineTable::RowIter RowPos = std::lower_bound(
+  const DWARFDebugLine::Row *FirstRow = SeqRows.begin();
+  const DWARFDebugLine::Row *LastRow = SeqRows.end();
+  const DWARFDebugLine::Row *RowPos = std::lower_bound(
       FirstRow, LastRow, Row, DWARFDebugLine::Row::orderByAddress);
   if (RowPos == LastRow) {
-    return Seq.LastRowIndex - 1;
+    return SeqRows.size() - 1;
   }
-  uint32_t Index = Seq.FirstRowIndex + (RowPos - FirstRow);
+  uint32_t Index = RowPos - FirstRow;
   if (RowPos->Address > Address) {
     if (RowPos == FirstRow)
       return UnknownRowIndex;
@@ -759,27 +901,50 @@ DWARFDebugLine::LineTable::findRowInSeq(const DWARFDebugLine::Sequence &Seq,
   return Index;
 }
 
-uint32_t DWARFDebugLine::LineTable::lookupAddress(uint64_t Address) const {
-  if (Sequences.empty())
+uint32_t
+DWARFDebugLine::LineTable::findRowInSeq(const DWARFDebugLine::Sequence &Seq,
+                                        uint64_t Address) const {
+  if (!Seq.containsPC(Address))
     return UnknownRowIndex;
-  // First, find an instruction sequence containing the given address.
+  uint32_t Index = findRowInSequenceRows(
+      makeArrayRef(Rows).slice(Seq.FirstRowIndex,
+                               Seq.LastRowIndex - Seq.FirstRowIndex),
+      Address);
+  if (Index == UnknownRowIndex)
+    return UnknownRowIndex;
+  return Seq.FirstRowIndex + Index;
+}
+
+const DWARFDebugLine::Sequence *
+DWARFDebugLine::LineTable::findSequence(uint64_t Address) const {
+  if (Sequences.empty())
+    return nullptr;
+  // Find the last sequence starting at or before the address.
   DWARFDebugLine::Sequence Sequence;
   Sequence.LowPC = Address;
   SequenceIter FirstSeq = Sequences.begin();
   SequenceIter LastSeq = Sequences.end();
   SequenceIter SeqPos = std::lower_bound(
       FirstSeq, LastSeq, Sequence, DWARFDebugLine::Sequence::orderByLowPC);
-  DWARFDebugLine::Sequence FoundSeq;
+  const DWARFDebugLine::Sequence *FoundSeq;
   if (SeqPos == LastSeq) {
-    FoundSeq = Sequences.back();
+    FoundSeq = &Sequences.back();
   } else if (SeqPos->LowPC == Address) {
-    FoundSeq = *SeqPos;
+    FoundSeq = &*SeqPos;
   } else {
     if (SeqPos == FirstSeq)
-      return UnknownRowIndex;
-    FoundSeq = *(SeqPos - 1);
+      return nullptr;
+    FoundSeq = &*(SeqPos - 1);
   }
-  return findRowInSeq(FoundSeq, Address);
+  return FoundSeq->containsPC(Address) ? FoundSeq : nullptr;
+}
+
+uint32_t DWARFDebugLine::LineTable::lookupAddress(uint64_t Address) const {
+  // First, find an instruction sequence containing the given address.
+  const DWARFDebugLine::Sequence *FoundSeq = findSequence(Address);
+  if (!FoundSeq)
+    return UnknownRowIndex;
+  return findRowInSeq(*FoundSeq, Address);
 }
 
 bool DWARFDebugLine::LineTable::lookupAddressRange(
@@ -879,12 +1044,17 @@ bool DWARFDebugLine::LineTable::getFileLineInfoForAddress(
   uint32_t RowIndex = lookupAddress(Address);
   if (RowIndex == -1U)
     return false;
+  return getFileLineInfoForRow(Rows[RowIndex], CompDir, Kind, Result);
+}
+
+bool DWARFDebugLine::LineTable::getFileLineInfoForRow(
+    const Row &R, const char *CompDir, FileLineInfoKind Kind,
+    DILineInfo &Result) const {
   // Take file number and line/column from the row.
-  const auto &Row = Rows[RowIndex];
-  if (!getFileNameByIndex(Row.File, CompDir, Kind, Result.FileName))
+  if (!getFileNameByIndex(R.File, CompDir, Kind, Result.FileName))
     return false;
-  Result.Line = Row.Line;
-  Result.Column = Row.Column;
-  Result.Discriminator = Row.Discriminator;
+  Result.Line = R.Line;
+  Result.Column = R.Column;
+  Result.Discriminator = R.Discriminator;
   return true;
 }
@@ -226,8 +226,11 @@ void DWARFUnit::extractDIEsToVector(
 }
 
 size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
+  // A unit DIE without children is all there is to extract; checking for it
+  // also keeps lookups from extracting such units over and over again.
   if ((CUDieOnly && !DieArray.empty()) ||
-      DieArray.size() > 1)
+      DieArray.size() > 1 ||
+      (DieArray.size() == 1 && !DieArray[0].hasChildren()))
     return 0; // Already parsed.
 
   bool HasCUDie = !DieArray.empty();
@@ -385,6 +388,30 @@ DWARFDie DWARFUnit::getSubroutineForAddress(uint64_t Address) {
   return R->second.second;
 }
 
+std::pair<uint64_t, uint64_t>
+DWARFUnit::getSubroutineRangeForAddress(uint64_t Address) {
+  extractDIEsIfNeeded(false);
+  if (AddrDieMap.empty())
+    updateAddressDieMap(getUnitDIE());
+  uint64_t Begin = 0;
+  uint64_t End = UINT64_MAX;
+  auto R = AddrDieMap.upper_bound(Address);
+  if (R != AddrDieMap.end())
+    End = R->first;
+  if (R == AddrDieMap.begin())
+    return {Begin, End};
+  --R;
+  if (Address >= R->second.first)
+    return {R->second.first, End};
+  return {R->first, R->second.first};
+}
+
+std::pair<uint64_t, uint64_t>
+DWARFUnit::getInlinedChainRangeForAddress(uint64_t Address) {
+  parseDWO();
+  return (DWO ? DWO.get() : this)->getSubroutineRangeForAddress(Address);
+}
+
 void
 DWARFUnit::getInlinedChainForAddress(uint64_t Address,
                                      SmallVectorImpl<DWARFDie> &InlinedChain) {
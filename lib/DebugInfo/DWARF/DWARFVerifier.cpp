@@ -16,8 +16,12 @@
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/DebugInfo/DWARF/DWARFSection.h"
 #include "llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <map>
+#include <numeric>
 #include <set>
 #include <vector>
 
@@ -105,6 +109,45 @@ bool DWARFVerifier::DieRangeInfo::intersects(const DieRangeInfo &RHS) const {
   return false;
 }
 
+DWARFVerifier::DWARFVerifier(raw_ostream &S, DWARFContext &D,
+                             DIDumpOptions DumpOpts, unsigned NumThreads)
+    : OS(S), DCtx(D), DumpOpts(std::move(DumpOpts)),
+      NumThreads(NumThreads ? NumThreads : heavyweight_hardware_concurrency()),
+      ContextMutex(std::make_shared<std::mutex>()) {}
+
+DWARFVerifier::DWARFVerifier(raw_ostream &S, const DWARFVerifier &Parent)
+    : OS(S), DCtx(Parent.DCtx), DumpOpts(Parent.DumpOpts), NumThreads(1),
+      ContextMutex(Parent.ContextMutex) {}
+
+void DWARFVerifier::runTasks(
+    size_t NumTasks, function_ref<void(size_t, DWARFVerifier &)> Task) {
+  if (NumThreads <= 1 || NumTasks <= 1) {
+    for (size_t I = 0; I != NumTasks; ++I) {
+      DWARFVerifier TaskVerifier(OS, *this);
+      Task(I, TaskVerifier);
+    }
+    return;
+  }
+
+  std::vector<std::string> Reports(NumTasks);
+  {
+    ThreadPool Pool(std::min<size_t>(NumThreads, NumTasks));
+    for (size_t I = 0; I != NumTasks; ++I)
+      Pool.async([&, I] {
+        raw_string_ostream ReportOS(Reports[I]);
+        DWARFVerifier TaskVerifier(ReportOS, *this);
+        Task(I, TaskVerifier);
+      });
+  }
+  for (const std::string &Report : Reports)
+    OS << Report;
+}
+
+void DWARFVerifier::dump(const DWARFDie &Die, DIDumpOptions Opts) const {
+  std::lock_guard<std::mutex> Lock(*ContextMutex);
+  Die.dump(OS, 0, Opts);
+}
+
 bool DWARFVerifier::verifyUnitHeader(const DWARFDataExtractor DebugInfoData,
                                      uint32_t *Offset, unsigned UnitIndex,
                                      uint8_t &UnitType, bool &isUnitDWARF64) {
@@ -141,8 +184,11 @@ bool DWARFVerifier::verifyUnitHeader(const DWARFDataExtractor DebugInfoData,
     AddrSize = DebugInfoData.getU8(Offset);
   }
 
-  if (!DCtx.getDebugAbbrev()->getAbbreviationDeclarationSet(AbbrOffset))
-    ValidAbbrevOffset = false;
+  {
+    std::lock_guard<std::mutex> Lock(*ContextMutex);
+    if (!DCtx.getDebugAbbrev()->getAbbreviationDeclarationSet(AbbrOffset))
+      ValidAbbrevOffset = false;
+  }
 
   ValidLength = DebugInfoData.isValidOffset(OffsetStart + Length + 3);
   ValidVersion = DWARFContext::isSupportedVersion(Version);
@@ -240,62 +286,86 @@ bool DWARFVerifier::handleDebugInfo() {
   const DWARFObject &DObj = DCtx.getDWARFObj();
   DWARFDataExtractor DebugInfoData(DObj, DObj.getInfoSection(),
                                    DCtx.isLittleEndian(), 0);
-  uint32_t NumDebugInfoErrors = 0;
-  uint32_t OffsetStart = 0, Offset = 0, UnitIdx = 0;
-  uint8_t UnitType = 0;
-  bool isUnitDWARF64 = false;
+  // Find where each unit starts. The header of each unit is verified along
+  // with its contents, and we can't go past a unit in 64-bit DWARF format.
+  std::vector<uint32_t> UnitOffsets;
+  uint32_t Offset = 0;
+  while (DebugInfoData.isValidOffset(Offset)) {
+    UnitOffsets.push_back(Offset);
+    uint32_t Length = DebugInfoData.getU32(&Offset);
+    if (Length == UINT32_MAX)
+      break;
+    Offset = UnitOffsets.back() + Length + 4;
+  }
+
+  size_t NumUnits = UnitOffsets.size();
+  std::vector<char> ValidHeaders(NumUnits), ValidContents(NumUnits, true);
+  std::vector<std::map<uint64_t, std::set<uint32_t>>> UnitReferences(NumUnits);
+  runTasks(NumUnits, [&](size_t UnitIdx, DWARFVerifier &V) {
+    uint32_t OffsetStart = UnitOffsets[UnitIdx];
+    uint32_t NextOffset = OffsetStart;
+    uint8_t UnitType = 0;
+    bool isUnitDWARF64 = false;
+    ValidHeaders[UnitIdx] = V.verifyUnitHeader(DebugInfoData, &NextOffset,
+                                               UnitIdx, UnitType,
+                                               isUnitDWARF64);
+    if (!ValidHeaders[UnitIdx])
+      return;
+
+    DWARFUnitSection<DWARFTypeUnit> TUSection{};
+    DWARFUnitSection<DWARFCompileUnit> CUSection{};
+    std::unique_ptr<DWARFUnit> Unit;
+    switch (UnitType) {
+    case dwarf::DW_UT_type:
+    case dwarf::DW_UT_split_type: {
+      Unit.reset(new DWARFTypeUnit(
+          DCtx, DObj.getInfoSection(), DCtx.getDebugAbbrev(),
+          &DObj.getRangeSection(), DObj.getStringSection(),
+          DObj.getStringOffsetSection(), &DObj.getAppleObjCSection(),
+          DObj.getLineSection(), DCtx.isLittleEndian(), false, TUSection,
+          nullptr));
+      break;
+    }
+    case dwarf::DW_UT_skeleton:
+    case dwarf::DW_UT_split_compile:
+    case dwarf::DW_UT_compile:
+    case dwarf::DW_UT_partial:
+    // UnitType = 0 means that we are
+    // verifying a compile unit in DWARF v4.
+    case 0: {
+      Unit.reset(new DWARFCompileUnit(
+          DCtx, DObj.getInfoSection(), DCtx.getDebugAbbrev(),
+          &DObj.getRangeSection(), DObj.getStringSection(),
+          DObj.getStringOffsetSection(), &DObj.getAppleObjCSection(),
+          DObj.getLineSection(), DCtx.isLittleEndian(), false, CUSection,
+          nullptr));
+      break;
+    }
+    default: { llvm_unreachable("Invalid UnitType."); }
+    }
+    Unit->extract(DebugInfoData, &OffsetStart);
+    {
+      // The abbreviation sets are cached by the context's DWARFDebugAbbrev.
+      std::lock_guard<std::mutex> Lock(*ContextMutex);
+      Unit->getAbbreviations();
+    }
+    ValidContents[UnitIdx] = V.verifyUnitContents(*Unit);
+    UnitReferences[UnitIdx] = std::move(V.ReferenceToDIEOffsets);
+  });
+
   bool isHeaderChainValid = true;
-  bool hasDIE = DebugInfoData.isValidOffset(Offset);
-  while (hasDIE) {
-    OffsetStart = Offset;
-    if (!verifyUnitHeader(DebugInfoData, &Offset, UnitIdx, UnitType,
-                          isUnitDWARF64)) {
+  uint32_t NumDebugInfoErrors = 0;
+  for (size_t UnitIdx = 0; UnitIdx != NumUnits; ++UnitIdx) {
+    if (!ValidHeaders[UnitIdx])
       isHeaderChainValid = false;
-      if (isUnitDWARF64)
-        break;
-    } else {
-      std::unique_ptr<DWARFUnit> Unit;
-      switch (UnitType) {
-      case dwarf::DW_UT_type:
-      case dwarf::DW_UT_split_type: {
-        DWARFUnitSection<DWARFTypeUnit> TUSection{};
-        Unit.reset(new DWARFTypeUnit(
-            DCtx, DObj.getInfoSection(), DCtx.getDebugAbbrev(),
-            &DObj.getRangeSection(), DObj.getStringSection(),
-            DObj.getStringOffsetSection(), &DObj.getAppleObjCSection(),
-            DObj.getLineSection(), DCtx.isLittleEndian(), false, TUSection,
-            nullptr));
-        break;
-      }
-      case dwarf::DW_UT_skeleton:
-      case dwarf::DW_UT_split_compile:
-      case dwarf::DW_UT_compile:
-      case dwarf::DW_UT_partial:
-      // UnitType = 0 means that we are
-      // verifying a compile unit in DWARF v4.
-      case 0: {
-        DWARFUnitSection<DWARFCompileUnit> CUSection{};
-        Unit.reset(new DWARFCompileUnit(
-            DCtx, DObj.getInfoSection(), DCtx.getDebugAbbrev(),
-            &DObj.getRangeSection(), DObj.getStringSection(),
-            DObj.getStringOffsetSection(), &DObj.getAppleObjCSection(),
-            DObj.getLineSection(), DCtx.isLittleEndian(), false, CUSection,
-            nullptr));
-        break;
-      }
-      default: { llvm_unreachable("Invalid UnitType."); }
-      }
-      Unit->extract(DebugInfoData, &OffsetStart);
-      if (!verifyUnitContents(*Unit))
-        ++NumDebugInfoErrors;
-    }
-    hasDIE = DebugInfoData.isValidOffset(Offset);
-    ++UnitIdx;
+    else if (!ValidContents[UnitIdx])
+      ++NumDebugInfoErrors;
+    for (const auto &Pair : UnitReferences[UnitIdx])
+      ReferenceToDIEOffsets[Pair.first].insert(Pair.second.begin(),
+                                               Pair.second.end());
   }
-  if (UnitIdx == 0 && !hasDIE) {
+  if (NumUnits == 0)
     warn() << ".debug_info is empty.\n";
-    isHeaderChainValid = true;
-  }
   NumDebugInfoErrors += verifyDebugInfoReferences();
   return (isHeaderChainValid && NumDebugInfoErrors == 0);
 }
@@ -334,8 +404,8 @@ unsigned DWARFVerifier::verifyDieRanges(const DWARFDie &Die,
   if (IntersectingChild != ParentRI.Children.end()) {
     ++NumErrors;
     error() << "DIEs have overlapping address ranges:";
-    Die.dump(OS, 0);
-    IntersectingChild->Die.dump(OS, 0);
+    dump(Die);
+    dump(IntersectingChild->Die);
     OS << "\n";
   }
 
@@ -347,8 +417,8 @@ unsigned DWARFVerifier::verifyDieRanges(const DWARFDie &Die,
     ++NumErrors;
     error() << "DIE address ranges are not "
                "contained in its parent's ranges:";
-    Die.dump(OS, 0);
-    ParentRI.Die.dump(OS, 0);
+    dump(Die);
+    dump(ParentRI.Die);
     OS << "\n";
   }
 
@@ -372,13 +442,13 @@ unsigned DWARFVerifier::verifyDebugInfoAttribute(const DWARFDie &Die,
         ++NumErrors;
         error() << "DW_AT_ranges offset is beyond .debug_ranges "
                    "bounds:\n";
-        Die.dump(OS, 0, DumpOpts);
+        dump(Die, DumpOpts);
         OS << "\n";
       }
     } else {
       ++NumErrors;
       error() << "DIE has invalid DW_AT_ranges encoding:\n";
-      Die.dump(OS, 0, DumpOpts);
+      dump(Die, DumpOpts);
       OS << "\n";
     }
     break;
@@ -390,13 +460,13 @@ unsigned DWARFVerifier::verifyDebugInfoAttribute(const DWARFDie &Die,
         error() << "DW_AT_stmt_list offset is beyond .debug_line "
                    "bounds: "
                 << format("0x%08" PRIx64, *SectionOffset) << "\n";
-        Die.dump(OS, 0, DumpOpts);
+        dump(Die, DumpOpts);
         OS << "\n";
       }
     } else {
       ++NumErrors;
       error() << "DIE has invalid DW_AT_stmt_list encoding:\n";
-      Die.dump(OS, 0, DumpOpts);
+      dump(Die, DumpOpts);
       OS << "\n";
     }
     break;
@@ -431,7 +501,7 @@ unsigned DWARFVerifier::verifyDebugInfoForm(const DWARFDie &Die,
                 << format("0x%08" PRIx64, CUOffset)
                 << " is invalid (must be less than CU size of "
                 << format("0x%08" PRIx32, CUSize) << "):\n";
-        Die.dump(OS, 0, DumpOpts);
+        dump(Die, DumpOpts);
         OS << "\n";
       } else {
         // Valid reference, but we will verify it points to an actual
@@ -451,7 +521,7 @@ unsigned DWARFVerifier::verifyDebugInfoForm(const DWARFDie &Die,
         ++NumErrors;
         error() << "DW_FORM_ref_addr offset beyond .debug_info "
                    "bounds:\n";
-        Die.dump(OS, 0, DumpOpts);
+        dump(Die, DumpOpts);
         OS << "\n";
       } else {
         // Valid reference, but we will verify it points to an actual
@@ -467,7 +537,7 @@ unsigned DWARFVerifier::verifyDebugInfoForm(const DWARFDie &Die,
     if (SecOffset && *SecOffset >= DObj.getStringSection().size()) {
       ++NumErrors;
       error() << "DW_FORM_strp offset beyond .debug_str bounds:\n";
-      Die.dump(OS, 0, DumpOpts);
+      dump(Die, DumpOpts);
       OS << "\n";
     }
     break;
@@ -492,7 +562,7 @@ unsigned DWARFVerifier::verifyDebugInfoReferences() {
             << ". Offset is in between DIEs:\n";
     for (auto Offset : Pair.second) {
       auto ReferencingDie = DCtx.getDIEForOffset(Offset);
-      ReferencingDie.dump(OS, 0, DumpOpts);
+      dump(ReferencingDie, DumpOpts);
       OS << "\n";
     }
     OS << "\n";
@@ -500,10 +570,40 @@ unsigned DWARFVerifier::verifyDebugInfoReferences() {
   return NumErrors;
 }
 
-void DWARFVerifier::verifyDebugLineStmtOffsets() {
-  std::map<uint64_t, DWARFDie> StmtListToDie;
+std::vector<DWARFVerifier::UnitLineTable> DWARFVerifier::parseLineTables() {
+  // Extract the unit DIEs up front, as they are cached in the units. The line
+  // tables are parsed here rather than through DCtx, so that they can be
+  // parsed concurrently.
+  std::vector<UnitLineTable> LineTables;
   for (const auto &CU : DCtx.compile_units()) {
-    auto Die = CU->getUnitDIE();
+    CU->getUnitDIE();
+    LineTables.push_back({CU.get(), nullptr});
+  }
+
+  const DWARFObject &DObj = DCtx.getDWARFObj();
+  runTasks(LineTables.size(), [&](size_t I, DWARFVerifier &) {
+    DWARFUnit *U = LineTables[I].Unit;
+    auto StmtSectionOffset =
+        toSectionOffset(U->getUnitDIE().find(DW_AT_stmt_list));
+    if (!StmtSectionOffset)
+      return;
+    uint32_t Offset = *StmtSectionOffset + U->getLineTableOffset();
+    if (Offset >= U->getLineSection().Data.size())
+      return;
+    DWARFDataExtractor LineData(DObj, U->getLineSection(),
+                                DCtx.isLittleEndian(), U->getAddressByteSize());
+    auto LineTable = llvm::make_unique<DWARFDebugLine::LineTable>();
+    if (LineTable->parse(LineData, &Offset))
+      LineTables[I].LineTable = std::move(LineTable);
+  });
+  return LineTables;
+}
+
+void DWARFVerifier::verifyDebugLineStmtOffsets(
+    ArrayRef<UnitLineTable> LineTables) {
+  std::map<uint64_t, DWARFDie> StmtListToDie;
+  for (const UnitLineTable &LT : LineTables) {
+    auto Die = LT.Unit->getUnitDIE();
     // Get the attribute value as a section offset. No need to produce an
     // error here if the encoding isn't correct because we validate this in
     // the .debug_info verifier.
@@ -511,13 +611,13 @@ void DWARFVerifier::verifyDebugLineStmtOffsets() {
     if (!StmtSectionOffset)
       continue;
     const uint32_t LineTableOffset = *StmtSectionOffset;
-    auto LineTable = DCtx.getLineTableForUnit(CU.get());
+    auto LineTable = LT.LineTable.get();
     if (LineTableOffset < DCtx.getDWARFObj().getLineSection().Data.size()) {
       if (!LineTable) {
         ++NumDebugLineErrors;
         error() << ".debug_line[" << format("0x%08" PRIx32, LineTableOffset)
                 << "] was not able to be parsed for CU:\n";
-        Die.dump(OS, 0, DumpOpts);
+        dump(Die, DumpOpts);
         OS << '\n';
         continue;
       }
@@ -535,8 +635,8 @@ void DWARFVerifier::verifyDebugLineStmtOffsets() {
               << format("0x%08" PRIx32, Iter->second.getOffset()) << " and "
               << format("0x%08" PRIx32, Die.getOffset())
               << ", have the same DW_AT_stmt_list section offset:\n";
-      Iter->second.dump(OS, 0, DumpOpts);
-      Die.dump(OS, 0, DumpOpts);
+      dump(Iter->second, DumpOpts);
+      dump(Die, DumpOpts);
       OS << '\n';
       // Already verified this line table before, no need to do it again.
       continue;
@@ -545,99 +645,105 @@ void DWARFVerifier::verifyDebugLineStmtOffsets() {
   }
 }
 
-void DWARFVerifier::verifyDebugLineRows() {
-  for (const auto &CU : DCtx.compile_units()) {
-    auto Die = CU->getUnitDIE();
-    auto LineTable = DCtx.getLineTableForUnit(CU.get());
-    // If there is no line table we will have created an error in the
-    // .debug_info verifier or in verifyDebugLineStmtOffsets().
-    if (!LineTable)
-      continue;
+void DWARFVerifier::verifyDebugLineRows(const UnitLineTable &LT) {
+  DWARFUnit *CU = LT.Unit;
+  auto Die = CU->getUnitDIE();
+  auto LineTable = LT.LineTable.get();
+  // If there is no line table we will have created an error in the
+  // .debug_info verifier or in verifyDebugLineStmtOffsets().
+  if (!LineTable)
+    return;
+
+  // Verify prologue.
+  uint32_t MaxFileIndex = LineTable->Prologue.FileNames.size();
+  uint32_t MaxDirIndex = LineTable->Prologue.IncludeDirectories.size();
+  uint32_t FileIndex = 1;
+  StringMap<uint16_t> FullPathMap;
+  for (const auto &FileName : LineTable->Prologue.FileNames) {
+    // Verify directory index.
+    if (FileName.DirIdx > MaxDirIndex) {
+      ++NumDebugLineErrors;
+      error() << ".debug_line["
+              << format("0x%08" PRIx64,
+                        *toSectionOffset(Die.find(DW_AT_stmt_list)))
+              << "].prologue.file_names[" << FileIndex
+              << "].dir_idx contains an invalid index: " << FileName.DirIdx
+              << "\n";
+    }
 
-    // Verify prologue.
-    uint32_t MaxFileIndex = LineTable->Prologue.FileNames.size();
-    uint32_t MaxDirIndex = LineTable->Prologue.IncludeDirectories.size();
-    uint32_t FileIndex = 1;
-    StringMap<uint16_t> FullPathMap;
-    for (const auto &FileName : LineTable->Prologue.FileNames) {
-      // Verify directory index.
-      if (FileName.DirIdx > MaxDirIndex) {
-        ++NumDebugLineErrors;
-        error() << ".debug_line["
-                << format("0x%08" PRIx64,
-                          *toSectionOffset(Die.find(DW_AT_stmt_list)))
-                << "].prologue.file_names[" << FileIndex
-                << "].dir_idx contains an invalid index: " << FileName.DirIdx
-                << "\n";
-      }
+    // Check file paths for duplicates.
+    std::string FullPath;
+    const bool HasFullPath = LineTable->getFileNameByIndex(
+        FileIndex, CU->getCompilationDir(),
+        DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, FullPath);
+    assert(HasFullPath && "Invalid index?");
+    (void)HasFullPath;
+    auto It = FullPathMap.find(FullPath);
+    if (It == FullPathMap.end())
+      FullPathMap[FullPath] = FileIndex;
+    else if (It->second != FileIndex) {
+      warn() << ".debug_line["
+             << format("0x%08" PRIx64,
+                       *toSectionOffset(Die.find(DW_AT_stmt_list)))
+             << "].prologue.file_names[" << FileIndex
+             << "] is a duplicate of file_names[" << It->second << "]\n";
+    }
 
-      // Check file paths for duplicates.
-      std::string FullPath;
-      const bool HasFullPath = LineTable->getFileNameByIndex(
-          FileIndex, CU->getCompilationDir(),
-          DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, FullPath);
-      assert(HasFullPath && "Invalid index?");
-      (void)HasFullPath;
-      auto It = FullPathMap.find(FullPath);
-      if (It == FullPathMap.end())
-        FullPathMap[FullPath] = FileIndex;
-      else if (It->second != FileIndex) {
-        warn() << ".debug_line["
-               << format("0x%08" PRIx64,
-                         *toSectionOffset(Die.find(DW_AT_stmt_list)))
-               << "].prologue.file_names[" << FileIndex
-               << "] is a duplicate of file_names[" << It->second << "]\n";
-      }
+    FileIndex++;
+  }
 
-      FileIndex++;
+  // Verify rows.
+  uint64_t PrevAddress = 0;
+  uint32_t RowIndex = 0;
+  for (const auto &Row : LineTable->Rows) {
+    // Verify row address.
+    if (Row.Address < PrevAddress) {
+      ++NumDebugLineErrors;
+      error() << ".debug_line["
+              << format("0x%08" PRIx64,
+                        *toSectionOffset(Die.find(DW_AT_stmt_list)))
+              << "] row[" << RowIndex
+              << "] decreases in address from previous row:\n";
+
+      DWARFDebugLine::Row::dumpTableHeader(OS);
+      if (RowIndex > 0)
+        LineTable->Rows[RowIndex - 1].dump(OS);
+      Row.dump(OS);
+      OS << '\n';
     }
 
-    // Verify rows.
-    uint64_t PrevAddress = 0;
-    uint32_t RowIndex = 0;
-    for (const auto &Row : LineTable->Rows) {
-      // Verify row address.
-      if (Row.Address < PrevAddress) {
-        ++NumDebugLineErrors;
-        error() << ".debug_line["
-                << format("0x%08" PRIx64,
-                          *toSectionOffset(Die.find(DW_AT_stmt_list)))
-                << "] row[" << RowIndex
-                << "] decreases in address from previous row:\n";
-
-        DWARFDebugLine::Row::dumpTableHeader(OS);
-        if (RowIndex > 0)
-          LineTable->Rows[RowIndex - 1].dump(OS);
-        Row.dump(OS);
-        OS << '\n';
-      }
-
-      // Verify file index.
-      if (Row.File > MaxFileIndex) {
-        ++NumDebugLineErrors;
-        error() << ".debug_line["
-                << format("0x%08" PRIx64,
-                          *toSectionOffset(Die.find(DW_AT_stmt_list)))
-                << "][" << RowIndex << "] has invalid file index " << Row.File
-                << " (valid values are [1," << MaxFileIndex << "]):\n";
-        DWARFDebugLine::Row::dumpTableHeader(OS);
-        Row.dump(OS);
-        OS << '\n';
-      }
-      if (Row.EndSequence)
-        PrevAddress = 0;
-      else
-        PrevAddress = Row.Address;
-      ++RowIndex;
+    // Verify file index.
+    if (Row.File > MaxFileIndex) {
+      ++NumDebugLineErrors;
+      error() << ".debug_line["
+              << format("0x%08" PRIx64,
+                        *toSectionOffset(Die.find(DW_AT_stmt_list)))
+              << "][" << RowIndex << "] has invalid file index " << Row.File
+              << " (valid values are [1," << MaxFileIndex << "]):\n";
+      DWARFDebugLine::Row::dumpTableHeader(OS);
+      Row.dump(OS);
+      OS << '\n';
     }
+    if (Row.EndSequence)
+      PrevAddress = 0;
+    else
+      PrevAddress = Row.Address;
+    ++RowIndex;
   }
 }
 
 bool DWARFVerifier::handleDebugLine() {
   NumDebugLineErrors = 0;
   OS << "Verifying .debug_line...\n";
-  verifyDebugLineStmtOffsets();
-  verifyDebugLineRows();
+  std::vector<UnitLineTable> LineTables = parseLineTables();
+  verifyDebugLineStmtOffsets(LineTables);
+  std::vector<uint32_t> NumRowErrors(LineTables.size());
+  runTasks(LineTables.size(), [&](size_t I, DWARFVerifier &V) {
+    V.verifyDebugLineRows(LineTables[I]);
+    NumRowErrors[I] = V.NumDebugLineErrors;
+  });
+  NumDebugLineErrors = std::accumulate(NumRowErrors.begin(), NumRowErrors.end(),
+                                       NumDebugLineErrors);
   return NumDebugLineErrors == 0;
 }
 
@@ -748,20 +854,36 @@ unsigned DWARFVerifier::verifyAccelTable(const DWARFSection *AccelSection,
 bool DWARFVerifier::handleAccelTables() {
   const DWARFObject &D = DCtx.getDWARFObj();
   DataExtractor StrData(D.getStringSection(), DCtx.isLittleEndian(), 0);
-  unsigned NumErrors = 0;
+  std::vector<std::pair<const DWARFSection *, const char *>> AccelTables;
   if (!D.getAppleNamesSection().Data.empty())
-    NumErrors +=
-        verifyAccelTable(&D.getAppleNamesSection(), &StrData, ".apple_names");
+    AccelTables.push_back({&D.getAppleNamesSection(), ".apple_names"});
   if (!D.getAppleTypesSection().Data.empty())
-    NumErrors +=
-        verifyAccelTable(&D.getAppleTypesSection(), &StrData, ".apple_types");
+    AccelTables.push_back({&D.getAppleTypesSection(), ".apple_types"});
   if (!D.getAppleNamespacesSection().Data.empty())
-    NumErrors += verifyAccelTable(&D.getAppleNamespacesSection(), &StrData,
-                                  ".apple_namespaces");
+    AccelTables.push_back(
+        {&D.getAppleNamespacesSection(), ".apple_namespaces"});
   if (!D.getAppleObjCSection().Data.empty())
-    NumErrors +=
-        verifyAccelTable(&D.getAppleObjCSection(), &StrData, ".apple_objc");
-  return NumErrors == 0;
+    AccelTables.push_back({&D.getAppleObjCSection(), ".apple_objc"});
+  if (AccelTables.empty())
+    return true;
+
+  // The tables are checked against the DIEs of the compile units. Extract
+  // all of them first, so that the checks only ever read the units.
+  std::vector<DWARFUnit *> CUs;
+  for (const auto &CU : DCtx.compile_units()) {
+    CU->getAbbreviations();
+    CUs.push_back(CU.get());
+  }
+  runTasks(CUs.size(), [&](size_t I, DWARFVerifier &) {
+    CUs[I]->getUnitDIE(/* ExtractUnitDIEOnly = */ false);
+  });
+
+  std::vector<unsigned> NumErrors(AccelTables.size());
+  runTasks(AccelTables.size(), [&](size_t I, DWARFVerifier &V) {
+    NumErrors[I] = V.verifyAccelTable(AccelTables[I].first, &StrData,
+                                      AccelTables[I].second);
+  });
+  return std::accumulate(NumErrors.begin(), NumErrors.end(), 0u) == 0;
 }
 
 raw_ostream &DWARFVerifier::error() const {
@@ -220,20 +220,13 @@ Error DbiModuleList::initializeFileInfo(BinaryStreamRef FileInfo) {
   if (auto EC = FISR.readStreamRef(NamesBuffer))
     return EC;
 
-  auto DescriptorIter = Descriptors.begin();
   uint32_t NextFileIndex = 0;
   ModuleInitialFileIndex.resize(FileInfoHeader->NumModules);
-  ModuleDescriptorOffsets.resize(FileInfoHeader->NumModules);
   for (size_t I = 0; I < FileInfoHeader->NumModules; ++I) {
-    assert(DescriptorIter != Descriptors.end());
     ModuleInitialFileIndex[I] = NextFileIndex;
-    ModuleDescriptorOffsets[I] = DescriptorIter.offset();
-
     NextFileIndex += ModFileCountArray[I];
-    ++DescriptorIter;
   }
 
-  assert(DescriptorIter == Descriptors.end());
   assert(NextFileIndex == NumSourceFiles);
 
   return Error::success();
@@ -251,9 +244,29 @@ uint16_t DbiModuleList::getSourceFileCount(uint32_t Modi) const {
   return ModFileCountArray[Modi];
 }
 
+uint32_t DbiModuleList::getModuleDescriptorOffset(uint32_t Modi) const {
+  std::lock_guard<std::mutex> Lock(ModuleDescriptorOffsetsMutex);
+  if (Modi < ModuleDescriptorOffsets.size())
+    return ModuleDescriptorOffsets[Modi];
+
+  // Resume after the last descriptor whose offset is known.
+  auto DescriptorIter = ModuleDescriptorOffsets.empty()
+                            ? Descriptors.begin()
+                            : ++Descriptors.at(ModuleDescriptorOffsets.back());
+  while (ModuleDescriptorOffsets.size() <= Modi) {
+    assert(DescriptorIter != Descriptors.end());
+    ModuleDescriptorOffsets.push_back(DescriptorIter.offset());
+    ++DescriptorIter;
+  }
+  // There must be exactly NumModules descriptors.
+  assert(ModuleDescriptorOffsets.size() < getModuleCount() ||
+         DescriptorIter == Descriptors.end());
+  return ModuleDescriptorOffsets[Modi];
+}
+
 DbiModuleDescriptor DbiModuleList::getModuleDescriptor(uint32_t Modi) const {
   assert(Modi < getModuleCount());
-  uint32_t Offset = ModuleDescriptorOffsets[Modi];
+  uint32_t Offset = getModuleDescriptorOffset(Modi);
   auto Iter = Descriptors.at(Offset);
   assert(Iter != Descriptors.end());
   return *Iter;
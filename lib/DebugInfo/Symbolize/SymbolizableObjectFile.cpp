@@ -180,6 +180,10 @@ bool SymbolizableObjectFile::isWin32Module() const {
   return CoffObject && CoffObject->getMachine() == COFF::IMAGE_FILE_MACHINE_I386;
 }
 
+bool SymbolizableObjectFile::hasDWARFContext() const {
+  return DebugInfoContext && isa<DWARFContext>(DebugInfoContext.get());
+}
+
 uint64_t SymbolizableObjectFile::getModulePreferredBase() const {
   if (auto *CoffObject = dyn_cast<COFFObjectFile>(Module))
     return CoffObject->getImageBase();
@@ -223,6 +227,7 @@ DILineInfo SymbolizableObjectFile::symbolizeCode(uint64_t ModuleOffset,
                                                  bool UseSymbolTable) const {
   DILineInfo LineInfo;
   if (DebugInfoContext) {
+    std::lock_guard<std::mutex> Lock(DebugInfoMutex);
     LineInfo = DebugInfoContext->getLineInfoForAddress(
         ModuleOffset, getDILineInfoSpecifier(FNKind));
   }
@@ -242,9 +247,11 @@ DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
     uint64_t ModuleOffset, FunctionNameKind FNKind, bool UseSymbolTable) const {
   DIInliningInfo InlinedContext;
 
-  if (DebugInfoContext)
+  if (DebugInfoContext) {
+    std::lock_guard<std::mutex> Lock(DebugInfoMutex);
     InlinedContext = DebugInfoContext->getInliningInfoForAddress(
         ModuleOffset, getDILineInfoSpecifier(FNKind));
+  }
   // Make sure there is at least one frame in context.
   if (InlinedContext.getNumberOfFrames() == 0)
     InlinedContext.addFrame(DILineInfo());
@@ -263,6 +270,45 @@ DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
   return InlinedContext;
 }
 
+std::pair<uint64_t, uint64_t>
+SymbolizableObjectFile::getCodeRange(uint64_t ModuleOffset,
+                                     FunctionNameKind FNKind,
+                                     bool UseSymbolTable) const {
+  auto *DCtx = dyn_cast_or_null<DWARFContext>(DebugInfoContext.get());
+  if (!DCtx)
+    return {ModuleOffset, ModuleOffset + 1};
+  DWARFAddressRange Range;
+  {
+    std::lock_guard<std::mutex> Lock(DebugInfoMutex);
+    Range = DCtx->getLineInfoRangeForAddress(ModuleOffset);
+  }
+  uint64_t Begin = Range.LowPC;
+  uint64_t End = Range.HighPC;
+
+  // The function name may come from the symbol table instead, which gives the
+  // last symbol starting at or before the address if it covers the address.
+  if (shouldOverrideWithSymbolTable(FNKind, UseSymbolTable) &&
+      !Functions.empty()) {
+    SymbolDesc SD = {ModuleOffset, ModuleOffset};
+    auto SymbolIterator = Functions.upper_bound(SD);
+    if (SymbolIterator != Functions.end())
+      End = std::min(End, SymbolIterator->first.Addr);
+    if (SymbolIterator != Functions.begin()) {
+      --SymbolIterator;
+      uint64_t SymbolStart = SymbolIterator->first.Addr;
+      uint64_t SymbolEnd = SymbolStart + SymbolIterator->first.Size;
+      if (SymbolIterator->first.Size == 0 || ModuleOffset < SymbolEnd) {
+        Begin = std::max(Begin, SymbolStart);
+        if (SymbolIterator->first.Size != 0)
+          End = std::min(End, SymbolEnd);
+      } else {
+        Begin = std::max(Begin, SymbolEnd);
+      }
+    }
+  }
+  return {Begin, End};
+}
+
 DIGlobal SymbolizableObjectFile::symbolizeData(uint64_t ModuleOffset) const {
   DIGlobal Res;
   getNameFromSymbolTable(SymbolRef::ST_Data, ModuleOffset, Res.Name, Res.Start,
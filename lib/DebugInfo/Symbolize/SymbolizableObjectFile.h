@@ -20,8 +20,10 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <system_error>
+#include <utility>
 
 namespace llvm {
 
@@ -41,6 +43,18 @@ public:
                                       bool UseSymbolTable) const override;
   DIGlobal symbolizeData(uint64_t ModuleOffset) const override;
 
+  /// Returns the range of module offsets [first, second) around
+  /// \p ModuleOffset for which symbolizeCode() and symbolizeInlinedCode() give
+  /// the same results as for \p ModuleOffset. Without DWARF the range only
+  /// holds \p ModuleOffset.
+  std::pair<uint64_t, uint64_t> getCodeRange(uint64_t ModuleOffset,
+                                             FunctionNameKind FNKind,
+                                             bool UseSymbolTable) const;
+
+  /// Returns true if the debug info is DWARF, which can be read by several
+  /// independent contexts over the same object file at once.
+  bool hasDWARFContext() const;
+
   // Return true if this is a 32-bit x86 PE COFF module.
   bool isWin32Module() const override;
 
@@ -65,6 +79,9 @@ private:
 
   object::ObjectFile *Module;
   std::unique_ptr<DIContext> DebugInfoContext;
+  /// Debug info contexts parse lazily and are not thread-safe; this serializes
+  /// their use. The symbol tables are immutable after construction.
+  mutable std::mutex DebugInfoMutex;
 
   struct SymbolDesc {
     uint64_t Addr;
@@ -0,0 +1,339 @@
+//===- SymbolizationCache.cpp ---------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of SymbolizationCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SymbolizationCache.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/DebugInfo/CodeView/CVDebugRecord.h"
+#include "llvm/Object/COFF.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Object/MachO.h"
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace llvm;
+using namespace object;
+using namespace symbolize;
+
+static const char CacheMagic[8] = {'L', 'L', 'V', 'M', 'S', 'Y', 'M', 'C'};
+
+// Bump this whenever the file layout or the meaning of cached results changes.
+static const uint32_t CacheVersion = 2;
+
+static std::string getELFBuildID(const ObjectFile &Obj) {
+  for (const SectionRef &Section : Obj.sections()) {
+    StringRef Name;
+    if (Section.getName(Name) || Name != ".note.gnu.build-id")
+      continue;
+    StringRef Data;
+    if (Section.getContents(Data))
+      return "";
+    // The section is a sequence of notes, each a (namesz, descsz, type)
+    // header followed by the name and the descriptor, both 4-byte aligned.
+    DataExtractor DE(Data, Obj.isLittleEndian(), 0);
+    uint32_t Offset = 0;
+    while (DE.isValidOffsetForDataOfSize(Offset, 12)) {
+      uint32_t NameSize = DE.getU32(&Offset);
+      uint32_t DescSize = DE.getU32(&Offset);
+      uint32_t Type = DE.getU32(&Offset);
+      uint32_t NameOffset = Offset;
+      uint32_t DescOffset = NameOffset + alignTo(NameSize, 4);
+      if (!DE.isValidOffsetForDataOfSize(DescOffset, DescSize))
+        break;
+      if (Type == ELF::NT_GNU_BUILD_ID && NameSize == 4 &&
+          Data.substr(NameOffset, 4) == StringRef("GNU\0", 4))
+        return toHex(Data.substr(DescOffset, DescSize));
+      Offset = DescOffset + alignTo(DescSize, 4);
+    }
+  }
+  return "";
+}
+
+std::string SymbolizationCache::getBuildID(const ObjectFile &Obj) {
+  if (auto *MachO = dyn_cast<MachOObjectFile>(&Obj)) {
+    ArrayRef<uint8_t> UUID = MachO->getUuid();
+    return toHex(StringRef(reinterpret_cast<const char *>(UUID.data()),
+                           UUID.size()));
+  }
+  if (auto *COFF = dyn_cast<COFFObjectFile>(&Obj)) {
+    const codeview::DebugInfo *DebugInfo;
+    StringRef PDBFileName;
+    if (COFF->getDebugPDBInfo(DebugInfo, PDBFileName) || !DebugInfo ||
+        DebugInfo->Signature.CVSignature != OMF::Signature::PDB70)
+      return "";
+    const codeview::PDB70DebugInfo &PDB70 = DebugInfo->PDB70;
+    return toHex(StringRef(reinterpret_cast<const char *>(PDB70.Signature),
+                           sizeof(PDB70.Signature))) +
+           utohexstr(PDB70.Age);
+  }
+  if (isa<ELFObjectFileBase>(&Obj))
+    return getELFBuildID(Obj);
+  return "";
+}
+
+std::unique_ptr<SymbolizationCache>
+SymbolizationCache::create(StringRef CacheDir, StringRef BuildID,
+                           uint32_t OptionsFingerprint) {
+  SmallString<128> Path(CacheDir);
+  sys::path::append(Path, BuildID + "-" + utohexstr(OptionsFingerprint) +
+                              ".symcache");
+  std::unique_ptr<SymbolizationCache> Cache(new SymbolizationCache(Path.str()));
+  Cache->load();
+  return Cache;
+}
+
+void SymbolizationCache::load() {
+  Buffer.reset();
+  Entries = {};
+  Frames = {};
+  StringTable = StringRef();
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
+  if (!BufOrErr)
+    return;
+  StringRef Data = (*BufOrErr)->getBuffer();
+  if (Data.size() < sizeof(FileHeader))
+    return;
+  const auto *Header = reinterpret_cast<const FileHeader *>(Data.data());
+  if (memcmp(Header->Magic, CacheMagic, sizeof(CacheMagic)) ||
+      Header->Version != CacheVersion)
+    return;
+  uint64_t EntriesSize = uint64_t(Header->NumEntries) * sizeof(FileEntry);
+  uint64_t FramesSize = uint64_t(Header->NumFrames) * sizeof(FileFrame);
+  uint64_t StringsSize = Header->StringTableSize;
+  if (sizeof(FileHeader) + EntriesSize + FramesSize + StringsSize !=
+      Data.size())
+    return;
+  // Every string is null terminated, so the table must be too.
+  if (StringsSize && Data.back() != '\0')
+    return;
+
+  const char *Ptr = Data.data() + sizeof(FileHeader);
+  Entries = makeArrayRef(reinterpret_cast<const FileEntry *>(Ptr),
+                         Header->NumEntries);
+  Ptr += EntriesSize;
+  Frames = makeArrayRef(reinterpret_cast<const FileFrame *>(Ptr),
+                        Header->NumFrames);
+  Ptr += FramesSize;
+  StringTable = StringRef(Ptr, StringsSize);
+  Buffer = std::move(*BufOrErr);
+}
+
+StringRef SymbolizationCache::readString(uint32_t Offset) const {
+  if (Offset >= StringTable.size())
+    return "";
+  return StringRef(StringTable.data() + Offset);
+}
+
+DILineInfo SymbolizationCache::readFrame(const FileFrame &F) const {
+  DILineInfo Info;
+  Info.FileName = readString(F.FileName);
+  Info.FunctionName = readString(F.FunctionName);
+  Info.Line = F.Line;
+  Info.Column = F.Column;
+  Info.StartLine = F.StartLine;
+  Info.Discriminator = F.Discriminator;
+  return Info;
+}
+
+void SymbolizationCache::readFrames(const FileEntry &E,
+                                    DIInliningInfo &Result) const {
+  Result = DIInliningInfo();
+  for (const FileFrame &F : Frames.slice(E.FirstFrame, E.NumFrames))
+    Result.addFrame(readFrame(F));
+}
+
+bool SymbolizationCache::lookup(EntryKind Kind, uint64_t Address,
+                                DIInliningInfo &Result) const {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  // Ranges do not overlap, so the only candidate is the last range of the
+  // kind that starts at or before Address.
+  auto NI = NewEntries.upper_bound(EntryKey(Kind, Address));
+  if (NI != NewEntries.begin()) {
+    --NI;
+    if (NI->first.first == Kind && Address < NI->second.End) {
+      Result = NI->second.Info;
+      return true;
+    }
+  }
+
+  auto I = std::upper_bound(Entries.begin(), Entries.end(),
+                            EntryKey(Kind, Address),
+                            [](EntryKey K, const FileEntry &E) {
+                              return K < EntryKey(E.Kind, E.Begin);
+                            });
+  if (I == Entries.begin())
+    return false;
+  --I;
+  if (I->Kind != Kind || Address >= I->End)
+    return false;
+  if (uint64_t(I->FirstFrame) + I->NumFrames > Frames.size())
+    return false;
+  readFrames(*I, Result);
+  return true;
+}
+
+bool SymbolizationCache::lookupCode(uint64_t Address,
+                                    DILineInfo &Result) const {
+  DIInliningInfo Info;
+  if (!lookup(Code, Address, Info) || Info.getNumberOfFrames() != 1)
+    return false;
+  Result = Info.getFrame(0);
+  return true;
+}
+
+bool SymbolizationCache::lookupInlinedCode(uint64_t Address,
+                                           DIInliningInfo &Result) const {
+  return lookup(InlinedCode, Address, Result);
+}
+
+void SymbolizationCache::add(EntryKind Kind, uint64_t Begin, uint64_t End,
+                             DIInliningInfo Info) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (Begin >= End)
+    return;
+  Entry &E = NewEntries[EntryKey(Kind, Begin)];
+  E.End = End;
+  E.Info = std::move(Info);
+}
+
+void SymbolizationCache::addCode(uint64_t Begin, uint64_t End,
+                                 const DILineInfo &Info) {
+  DIInliningInfo Chain;
+  Chain.addFrame(Info);
+  add(Code, Begin, End, std::move(Chain));
+}
+
+void SymbolizationCache::addInlinedCode(uint64_t Begin, uint64_t End,
+                                        const DIInliningInfo &Info) {
+  add(InlinedCode, Begin, End, Info);
+}
+
+Error SymbolizationCache::save() {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (NewEntries.empty())
+    return Error::success();
+
+  // Merge the entries already on disk with the new ones. The file is rewritten
+  // from scratch, so its mapping can be dropped afterwards.
+  std::map<EntryKey, Entry> AllEntries = std::move(NewEntries);
+  NewEntries.clear();
+  for (const FileEntry &E : Entries) {
+    EntryKey Key(E.Kind, E.Begin);
+    if (AllEntries.count(Key) ||
+        uint64_t(E.FirstFrame) + E.NumFrames > Frames.size())
+      continue;
+    Entry &NewEntry = AllEntries[Key];
+    NewEntry.End = E.End;
+    readFrames(E, NewEntry.Info);
+  }
+  // Ranges computed from the same binary never partially overlap, but keep
+  // the table searchable even if a damaged file says otherwise.
+  for (auto I = AllEntries.begin(); I != AllEntries.end();) {
+    auto Next = std::next(I);
+    if (Next != AllEntries.end() && Next->first.first == I->first.first &&
+        Next->first.second < I->second.End)
+      AllEntries.erase(Next);
+    else
+      I = Next;
+  }
+
+  StringMap<uint32_t> StringOffsets;
+  std::string Strings;
+  auto AddString = [&](const std::string &S) -> uint32_t {
+    auto R = StringOffsets.insert(std::make_pair(S, Strings.size()));
+    if (R.second) {
+      Strings += S;
+      Strings.push_back('\0');
+    }
+    return R.first->second;
+  };
+
+  uint32_t NumFrames = 0;
+  for (const auto &KV : AllEntries)
+    NumFrames += KV.second.Info.getNumberOfFrames();
+
+  SmallString<128> TempPath;
+  int FD;
+  if (auto EC = sys::fs::create_directories(sys::path::parent_path(Path)))
+    return errorCodeToError(EC);
+  if (auto EC = sys::fs::createUniqueFile(Path + ".tmp%%%%%%", FD, TempPath))
+    return errorCodeToError(EC);
+
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    support::endian::Writer<support::little> W(OS);
+    OS.write(CacheMagic, sizeof(CacheMagic));
+    W.write<uint32_t>(CacheVersion);
+    W.write<uint32_t>(AllEntries.size());
+    W.write<uint32_t>(NumFrames);
+    // The string table size is not known yet; it is patched below.
+    uint64_t StringTableSizeOffset = OS.tell();
+    W.write<uint32_t>(0);
+
+    uint32_t FirstFrame = 0;
+    for (const auto &KV : AllEntries) {
+      uint32_t Count = KV.second.Info.getNumberOfFrames();
+      W.write<uint64_t>(KV.first.second);
+      W.write<uint64_t>(KV.second.End);
+      W.write<uint32_t>(KV.first.first);
+      W.write<uint32_t>(FirstFrame);
+      W.write<uint32_t>(Count);
+      W.write<uint32_t>(0);
+      FirstFrame += Count;
+    }
+    for (const auto &KV : AllEntries) {
+      const DIInliningInfo &Info = KV.second.Info;
+      for (uint32_t I = 0, E = Info.getNumberOfFrames(); I != E; ++I) {
+        const DILineInfo &Frame = Info.getFrame(I);
+        W.write<uint32_t>(AddString(Frame.FileName));
+        W.write<uint32_t>(AddString(Frame.FunctionName));
+        W.write<uint32_t>(Frame.Line);
+        W.write<uint32_t>(Frame.Column);
+        W.write<uint32_t>(Frame.StartLine);
+        W.write<uint32_t>(Frame.Discriminator);
+      }
+    }
+    OS << Strings;
+
+    OS.seek(StringTableSizeOffset);
+    W.write<uint32_t>(Strings.size());
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return make_error<StringError>("cannot write symbolization cache " +
+                                         TempPath,
+                                     inconvertibleErrorCode());
+    }
+  }
+
+  Buffer.reset();
+  Entries = {};
+  Frames = {};
+  StringTable = StringRef();
+  if (auto EC = sys::fs::rename(TempPath, Path)) {
+    sys::fs::remove(TempPath);
+    return errorCodeToError(EC);
+  }
+  load();
+  return Error::success();
+}
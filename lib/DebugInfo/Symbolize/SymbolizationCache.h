@@ -0,0 +1,149 @@
+//===- SymbolizationCache.h -------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the SymbolizationCache class, a persistent on-disk table
+// of symbolization results for a single binary.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZATIONCACHE_H
+#define LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZATIONCACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace llvm {
+
+namespace object {
+class ObjectFile;
+} // end namespace object
+
+namespace symbolize {
+
+/// Caches the results of code symbolization queries against one binary.
+///
+/// A cache file holds a table of non-overlapping address ranges sorted by
+/// their start, each of which refers to a run of frames (one frame for plain
+/// queries, the whole inlining chain for inlined queries) that is the result
+/// for every address in the range, followed by a string table. The file is
+/// mapped into memory and binary searched in place, so a lookup that hits
+/// never needs to parse any debug info, even for an address that was never
+/// queried before. Results computed during this session are kept in memory
+/// and merged into the file by save().
+///
+/// Cache files are named after the build ID of the binary and a fingerprint of
+/// the options that affect the output, so a rebuilt binary or a different set
+/// of options never sees stale results.
+///
+/// Lookups and additions may be made from several threads at once.
+class SymbolizationCache {
+public:
+  /// Returns the build ID of \p Obj (the GNU build-id note on ELF, the UUID on
+  /// Mach-O, the PDB signature and age on COFF), or an empty string if it has
+  /// none.
+  static std::string getBuildID(const object::ObjectFile &Obj);
+
+  /// Opens the cache for the binary with the given build ID in \p CacheDir.
+  /// A missing or malformed cache file yields an empty cache.
+  static std::unique_ptr<SymbolizationCache>
+  create(StringRef CacheDir, StringRef BuildID, uint32_t OptionsFingerprint);
+
+  bool lookupCode(uint64_t Address, DILineInfo &Result) const;
+  bool lookupInlinedCode(uint64_t Address, DIInliningInfo &Result) const;
+
+  /// Records \p Info as the result for the addresses in [Begin, End).
+  void addCode(uint64_t Begin, uint64_t End, const DILineInfo &Info);
+  void addInlinedCode(uint64_t Begin, uint64_t End,
+                      const DIInliningInfo &Info);
+
+  /// Writes the cached entries, old and new, back to disk. The file is
+  /// replaced atomically, so concurrent readers see either the old or the new
+  /// contents. Does nothing if no new entries were added.
+  Error save();
+
+private:
+  enum EntryKind : uint32_t { Code = 0, InlinedCode = 1 };
+
+  struct FileHeader {
+    char Magic[8];
+    support::ulittle32_t Version;
+    support::ulittle32_t NumEntries;
+    support::ulittle32_t NumFrames;
+    support::ulittle32_t StringTableSize;
+  };
+
+  struct FileEntry {
+    support::ulittle64_t Begin;
+    support::ulittle64_t End;
+    support::ulittle32_t Kind;
+    support::ulittle32_t FirstFrame;
+    support::ulittle32_t NumFrames;
+    support::ulittle32_t Reserved;
+  };
+
+  struct FileFrame {
+    support::ulittle32_t FileName;
+    support::ulittle32_t FunctionName;
+    support::ulittle32_t Line;
+    support::ulittle32_t Column;
+    support::ulittle32_t StartLine;
+    support::ulittle32_t Discriminator;
+  };
+
+  /// The kind and the start address of a range.
+  using EntryKey = std::pair<uint32_t, uint64_t>;
+
+  struct Entry {
+    uint64_t End;
+    DIInliningInfo Info;
+  };
+
+  SymbolizationCache(std::string Path) : Path(std::move(Path)) {}
+
+  /// Maps the existing cache file, if any and if it is well formed.
+  void load();
+
+  /// Looks up the range of the given kind holding \p Address in the new
+  /// entries, then in the mapped file.
+  bool lookup(EntryKind Kind, uint64_t Address, DIInliningInfo &Result) const;
+
+  void add(EntryKind Kind, uint64_t Begin, uint64_t End, DIInliningInfo Info);
+
+  void readFrames(const FileEntry &E, DIInliningInfo &Result) const;
+  DILineInfo readFrame(const FileFrame &F) const;
+  StringRef readString(uint32_t Offset) const;
+
+  std::string Path;
+
+  /// Mapped contents of the cache file as of create().
+  std::unique_ptr<MemoryBuffer> Buffer;
+  ArrayRef<FileEntry> Entries;
+  ArrayRef<FileFrame> Frames;
+  StringRef StringTable;
+
+  /// Entries computed during this session, not yet written to disk.
+  std::map<EntryKey, Entry> NewEntries;
+
+  /// Guards NewEntries and the mapped file, which save() replaces.
+  mutable std::mutex Mutex;
+};
+
+} // end namespace symbolize
+} // end namespace llvm
+
+#endif // LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZATIONCACHE_H
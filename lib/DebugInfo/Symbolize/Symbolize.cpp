@@ -14,8 +14,11 @@
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 
 #include "SymbolizableObjectFile.h"
+#include "SymbolizationCache.h"
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/Config/config.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
@@ -30,8 +33,11 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
@@ -53,9 +59,66 @@
 namespace llvm {
 namespace symbolize {
 
+LLVMSymbolizer::LLVMSymbolizer(const Options &Opts) : Opts(Opts) {}
+
+LLVMSymbolizer::~LLVMSymbolizer() {
+  flush();
+}
+
+DILineInfo
+LLVMSymbolizer::symbolizeCodeInModule(SymbolizableModule *Info,
+                                      uint64_t ModuleOffset) const {
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info->getModulePreferredBase();
+
+  DILineInfo LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
+                                            Opts.UseSymbolTable);
+  if (Opts.Demangle)
+    LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
+  return LineInfo;
+}
+
+DIInliningInfo
+LLVMSymbolizer::symbolizeInlinedCodeInModule(SymbolizableModule *Info,
+                                             uint64_t ModuleOffset) const {
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info->getModulePreferredBase();
+
+  DIInliningInfo InlinedContext = Info->symbolizeInlinedCode(
+      ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
+  if (Opts.Demangle) {
+    for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
+      auto *Frame = InlinedContext.getMutableFrame(i);
+      Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
+    }
+  }
+  return InlinedContext;
+}
+
+std::pair<uint64_t, uint64_t>
+LLVMSymbolizer::getCodeRange(SymbolizableModule *Info,
+                             uint64_t ModuleOffset) const {
+  uint64_t Base = Opts.RelativeAddresses ? Info->getModulePreferredBase() : 0;
+  // Every module is created by getOrCreateModuleInfo() as a
+  // SymbolizableObjectFile.
+  std::pair<uint64_t, uint64_t> Range =
+      static_cast<SymbolizableObjectFile *>(Info)->getCodeRange(
+          ModuleOffset + Base, Opts.PrintFunctions, Opts.UseSymbolTable);
+  return {std::max(Range.first, Base) - Base, Range.second - Base};
+}
+
 Expected<DILineInfo>
 LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                               uint64_t ModuleOffset, StringRef DWPName) {
+  SymbolizationCache *Cache = getOrCreateCache(ModuleName, DWPName);
+  DILineInfo LineInfo;
+  if (Cache && Cache->lookupCode(ModuleOffset, LineInfo))
+    return LineInfo;
+
   SymbolizableModule *Info;
   if (auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName))
     Info = InfoOrErr.get();
@@ -67,21 +130,22 @@ LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   if (!Info)
     return DILineInfo();
 
-  // If the user is giving us relative addresses, add the preferred base of the
-  // object to the offset before we do the query. It's what DIContext expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
-
-  DILineInfo LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
-                                            Opts.UseSymbolTable);
-  if (Opts.Demangle)
-    LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
+  LineInfo = symbolizeCodeInModule(Info, ModuleOffset);
+  if (Cache) {
+    std::pair<uint64_t, uint64_t> Range = getCodeRange(Info, ModuleOffset);
+    Cache->addCode(Range.first, Range.second, LineInfo);
+  }
   return LineInfo;
 }
 
 Expected<DIInliningInfo>
 LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
                                      uint64_t ModuleOffset, StringRef DWPName) {
+  SymbolizationCache *Cache = getOrCreateCache(ModuleName, DWPName);
+  DIInliningInfo InlinedContext;
+  if (Cache && Cache->lookupInlinedCode(ModuleOffset, InlinedContext))
+    return InlinedContext;
+
   SymbolizableModule *Info;
   if (auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName))
     Info = InfoOrErr.get();
@@ -93,18 +157,10 @@ LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
   if (!Info)
     return DIInliningInfo();
 
-  // If the user is giving us relative addresses, add the preferred base of the
-  // object to the offset before we do the query. It's what DIContext expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
-
-  DIInliningInfo InlinedContext = Info->symbolizeInlinedCode(
-      ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
-  if (Opts.Demangle) {
-    for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
-      auto *Frame = InlinedContext.getMutableFrame(i);
-      Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
-    }
+  InlinedContext = symbolizeInlinedCodeInModule(Info, ModuleOffset);
+  if (Cache) {
+    std::pair<uint64_t, uint64_t> Range = getCodeRange(Info, ModuleOffset);
+    Cache->addInlinedCode(Range.first, Range.second, InlinedContext);
   }
   return InlinedContext;
 }
@@ -134,7 +190,163 @@ Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   return Global;
 }
 
+// A module's sorted addresses are split into chunks of at least this many
+// addresses, each resolved with a DWARF context of its own. Smaller chunks are
+// not worth parsing the same compile units again.
+static const size_t MinRequestsPerContext = 64;
+
+template <typename T>
+std::vector<Expected<T>> LLVMSymbolizer::symbolizeBatch(
+    ArrayRef<SymbolizeRequest> Requests, StringRef DWPName, unsigned Threads,
+    function_ref<bool(SymbolizationCache &, uint64_t, T &)> Lookup,
+    function_ref<T(SymbolizableModule *, uint64_t)> Compute,
+    function_ref<void(SymbolizationCache &, uint64_t, uint64_t, const T &)>
+        Add) {
+  std::vector<Optional<Expected<T>>> Results(Requests.size());
+
+  // Group the requests by module, keeping the modules in the order in which
+  // they first appear.
+  StringMap<unsigned> ModuleIndex;
+  std::vector<std::vector<size_t>> ModuleRequests;
+  for (size_t I = 0, E = Requests.size(); I != E; ++I) {
+    auto R = ModuleIndex.insert(
+        std::make_pair(Requests[I].ModuleName, ModuleRequests.size()));
+    if (R.second)
+      ModuleRequests.emplace_back();
+    ModuleRequests[R.first->second].push_back(I);
+  }
+
+  if (Threads == 0)
+    Threads = heavyweight_hardware_concurrency();
+  std::unique_ptr<ThreadPool> Pool;
+  if (Threads > 1)
+    Pool = llvm::make_unique<ThreadPool>(Threads);
+
+  auto RunChunk = [&](SymbolizableModule *Info, SymbolizationCache *Cache,
+                      ArrayRef<size_t> Indices) {
+    for (size_t I : Indices) {
+      uint64_t ModuleOffset = Requests[I].ModuleOffset;
+      T Result = Compute(Info, ModuleOffset);
+      if (Cache) {
+        std::pair<uint64_t, uint64_t> Range = getCodeRange(Info, ModuleOffset);
+        Add(*Cache, Range.first, Range.second, Result);
+      }
+      Results[I].emplace(std::move(Result));
+    }
+  };
+
+  // Answers what the cache can, loads the module and resolves the rest. The
+  // misses are left in Indices, which outlives the chunks handed to the pool.
+  auto RunModule = [&](std::vector<size_t> &Indices) {
+    const std::string &ModuleName = Requests[Indices.front()].ModuleName;
+    SymbolizationCache *Cache = getOrCreateCache(ModuleName, DWPName);
+    std::vector<size_t> Misses;
+    for (size_t I : Indices) {
+      T Result;
+      if (Cache && Lookup(*Cache, Requests[I].ModuleOffset, Result))
+        Results[I].emplace(std::move(Result));
+      else
+        Misses.push_back(I);
+    }
+    if (Misses.empty())
+      return;
+
+    auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName);
+    if (!InfoOrErr || !InfoOrErr.get()) {
+      // A null module means an error has already been reported. Return an
+      // empty result.
+      if (!InfoOrErr)
+        Results[Misses.front()].emplace(InfoOrErr.takeError());
+      for (size_t I : Misses)
+        if (!Results[I])
+          Results[I].emplace(T());
+      return;
+    }
+    SymbolizableModule *Info = InfoOrErr.get();
+
+    // Line tables and DIEs are parsed lazily per compile unit, so resolving
+    // the addresses in order keeps the queries against each unit together.
+    std::stable_sort(Misses.begin(), Misses.end(), [&](size_t A, size_t B) {
+      return Requests[A].ModuleOffset < Requests[B].ModuleOffset;
+    });
+    Indices = std::move(Misses);
+
+    // Every module is created by getOrCreateModuleInfo() as a
+    // SymbolizableObjectFile.
+    size_t NumChunks = 1;
+    if (Pool && static_cast<SymbolizableObjectFile *>(Info)->hasDWARFContext())
+      NumChunks = std::max<size_t>(
+          1, std::min<size_t>(Threads, Indices.size() / MinRequestsPerContext));
+    ArrayRef<size_t> All = Indices;
+    size_t ChunkSize = (All.size() + NumChunks - 1) / NumChunks;
+    for (size_t Begin = ChunkSize; Begin < All.size(); Begin += ChunkSize) {
+      ArrayRef<size_t> Chunk =
+          All.slice(Begin, std::min(ChunkSize, All.size() - Begin));
+      Pool->async([&, Info, Cache, Chunk]() {
+        std::unique_ptr<SymbolizableModule> Private = createDWARFModuleInfo(
+            Requests[Chunk.front()].ModuleName, DWPName);
+        RunChunk(Private ? Private.get() : Info, Cache, Chunk);
+      });
+    }
+    RunChunk(Info, Cache, All.take_front(ChunkSize));
+  };
+
+  if (!Pool) {
+    for (std::vector<size_t> &Indices : ModuleRequests)
+      RunModule(Indices);
+  } else {
+    for (std::vector<size_t> &Indices : ModuleRequests)
+      Pool->async([&RunModule, &Indices]() { RunModule(Indices); });
+    Pool->wait();
+  }
+
+  std::vector<Expected<T>> Ret;
+  Ret.reserve(Results.size());
+  for (Optional<Expected<T>> &Result : Results)
+    Ret.push_back(std::move(*Result));
+  return Ret;
+}
+
+std::vector<Expected<DILineInfo>>
+LLVMSymbolizer::symbolizeCode(ArrayRef<SymbolizeRequest> Requests,
+                              StringRef DWPName, unsigned Threads) {
+  return symbolizeBatch<DILineInfo>(
+      Requests, DWPName, Threads,
+      [](SymbolizationCache &Cache, uint64_t ModuleOffset, DILineInfo &Result) {
+        return Cache.lookupCode(ModuleOffset, Result);
+      },
+      [this](SymbolizableModule *Info, uint64_t ModuleOffset) {
+        return symbolizeCodeInModule(Info, ModuleOffset);
+      },
+      [](SymbolizationCache &Cache, uint64_t Begin, uint64_t End,
+         const DILineInfo &Result) { Cache.addCode(Begin, End, Result); });
+}
+
+std::vector<Expected<DIInliningInfo>>
+LLVMSymbolizer::symbolizeInlinedCode(ArrayRef<SymbolizeRequest> Requests,
+                                     StringRef DWPName, unsigned Threads) {
+  return symbolizeBatch<DIInliningInfo>(
+      Requests, DWPName, Threads,
+      [](SymbolizationCache &Cache, uint64_t ModuleOffset,
+         DIInliningInfo &Result) {
+        return Cache.lookupInlinedCode(ModuleOffset, Result);
+      },
+      [this](SymbolizableModule *Info, uint64_t ModuleOffset) {
+        return symbolizeInlinedCodeInModule(Info, ModuleOffset);
+      },
+      [](SymbolizationCache &Cache, uint64_t Begin, uint64_t End,
+         const DIInliningInfo &Result) {
+        Cache.addInlinedCode(Begin, End, Result);
+      });
+}
+
 void LLVMSymbolizer::flush() {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  // The cache is only an accelerator; failing to update it is not an error.
+  for (auto &KV : Caches)
+    if (KV.second)
+      consumeError(KV.second->save());
+  Caches.clear();
   ObjectForUBPathAndArch.clear();
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
@@ -364,13 +576,8 @@ LLVMSymbolizer::getOrCreateObject(const std::string &Path,
   return errorCodeToError(object_error::arch_not_found);
 }
 
-Expected<SymbolizableModule *>
-LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
-                                      StringRef DWPName) {
-  const auto &I = Modules.find(ModuleName);
-  if (I != Modules.end()) {
-    return I->second.get();
-  }
+std::pair<std::string, std::string>
+LLVMSymbolizer::getBinaryAndArchName(const std::string &ModuleName) const {
   std::string BinaryName = ModuleName;
   std::string ArchName = Opts.DefaultArch;
   size_t ColonPos = ModuleName.find_last_of(':');
@@ -382,6 +589,73 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
       ArchName = ArchStr;
     }
   }
+  return std::make_pair(BinaryName, ArchName);
+}
+
+uint32_t LLVMSymbolizer::getCacheFingerprint(StringRef DWPName) const {
+  // Cached results depend on every option that changes the output, including
+  // where the debug info is looked up.
+  MD5 Hash;
+  uint8_t Flags = static_cast<uint8_t>(Opts.PrintFunctions) |
+                  Opts.UseSymbolTable << 2 | Opts.Demangle << 3 |
+                  Opts.RelativeAddresses << 4;
+  Hash.update(Flags);
+  // Terminate every string, so that different lists never hash the same.
+  auto AddString = [&](StringRef S) {
+    Hash.update(S);
+    Hash.update(StringRef("", 1));
+  };
+  AddString(Opts.DefaultArch);
+  AddString(DWPName);
+  for (const std::string &Hint : Opts.DsymHints)
+    AddString(Hint);
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return static_cast<uint32_t>(Result.low());
+}
+
+SymbolizationCache *
+LLVMSymbolizer::getOrCreateCache(const std::string &ModuleName,
+                                 StringRef DWPName) {
+  if (Opts.CachePath.empty())
+    return nullptr;
+  std::lock_guard<std::mutex> Lock(Mutex);
+  const auto &I = Caches.find(ModuleName);
+  if (I != Caches.end())
+    return I->second.get();
+
+  std::unique_ptr<SymbolizationCache> Cache;
+  std::string BinaryName, ArchName;
+  std::tie(BinaryName, ArchName) = getBinaryAndArchName(ModuleName);
+  auto ObjOrErr = getOrCreateObject(BinaryName, ArchName);
+  if (!ObjOrErr) {
+    // Forget the failure, so that it is reported when the module itself is
+    // loaded.
+    consumeError(ObjOrErr.takeError());
+    ObjectForUBPathAndArch.erase(std::make_pair(BinaryName, ArchName));
+    const auto &BI = BinaryForPath.find(BinaryName);
+    if (BI != BinaryForPath.end() && !BI->second.getBinary())
+      BinaryForPath.erase(BI);
+  } else if (ObjectFile *Obj = ObjOrErr.get()) {
+    std::string BuildID = SymbolizationCache::getBuildID(*Obj);
+    if (!BuildID.empty())
+      Cache = SymbolizationCache::create(Opts.CachePath, BuildID,
+                                         getCacheFingerprint(DWPName));
+  }
+  return Caches.insert(std::make_pair(ModuleName, std::move(Cache)))
+      .first->second.get();
+}
+
+Expected<SymbolizableModule *>
+LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
+                                      StringRef DWPName) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  const auto &I = Modules.find(ModuleName);
+  if (I != Modules.end()) {
+    return I->second.get();
+  }
+  std::string BinaryName, ArchName;
+  std::tie(BinaryName, ArchName) = getBinaryAndArchName(ModuleName);
   auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
   if (!ObjectsOrErr) {
     // Failed to find valid object file.
@@ -427,6 +701,30 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
   return InsertResult.first->second.get();
 }
 
+std::unique_ptr<SymbolizableModule>
+LLVMSymbolizer::createDWARFModuleInfo(const std::string &ModuleName,
+                                      StringRef DWPName) {
+  ObjectPair Objects;
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    std::string BinaryName, ArchName;
+    std::tie(BinaryName, ArchName) = getBinaryAndArchName(ModuleName);
+    auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
+    if (!ObjectsOrErr) {
+      consumeError(ObjectsOrErr.takeError());
+      return nullptr;
+    }
+    Objects = ObjectsOrErr.get();
+  }
+  auto InfoOrErr = SymbolizableObjectFile::create(
+      Objects.first,
+      DWARFContext::create(*Objects.second, nullptr,
+                           DWARFContext::defaultErrorHandler, DWPName));
+  if (!InfoOrErr)
+    return nullptr;
+  return std::move(InfoOrErr.get());
+}
+
 namespace {
 
 // Undo these various manglings for Win32 extern "C" functions:
@@ -483,7 +781,10 @@ LLVMSymbolizer::DemangleName(const std::string &Name,
   }
 #else
   if (!Name.empty() && Name.front() == '?') {
-    // Only do MSVC C++ demangling on symbols starting with '?'.
+    // Only do MSVC C++ demangling on symbols starting with '?'. DbgHelp is
+    // single-threaded.
+    static std::mutex DbgHelpMutex;
+    std::lock_guard<std::mutex> Lock(DbgHelpMutex);
     char DemangledName[1024] = {0};
     DWORD result = ::UnDecorateSymbolName(
         Name.c_str(), DemangledName, 1023,
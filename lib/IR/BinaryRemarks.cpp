@@ -0,0 +1,290 @@
+//===- BinaryRemarks.cpp - Binary optimization remarks format -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and writer of the binary optimization remarks
+// format, and the conversion of remarks to YAML.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/BinaryRemarks.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cassert>
+#include <cstring>
+
+using namespace llvm;
+using namespace remarks;
+
+static const char Magic[8] = {'L', 'L', 'V', 'M', 'R', 'M', 'R', 'K'};
+
+bool remarks::isBinaryRemarks(StringRef Data) {
+  return Data.startswith(StringRef(Magic, sizeof(Magic)));
+}
+
+void Writer::setStr(storage::Str &S, StringRef Value) {
+  auto R = StrtabOffsets.insert({Value, Strtab.size()});
+  if (R.second)
+    Strtab += Value;
+  S.Offset = R.first->second;
+  S.Size = Value.size();
+}
+
+void Writer::setLoc(storage::Location &L,
+                    const Optional<RemarkLocation> &Loc) {
+  if (!Loc || Loc->File.empty()) {
+    setStr(L.File, "");
+    L.Line = 0;
+    L.Column = 0;
+    return;
+  }
+  setStr(L.File, Loc->File);
+  L.Line = Loc->Line;
+  L.Column = Loc->Column;
+}
+
+void Writer::emit(const Remark &R) {
+  assert(!Finalized && "Remark emitted after the file was written");
+  Remarks.emplace_back();
+  storage::Remark &Rec = Remarks.back();
+  Rec.Flags = unsigned(R.Kind) << storage::Remark::FB_kind;
+  if (R.Hotness)
+    Rec.Flags = Rec.Flags | (1 << storage::Remark::FB_has_hotness);
+  setStr(Rec.PassName, R.PassName);
+  setStr(Rec.RemarkName, R.RemarkName);
+  setStr(Rec.FunctionName, R.FunctionName);
+  setLoc(Rec.Loc, R.Loc);
+  Rec.Hotness = R.Hotness ? *R.Hotness : 0;
+
+  Rec.ArgsBegin = Args.size();
+  for (const RemarkArgument &A : R.Args) {
+    Args.emplace_back();
+    setStr(Args.back().Key, A.Key);
+    setStr(Args.back().Val, A.Val);
+    setLoc(Args.back().Loc, A.Loc);
+  }
+  Rec.ArgsEnd = Args.size();
+}
+
+template <typename T>
+static void setRange(storage::Range<T> &R, size_t Size, uint64_t &Offset) {
+  R.Offset = Offset;
+  R.Size = Size;
+  Offset += Size * sizeof(T);
+}
+
+void Writer::finalize() {
+  if (Finalized)
+    return;
+  Finalized = true;
+
+  storage::Header Hdr;
+  memcpy(Hdr.Magic, Magic, sizeof(Magic));
+  Hdr.Version = storage::Header::kCurrentVersion;
+
+  uint64_t Offset = sizeof(storage::Header);
+  setRange(Hdr.Remarks, Remarks.size(), Offset);
+  setRange(Hdr.Args, Args.size(), Offset);
+  setRange(Hdr.Strtab, Strtab.size(), Offset);
+  if (Offset > UINT32_MAX)
+    report_fatal_error("binary remarks file too large");
+
+  OS.write(reinterpret_cast<const char *>(&Hdr), sizeof(Hdr));
+  OS.write(reinterpret_cast<const char *>(Remarks.data()),
+           Remarks.size() * sizeof(storage::Remark));
+  OS.write(reinterpret_cast<const char *>(Args.data()),
+           Args.size() * sizeof(storage::Argument));
+  OS << Strtab;
+  OS.flush();
+
+  Remarks.clear();
+  Args.clear();
+  Strtab.clear();
+  StrtabOffsets.clear();
+}
+
+Reader::Reader(StringRef Data) {
+  const auto *Hdr = reinterpret_cast<const storage::Header *>(Data.data());
+  Remarks = Hdr->Remarks.get(Data);
+  Args = Hdr->Args.get(Data);
+  ArrayRef<char> Chars = Hdr->Strtab.get(Data);
+  Strtab = StringRef(Chars.data(), Chars.size());
+}
+
+template <typename T>
+static bool inBounds(storage::Range<T> R, StringRef Data) {
+  return uint64_t(R.Offset) + uint64_t(R.Size) * sizeof(T) <= Data.size();
+}
+
+static Error makeError(const Twine &Msg) {
+  return make_error<StringError>("Invalid binary remarks file: " + Msg,
+                                 inconvertibleErrorCode());
+}
+
+Expected<Reader> Reader::create(StringRef Data) {
+  if (!isBinaryRemarks(Data) || Data.size() < sizeof(storage::Header))
+    return makeError("bad header");
+  const auto *Hdr = reinterpret_cast<const storage::Header *>(Data.data());
+  if (Hdr->Version != storage::Header::kCurrentVersion)
+    return makeError("unsupported version " + Twine(Hdr->Version));
+
+  if (!inBounds(Hdr->Remarks, Data) || !inBounds(Hdr->Args, Data) ||
+      !inBounds(Hdr->Strtab, Data))
+    return makeError("table out of bounds");
+
+  // Check every string and range once here, so that reading the remarks
+  // doesn't need to.
+  Reader R(Data);
+  auto StrInBounds = [&](storage::Str S) {
+    return uint64_t(S.Offset) + S.Size <= R.Strtab.size();
+  };
+  for (const storage::Argument &A : R.Args)
+    if (!StrInBounds(A.Key) || !StrInBounds(A.Val) || !StrInBounds(A.Loc.File))
+      return makeError("argument string out of bounds");
+
+  uint32_t NextArg = 0;
+  for (const storage::Remark &Rec : R.Remarks) {
+    unsigned Kind = (Rec.Flags >> storage::Remark::FB_kind) & 15;
+    if (Kind > unsigned(RemarkKind::Failure))
+      return makeError("unknown remark kind " + Twine(Kind));
+    if (!StrInBounds(Rec.PassName) || !StrInBounds(Rec.RemarkName) ||
+        !StrInBounds(Rec.FunctionName) || !StrInBounds(Rec.Loc.File))
+      return makeError("remark string out of bounds");
+    if (Rec.ArgsBegin != NextArg || Rec.ArgsEnd < Rec.ArgsBegin ||
+        Rec.ArgsEnd > R.Args.size())
+      return makeError("bad argument range");
+    NextArg = Rec.ArgsEnd;
+  }
+  if (NextArg != R.Args.size())
+    return makeError("bad argument range");
+  return R;
+}
+
+Optional<RemarkLocation> Reader::loc(const storage::Location &L) const {
+  if (L.File.Size == 0)
+    return None;
+  RemarkLocation Loc;
+  Loc.File = str(L.File);
+  Loc.Line = L.Line;
+  Loc.Column = L.Column;
+  return Loc;
+}
+
+Remark Reader::getRemark(size_t I) const {
+  const storage::Remark &Rec = Remarks[I];
+  Remark R;
+  R.Kind = RemarkKind((Rec.Flags >> storage::Remark::FB_kind) & 15);
+  R.PassName = str(Rec.PassName);
+  R.RemarkName = str(Rec.RemarkName);
+  R.FunctionName = str(Rec.FunctionName);
+  R.Loc = loc(Rec.Loc);
+  if ((Rec.Flags >> storage::Remark::FB_has_hotness) & 1)
+    R.Hotness = uint64_t(Rec.Hotness);
+  for (const storage::Argument &A :
+       Args.slice(Rec.ArgsBegin, Rec.ArgsEnd - Rec.ArgsBegin)) {
+    RemarkArgument Arg;
+    Arg.Key = str(A.Key);
+    Arg.Val = str(A.Val);
+    Arg.Loc = loc(A.Loc);
+    R.Args.push_back(Arg);
+  }
+  return R;
+}
+
+Expected<MappedFile> remarks::mapFile(StringRef Path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
+  if (!BufOrErr)
+    return errorCodeToError(BufOrErr.getError());
+
+  MappedFile Mapped;
+  Mapped.Buffer = std::move(*BufOrErr);
+  Expected<Reader> ReaderOrErr = Reader::create(Mapped.Buffer->getBuffer());
+  if (!ReaderOrErr)
+    return ReaderOrErr.takeError();
+  Mapped.TheReader = *ReaderOrErr;
+  return std::move(Mapped);
+}
+
+// The mappings below must produce the same records as the mapping of
+// DiagnosticInfoOptimizationBase in OptimizationDiagnosticInfo.cpp.
+
+namespace llvm {
+namespace yaml {
+
+template <> struct MappingTraits<RemarkLocation> {
+  static void mapping(IO &io, RemarkLocation &Loc) {
+    assert(io.outputting() && "input not yet implemented");
+    io.mapRequired("File", Loc.File);
+    io.mapRequired("Line", Loc.Line);
+    io.mapRequired("Column", Loc.Column);
+  }
+
+  static const bool flow = true;
+};
+
+template <> struct MappingTraits<RemarkArgument> {
+  static void mapping(IO &io, RemarkArgument &A) {
+    assert(io.outputting() && "input not yet implemented");
+    // The key is a string of the file, which isn't null terminated.
+    std::string Key = A.Key;
+    io.mapRequired(Key.c_str(), A.Val);
+    if (A.Loc)
+      io.mapOptional("DebugLoc", *A.Loc);
+  }
+};
+
+} // end namespace yaml
+} // end namespace llvm
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(RemarkArgument)
+
+namespace llvm {
+namespace yaml {
+
+template <> struct MappingTraits<Remark> {
+  static void mapping(IO &io, Remark &R) {
+    assert(io.outputting() && "input not yet implemented");
+
+    if (io.mapTag("!Passed", R.Kind == RemarkKind::Passed))
+      ;
+    else if (io.mapTag("!Missed", R.Kind == RemarkKind::Missed))
+      ;
+    else if (io.mapTag("!Analysis", R.Kind == RemarkKind::Analysis))
+      ;
+    else if (io.mapTag("!AnalysisFPCommute",
+                       R.Kind == RemarkKind::AnalysisFPCommute))
+      ;
+    else if (io.mapTag("!AnalysisAliasing",
+                       R.Kind == RemarkKind::AnalysisAliasing))
+      ;
+    else if (io.mapTag("!Failure", R.Kind == RemarkKind::Failure))
+      ;
+    else
+      llvm_unreachable("Unknown remark type");
+
+    io.mapRequired("Pass", R.PassName);
+    io.mapRequired("Name", R.RemarkName);
+    if (R.Loc)
+      io.mapOptional("DebugLoc", *R.Loc);
+    io.mapRequired("Function", R.FunctionName);
+    io.mapOptional("Hotness", R.Hotness);
+    io.mapOptional("Args", R.Args);
+  }
+};
+
+} // end namespace yaml
+} // end namespace llvm
+
+void remarks::writeYAML(yaml::Output &Out, const Remark &R) {
+  Remark Copy = R;
+  Out << Copy;
+}
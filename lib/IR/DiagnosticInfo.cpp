@@ -18,6 +18,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -200,6 +201,49 @@ void DiagnosticInfoOptimizationBase::print(DiagnosticPrinter &DP) const {
     DP << " (hotness: " << *Hotness << ")";
 }
 
+static Optional<remarks::RemarkLocation>
+getRemarkLocation(const DiagnosticLocation &DL) {
+  if (!DL.isValid())
+    return None;
+  remarks::RemarkLocation Loc;
+  Loc.File = DL.getFilename();
+  Loc.Line = DL.getLine();
+  Loc.Column = DL.getColumn();
+  return Loc;
+}
+
+remarks::Remark DiagnosticInfoOptimizationBase::getRemark() const {
+  remarks::Remark R;
+  if (isPassed())
+    R.Kind = remarks::RemarkKind::Passed;
+  else if (isMissed())
+    R.Kind = remarks::RemarkKind::Missed;
+  else if (isAnalysis())
+    R.Kind = remarks::RemarkKind::Analysis;
+  else if (getKind() == DK_OptimizationRemarkAnalysisFPCommute)
+    R.Kind = remarks::RemarkKind::AnalysisFPCommute;
+  else if (getKind() == DK_OptimizationRemarkAnalysisAliasing)
+    R.Kind = remarks::RemarkKind::AnalysisAliasing;
+  else if (getKind() == DK_OptimizationFailure)
+    R.Kind = remarks::RemarkKind::Failure;
+  else
+    llvm_unreachable("Unknown remark type");
+
+  R.PassName = PassName;
+  R.RemarkName = RemarkName;
+  R.FunctionName = GlobalValue::dropLLVMManglingEscape(getFunction().getName());
+  R.Loc = getRemarkLocation(getLocation());
+  R.Hotness = Hotness;
+  for (const Argument &Arg : Args) {
+    remarks::RemarkArgument A;
+    A.Key = Arg.Key;
+    A.Val = Arg.Val;
+    A.Loc = getRemarkLocation(Arg.Loc);
+    R.Args.push_back(A);
+  }
+  return R;
+}
+
 OptimizationRemark::OptimizationRemark(const char *PassName,
                                        StringRef RemarkName,
                                        const DiagnosticLocation &Loc,
@@ -165,6 +165,19 @@ void LLVMContext::setDiagnosticsOutputFile(std::unique_ptr<yaml::Output> F) {
   pImpl->DiagnosticsOutputFile = std::move(F);
 }
 
+remarks::Writer *LLVMContext::getDiagnosticsBinaryOutput() {
+  return pImpl->DiagnosticsBinaryOutput.get();
+}
+
+void LLVMContext::setDiagnosticsBinaryOutput(
+    std::unique_ptr<remarks::Writer> W) {
+  pImpl->DiagnosticsBinaryOutput = std::move(W);
+}
+
+bool LLVMContext::hasDiagnosticsOutput() const {
+  return pImpl->DiagnosticsOutputFile || pImpl->DiagnosticsBinaryOutput;
+}
+
 DiagnosticHandler::DiagnosticHandlerTy
 LLVMContext::getDiagnosticHandlerCallBack() const {
   return pImpl->DiagHandler->DiagHandlerCallback;
@@ -57,6 +57,47 @@ ModuleSummaryIndex::getGlobalValueSummary(uint64_t ValueGUID,
   return Summary.get();
 }
 
+void ModuleSummaryIndex::mergeFrom(ModuleSummaryIndex &Other) {
+  for (auto &Mod : Other.ModulePathStringTable)
+    addModule(Mod.first(), Mod.second.first, Mod.second.second);
+
+  // The summaries refer to values through pointers into the map of the index
+  // that owns them, so point them into this index's map instead.
+  auto Remap = [&](ValueInfo &VI) { VI = getOrInsertValueInfo(VI.getGUID()); };
+  for (auto &Entry : Other.GlobalValueMap) {
+    ValueInfo VI = getOrInsertValueInfo(Entry.first);
+    for (auto &Summary : Entry.second.SummaryList) {
+      for (ValueInfo &Ref : Summary->RefEdgeList)
+        Remap(Ref);
+      if (auto *FS = dyn_cast<FunctionSummary>(Summary.get()))
+        for (FunctionSummary::EdgeTy &Edge : FS->CallGraphEdgeList)
+          Remap(Edge.first);
+      Summary->setModulePath(
+          ModulePathStringTable.find(Summary->modulePath())->first());
+      const_cast<GlobalValueSummaryMapTy::value_type *>(VI.Ref)
+          ->second.SummaryList.push_back(std::move(Summary));
+    }
+  }
+
+  // Within Other, an original name maps to 0 if it maps to several GUIDs,
+  // which addOriginalName() preserves.
+  for (auto &Names : Other.OidGuidMap)
+    addOriginalName(Names.second, Names.first);
+  for (auto &TypeId : Other.TypeIdMap)
+    TypeIdMap.insert(std::move(TypeId));
+  CfiFunctionDefs.insert(Other.CfiFunctionDefs.begin(),
+                         Other.CfiFunctionDefs.end());
+  CfiFunctionDecls.insert(Other.CfiFunctionDecls.begin(),
+                          Other.CfiFunctionDecls.end());
+
+  Other.GlobalValueMap.clear();
+  Other.ModulePathStringTable.clear();
+  Other.TypeIdMap.clear();
+  Other.OidGuidMap.clear();
+  Other.CfiFunctionDefs.clear();
+  Other.CfiFunctionDecls.clear();
+}
+
 bool ModuleSummaryIndex::isGUIDLive(GlobalValue::GUID GUID) const {
   auto VI = getValueInfo(GUID);
   if (!VI)
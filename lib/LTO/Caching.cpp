@@ -13,11 +13,19 @@
 
 #include "llvm/LTO/Caching.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <chrono>
+#include <cstring>
 
 using namespace llvm;
 using namespace llvm::lto;
@@ -99,3 +107,276 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
     };
   };
 }
+
+namespace {
+
+/// Header of the objects written by compressedLocalCache(), whose file names
+/// start with "llvmcache-z-". The header is followed by the contents of the
+/// object, compressed with zlib if the Compressed flag is set.
+///
+/// Reading an object to check its header changes its access time, so these
+/// objects record their last use in their modification time instead, which
+/// the cache updates on every hit.
+struct CompressedCacheEntryHeader {
+  enum : uint32_t { Compressed = 1 };
+
+  char Magic[8];
+  /// The size of the contents once decompressed.
+  support::ulittle64_t Size;
+  /// The xxHash64 of the decompressed contents.
+  support::ulittle64_t Hash;
+  /// The time it took to create the entry, in milliseconds.
+  support::ulittle32_t CostMs;
+  support::ulittle32_t Flags;
+
+  static const char ExpectedMagic[8];
+};
+
+} // end anonymous namespace
+
+const char CompressedCacheEntryHeader::ExpectedMagic[8] = {'L', 'L', 'V', 'M',
+                                                           'C', 'O', 'B', 'J'};
+
+static bool isCompressedObject(StringRef Path) {
+  return sys::path::filename(Path).startswith("llvmcache-z-");
+}
+
+/// Read the cost recorded in the header of the compressed object at Path.
+static Optional<uint32_t> readObjectCost(StringRef Path) {
+  uint64_t FileSize;
+  if (!isCompressedObject(Path) || sys::fs::file_size(Path, FileSize) ||
+      FileSize < sizeof(CompressedCacheEntryHeader))
+    return None;
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr = MemoryBuffer::getFileSlice(
+      Path, sizeof(CompressedCacheEntryHeader), /*Offset=*/0);
+  if (!MBOrErr)
+    return None;
+  const auto *Header = reinterpret_cast<const CompressedCacheEntryHeader *>(
+      (*MBOrErr)->getBufferStart());
+  if (memcmp(Header->Magic, CompressedCacheEntryHeader::ExpectedMagic,
+             sizeof(Header->Magic)))
+    return None;
+  return uint32_t(Header->CostMs);
+}
+
+void lto::setCompressedCachePruningCallbacks(CachePruningPolicy &Policy) {
+  Policy.GetEntryCost = readObjectCost;
+  Policy.UsesModificationTime = isCompressedObject;
+}
+
+/// Write the concatenation of Parts to Path, through a temporary file in
+/// CacheDirectoryPath so that readers never see a partially written file.
+static std::error_code writeFileAtomically(StringRef CacheDirectoryPath,
+                                           StringRef Path,
+                                           ArrayRef<StringRef> Parts) {
+  int TempFD;
+  SmallString<64> TempFilenameModel, TempFilename;
+  sys::path::append(TempFilenameModel, CacheDirectoryPath, "Thin-%%%%%%.tmp");
+  if (std::error_code EC =
+          sys::fs::createUniqueFile(TempFilenameModel, TempFD, TempFilename,
+                                    sys::fs::owner_read | sys::fs::owner_write))
+    return EC;
+  {
+    raw_fd_ostream OS(TempFD, /* ShouldClose */ true);
+    for (StringRef Part : Parts)
+      OS << Part;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempFilename);
+      return make_error_code(errc::io_error);
+    }
+  }
+  if (std::error_code EC = sys::fs::rename(TempFilename, Path)) {
+    sys::fs::remove(TempFilename);
+    return EC;
+  }
+  return std::error_code();
+}
+
+/// Open the object at ObjectPath and record its use in its modification time
+/// (see CompressedCacheEntryHeader). Returns false if the object is missing.
+static bool touchObject(StringRef ObjectPath, int &FD) {
+  if (sys::fs::openFileForRead(ObjectPath, FD))
+    return false;
+  sys::fs::setLastModificationAndAccessTime(FD,
+                                            std::chrono::system_clock::now());
+  return true;
+}
+
+/// Load and validate the compressed object at ObjectPath. Returns null if the
+/// object is missing or invalid.
+static std::unique_ptr<MemoryBuffer> loadObject(StringRef ObjectPath) {
+  int FD;
+  if (!touchObject(ObjectPath, FD))
+    return nullptr;
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getOpenFile(FD, ObjectPath, /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
+  sys::Process::SafelyCloseFileDescriptor(FD);
+  if (!MBOrErr)
+    return nullptr;
+
+  StringRef Data = (*MBOrErr)->getBuffer();
+  if (Data.size() < sizeof(CompressedCacheEntryHeader))
+    return nullptr;
+  const auto *Header =
+      reinterpret_cast<const CompressedCacheEntryHeader *>(Data.data());
+  if (memcmp(Header->Magic, CompressedCacheEntryHeader::ExpectedMagic,
+             sizeof(Header->Magic)))
+    return nullptr;
+  StringRef Body = Data.drop_front(sizeof(CompressedCacheEntryHeader));
+
+  std::unique_ptr<MemoryBuffer> Object;
+  if (Header->Flags & CompressedCacheEntryHeader::Compressed) {
+    if (!zlib::isAvailable())
+      return nullptr;
+    size_t Size = Header->Size;
+    Object = MemoryBuffer::getNewUninitMemBuffer(Size, ObjectPath);
+    if (!Object)
+      return nullptr;
+    if (Error E = zlib::uncompress(
+            Body, const_cast<char *>(Object->getBufferStart()), Size)) {
+      consumeError(std::move(E));
+      return nullptr;
+    }
+    if (Size != Header->Size)
+      return nullptr;
+  } else {
+    if (Body.size() != Header->Size)
+      return nullptr;
+    Object = MemoryBuffer::getMemBufferCopy(Body, ObjectPath);
+  }
+
+  if (xxHash64(Object->getBuffer()) != Header->Hash)
+    return nullptr;
+  return Object;
+}
+
+/// Store Object in the cache, unless an object with the same contents is
+/// already there, and point the entry at EntryPath to it.
+static void commitObject(StringRef CacheDirectoryPath, StringRef EntryPath,
+                         StringRef Object, uint32_t CostMs) {
+  std::string ContentHash = toHex(SHA1::hash(makeArrayRef(
+      reinterpret_cast<const uint8_t *>(Object.data()), Object.size())));
+  SmallString<64> ObjectPath;
+  sys::path::append(ObjectPath, CacheDirectoryPath,
+                    "llvmcache-z-" + ContentHash);
+
+  int FD;
+  if (touchObject(ObjectPath, FD)) {
+    // Another entry already stored these contents.
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  } else {
+    CompressedCacheEntryHeader Header;
+    memcpy(Header.Magic, CompressedCacheEntryHeader::ExpectedMagic,
+           sizeof(Header.Magic));
+    Header.Size = Object.size();
+    Header.Hash = xxHash64(Object);
+    Header.CostMs = CostMs;
+    Header.Flags = 0;
+
+    SmallVector<char, 0> Compressed;
+    StringRef Body = Object;
+    if (zlib::isAvailable()) {
+      if (Error E = zlib::compress(Object, Compressed)) {
+        consumeError(std::move(E));
+      } else {
+        Header.Flags = CompressedCacheEntryHeader::Compressed;
+        Body = StringRef(Compressed.data(), Compressed.size());
+      }
+    }
+
+    StringRef HeaderBytes(reinterpret_cast<const char *>(&Header),
+                          sizeof(Header));
+    if (std::error_code EC = writeFileAtomically(CacheDirectoryPath,
+                                                 ObjectPath,
+                                                 {HeaderBytes, Body}))
+      report_fatal_error(Twine("Failed to write cache file ") + ObjectPath +
+                         ": " + EC.message() + "\n");
+  }
+
+  if (std::error_code EC =
+          writeFileAtomically(CacheDirectoryPath, EntryPath, {ContentHash}))
+    report_fatal_error(Twine("Failed to write cache file ") + EntryPath +
+                       ": " + EC.message() + "\n");
+}
+
+Expected<NativeObjectCache>
+lto::compressedLocalCache(StringRef CacheDirectoryPath, AddBufferFn AddBuffer) {
+  if (std::error_code EC = sys::fs::create_directories(CacheDirectoryPath))
+    return errorCodeToError(EC);
+
+  return [=](unsigned Task, StringRef Key) -> AddStreamFn {
+    SmallString<64> EntryPath;
+    sys::path::append(EntryPath, CacheDirectoryPath, "llvmcache-" + Key);
+    // First, see if we have a cache hit. The entry holds the content hash of
+    // its object.
+    ErrorOr<std::unique_ptr<MemoryBuffer>> EntryOrErr =
+        MemoryBuffer::getFile(EntryPath);
+    if (EntryOrErr) {
+      StringRef ContentHash = (*EntryOrErr)->getBuffer();
+      SmallString<64> ObjectPath;
+      if (ContentHash.size() == 40 &&
+          ContentHash.find_first_not_of("0123456789ABCDEF") ==
+              StringRef::npos) {
+        sys::path::append(ObjectPath, CacheDirectoryPath,
+                          "llvmcache-z-" + ContentHash);
+        if (std::unique_ptr<MemoryBuffer> Object = loadObject(ObjectPath)) {
+          AddBuffer(Task, std::move(Object), "");
+          return AddStreamFn();
+        }
+      }
+      // The entry or its object is invalid, or the object was pruned: drop
+      // them and recreate the object.
+      sys::fs::remove(EntryPath);
+      if (!ObjectPath.empty())
+        sys::fs::remove(ObjectPath);
+    } else if (EntryOrErr.getError() != errc::no_such_file_or_directory) {
+      report_fatal_error(Twine("Failed to open cache file ") + EntryPath +
+                         ": " + EntryOrErr.getError().message() + "\n");
+    }
+
+    // The cost of the object, recorded in the cache, is the time from here to
+    // its commit, which covers both its optimization and its code generation.
+    auto StartTime = std::chrono::steady_clock::now();
+
+    // This native object stream buffers the object in memory, then commits it
+    // to the cache and calls AddBuffer to add it to the link.
+    struct CompressedCacheStream : NativeObjectStream {
+      std::unique_ptr<SmallVector<char, 0>> Buffer;
+      AddBufferFn AddBuffer;
+      std::string CacheDirectoryPath;
+      std::string EntryPath;
+      std::chrono::steady_clock::time_point StartTime;
+      unsigned Task;
+
+      CompressedCacheStream(std::unique_ptr<SmallVector<char, 0>> Buffer,
+                            AddBufferFn AddBuffer,
+                            std::string CacheDirectoryPath,
+                            std::string EntryPath,
+                            std::chrono::steady_clock::time_point StartTime,
+                            unsigned Task)
+          : NativeObjectStream(llvm::make_unique<raw_svector_ostream>(*Buffer)),
+            Buffer(std::move(Buffer)), AddBuffer(std::move(AddBuffer)),
+            CacheDirectoryPath(std::move(CacheDirectoryPath)),
+            EntryPath(std::move(EntryPath)), StartTime(StartTime), Task(Task) {}
+
+      ~CompressedCacheStream() {
+        OS.reset();
+        StringRef Object(Buffer->data(), Buffer->size());
+        auto CostMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - StartTime)
+                          .count();
+        commitObject(CacheDirectoryPath, EntryPath, Object, CostMs);
+        AddBuffer(Task, MemoryBuffer::getMemBufferCopy(Object, EntryPath), "");
+      }
+    };
+
+    return [=](size_t Task) -> std::unique_ptr<NativeObjectStream> {
+      return llvm::make_unique<CompressedCacheStream>(
+          llvm::make_unique<SmallVector<char, 0>>(), AddBuffer,
+          CacheDirectoryPath, EntryPath.str(), StartTime, Task);
+    };
+  };
+}
@@ -12,6 +12,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/LTO/LTO.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
@@ -25,7 +27,12 @@
 #include "llvm/LTO/LTOBackend.h"
 #include "llvm/Linker/IRMover.h"
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -42,6 +49,8 @@
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
 
+#include <algorithm>
+#include <chrono>
 #include <set>
 
 using namespace llvm;
@@ -136,19 +145,32 @@ static void computeCacheKey(
   // Include the hash for the current module
   auto ModHash = Index.getModuleHash(ModuleID);
   Hasher.update(ArrayRef<uint8_t>((uint8_t *)&ModHash[0], sizeof(ModHash)));
-  for (auto F : ExportList)
-    // The export list can impact the internalization, be conservative here
+  // The export list can impact the internalization, be conservative here.
+  // Hash it in a fixed order, since the order of a hash set depends on how it
+  // was built, e.g. by the thin link or from the thin link cache.
+  std::vector<GlobalValue::GUID> ExportedGUIDs(ExportList.begin(),
+                                               ExportList.end());
+  std::sort(ExportedGUIDs.begin(), ExportedGUIDs.end());
+  for (auto F : ExportedGUIDs)
     Hasher.update(ArrayRef<uint8_t>((uint8_t *)&F, sizeof(F)));
 
   // Include the hash for every module we import functions from. The set of
   // imported symbols for each module may affect code generation and is
   // sensitive to link order, so include that as well.
-  for (auto &Entry : ImportList) {
-    auto ModHash = Index.getModuleHash(Entry.first());
+  std::vector<const FunctionImporter::ImportMapTy::MapEntryTy *> ImportEntries;
+  for (auto &Entry : ImportList)
+    ImportEntries.push_back(&Entry);
+  std::sort(ImportEntries.begin(), ImportEntries.end(),
+            [](const FunctionImporter::ImportMapTy::MapEntryTy *L,
+               const FunctionImporter::ImportMapTy::MapEntryTy *R) {
+              return L->first() < R->first();
+            });
+  for (auto *Entry : ImportEntries) {
+    auto ModHash = Index.getModuleHash(Entry->first());
     Hasher.update(ArrayRef<uint8_t>((uint8_t *)&ModHash[0], sizeof(ModHash)));
 
-    AddUint64(Entry.second.size());
-    for (auto &Fn : Entry.second)
+    AddUint64(Entry->second.size());
+    for (auto &Fn : Entry->second)
       AddUint64(Fn.first);
   }
 
@@ -400,7 +422,13 @@ LTO::LTO(Config Conf, ThinBackend Backend,
       ThinLTO(std::move(Backend)) {}
 
 // Requires a destructor for MapVector<BitcodeModule>.
-LTO::~LTO() = default;
+LTO::~LTO() {
+  // Summaries may still be read in the background if run() wasn't called.
+  if (SummaryReaders)
+    SummaryReaders->wait();
+  for (auto &Pending : PendingSummaries)
+    consumeError(std::move(Pending->Err));
+}
 
 // Add the symbols in the given module to the GlobalResolutions map, and resolve
 // their partitions.
@@ -504,7 +532,9 @@ Error LTO::addModule(InputFile &Input, unsigned ModI,
 
   // Regular LTO module summaries are added to a dummy module that represents
   // the combined regular LTO module.
-  if (Error Err = BM.readSummary(ThinLTO.CombinedIndex, "", -1ull))
+  if (Conf.InputThreads)
+    readSummaryInBackground(BM, "", -1ull);
+  else if (Error Err = BM.readSummary(ThinLTO.CombinedIndex, "", -1ull))
     return Err;
   RegularLTO.ModsWithSummaries.push_back(std::move(*ModOrErr));
   return Error::success();
@@ -689,9 +719,13 @@ Error LTO::linkRegularLTO(RegularLTOState::AddedModule Mod,
 Error LTO::addThinLTO(BitcodeModule BM, ArrayRef<InputFile::Symbol> Syms,
                       const SymbolResolution *&ResI,
                       const SymbolResolution *ResE) {
-  if (Error Err =
-          BM.readSummary(ThinLTO.CombinedIndex, BM.getModuleIdentifier(),
-                         ThinLTO.ModuleMap.size()))
+  PendingSummary *Pending = nullptr;
+  if (Conf.InputThreads)
+    Pending = readSummaryInBackground(BM, BM.getModuleIdentifier(),
+                                      ThinLTO.ModuleMap.size());
+  else if (Error Err =
+               BM.readSummary(ThinLTO.CombinedIndex, BM.getModuleIdentifier(),
+                              ThinLTO.ModuleMap.size()))
     return Err;
 
   for (const InputFile::Symbol &Sym : Syms) {
@@ -708,10 +742,13 @@ Error LTO::addThinLTO(BitcodeModule BM, ArrayRef<InputFile::Symbol> Syms,
         // switch the linkage to `weak` to prevent IPOs from happening.
         // Find the summary in the module for this very GV and record the new
         // linkage so that we can switch it when we import the GV.
-        if (Res.LinkerRedefined)
-          if (auto S = ThinLTO.CombinedIndex.findSummaryInModule(
-                  GUID, BM.getModuleIdentifier()))
+        if (Res.LinkerRedefined) {
+          if (Pending)
+            Pending->LinkerRedefined.push_back(GUID);
+          else if (auto S = ThinLTO.CombinedIndex.findSummaryInModule(
+                       GUID, BM.getModuleIdentifier()))
             S->setLinkage(GlobalValue::WeakAnyLinkage);
+        }
       }
     }
   }
@@ -724,24 +761,83 @@ Error LTO::addThinLTO(BitcodeModule BM, ArrayRef<InputFile::Symbol> Syms,
   return Error::success();
 }
 
+LTO::PendingSummary *LTO::readSummaryInBackground(BitcodeModule BM,
+                                                  StringRef ModulePath,
+                                                  uint64_t ModuleId) {
+  if (!SummaryReaders)
+    SummaryReaders = llvm::make_unique<ThreadPool>(Conf.InputThreads);
+  PendingSummaries.push_back(llvm::make_unique<PendingSummary>());
+  PendingSummary *Pending = PendingSummaries.back().get();
+  Pending->ModulePath = ModulePath;
+  SummaryReaders->async([=]() {
+    BitcodeModule Mod = BM;
+    if (Error Err =
+            Mod.readSummary(Pending->Index, Pending->ModulePath, ModuleId))
+      Pending->Err = std::move(Err);
+  });
+  return Pending;
+}
+
+Error LTO::mergePendingSummaries() {
+  if (!SummaryReaders)
+    return Error::success();
+  SummaryReaders->wait();
+
+  std::vector<std::unique_ptr<PendingSummary>> Pending =
+      std::move(PendingSummaries);
+  PendingSummaries.clear();
+  Error FirstErr = Error::success();
+  for (auto &P : Pending) {
+    if (P->Err) {
+      if (!FirstErr)
+        FirstErr = std::move(P->Err);
+      else
+        consumeError(std::move(P->Err));
+      continue;
+    }
+    if (FirstErr)
+      continue;
+
+    ThinLTO.CombinedIndex.mergeFrom(P->Index);
+    for (GlobalValue::GUID GUID : P->LinkerRedefined)
+      if (auto S = ThinLTO.CombinedIndex.findSummaryInModule(GUID,
+                                                             P->ModulePath))
+        S->setLinkage(GlobalValue::WeakAnyLinkage);
+  }
+  return FirstErr;
+}
+
 unsigned LTO::getMaxTasks() const {
   CalledGetMaxTasks = true;
   return RegularLTO.ParallelCodeGenParallelismLevel + ThinLTO.ModuleMap.size();
 }
 
 Error LTO::run(AddStreamFn AddStream, NativeObjectCache Cache) {
+  if (Error Err = mergePendingSummaries())
+    return Err;
+
+  // If the results of the thin link are cached, they include the liveness of
+  // the symbols.
+  std::string ThinLinkCachePath = getThinLinkCachePath();
+  bool ThinLinkCached =
+      !ThinLinkCachePath.empty() && loadThinLink(ThinLinkCachePath);
+  if (ThinLinkCached)
+    DEBUG(dbgs() << "Loaded the thin link from " << ThinLinkCachePath << "\n");
+
   // Compute "dead" symbols, we don't want to import/export these!
-  DenseSet<GlobalValue::GUID> GUIDPreservedSymbols;
-  for (auto &Res : GlobalResolutions) {
-    if (Res.second.VisibleOutsideSummary &&
-        // IRName will be defined if we have seen the prevailing copy of
-        // this value. If not, no need to preserve any ThinLTO copies.
-        !Res.second.IRName.empty())
-      GUIDPreservedSymbols.insert(GlobalValue::getGUID(
-          GlobalValue::dropLLVMManglingEscape(Res.second.IRName)));
-  }
+  if (!ThinLinkCached) {
+    DenseSet<GlobalValue::GUID> GUIDPreservedSymbols;
+    for (auto &Res : GlobalResolutions) {
+      if (Res.second.VisibleOutsideSummary &&
+          // IRName will be defined if we have seen the prevailing copy of
+          // this value. If not, no need to preserve any ThinLTO copies.
+          !Res.second.IRName.empty())
+        GUIDPreservedSymbols.insert(GlobalValue::getGUID(
+            GlobalValue::dropLLVMManglingEscape(Res.second.IRName)));
+    }
 
-  computeDeadSymbols(ThinLTO.CombinedIndex, GUIDPreservedSymbols);
+    computeDeadSymbols(ThinLTO.CombinedIndex, GUIDPreservedSymbols);
+  }
 
   // Save the status of having a regularLTO combined module, as
   // this is needed for generating the ThinLTO Task ID, and
@@ -752,7 +848,8 @@ Error LTO::run(AddStreamFn AddStream, NativeObjectCache Cache) {
   if (HasRegularLTO)
     if (auto E = runRegularLTO(AddStream))
       return E;
-  return runThinLTO(AddStream, Cache, HasRegularLTO);
+  return runThinLTO(AddStream, Cache, HasRegularLTO, ThinLinkCached,
+                    ThinLinkCachePath);
 }
 
 Error LTO::runRegularLTO(AddStreamFn AddStream) {
@@ -844,6 +941,26 @@ public:
   virtual Error wait() = 0;
 };
 
+// Estimate the cost of running the ThinLTO backend on a module from the
+// combined index, as the number of instructions in the functions it defines
+// and in the functions it imports, all of which go through the optimizer.
+static uint64_t
+estimateThinLTOBackendCost(const ModuleSummaryIndex &Index,
+                           const GVSummaryMapTy &DefinedGlobals,
+                           const FunctionImporter::ImportMapTy &ImportList) {
+  uint64_t Cost = 0;
+  for (auto &GS : DefinedGlobals)
+    if (auto *FS = dyn_cast<FunctionSummary>(GS.second))
+      Cost += FS->instCount();
+  for (auto &FunctionsToImport : ImportList)
+    for (auto &Function : FunctionsToImport.second)
+      if (auto *FS = dyn_cast_or_null<FunctionSummary>(
+              Index.findSummaryInModule(Function.first,
+                                        FunctionsToImport.first())))
+        Cost += FS->instCount();
+  return Cost;
+}
+
 namespace {
 class InProcessThinBackend : public ThinBackendProc {
   ThreadPool BackendThreadPool;
@@ -853,6 +970,17 @@ class InProcessThinBackend : public ThinBackendProc {
   std::set<GlobalValue::GUID> CfiFunctionDefs;
   std::set<GlobalValue::GUID> CfiFunctionDecls;
 
+  /// A backend job that has been started but not yet handed to the thread
+  /// pool. Jobs are dispatched by wait(), most expensive first, so that the
+  /// largest modules don't end up running alone at the end of the link.
+  struct BackendJob {
+    std::string ModuleID;
+    uint64_t Cost;
+    std::function<void()> Run;
+    double WallTime = 0;
+  };
+  std::vector<BackendJob> Jobs;
+
   Optional<Error> Err;
   std::mutex ErrMu;
 
@@ -928,7 +1056,11 @@ public:
     assert(ModuleToDefinedGVSummaries.count(ModulePath));
     const GVSummaryMapTy &DefinedGlobals =
         ModuleToDefinedGVSummaries.find(ModulePath)->second;
-    BackendThreadPool.async(
+    BackendJob Job;
+    Job.ModuleID = ModulePath;
+    Job.Cost =
+        estimateThinLTOBackendCost(CombinedIndex, DefinedGlobals, ImportList);
+    Job.Run = std::bind(
         [=](BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
             const FunctionImporter::ImportMapTy &ImportList,
             const FunctionImporter::ExportSetTy &ExportList,
@@ -951,16 +1083,56 @@ public:
         BM, std::ref(CombinedIndex), std::ref(ImportList), std::ref(ExportList),
         std::ref(ResolvedODR), std::ref(DefinedGlobals), std::ref(ModuleMap),
         std::ref(TypeIdSummariesByGuid));
+    Jobs.push_back(std::move(Job));
     return Error::success();
   }
 
   Error wait() override {
+    std::stable_sort(Jobs.begin(), Jobs.end(),
+                     [](const BackendJob &A, const BackendJob &B) {
+                       return A.Cost > B.Cost;
+                     });
+    for (BackendJob &Job : Jobs)
+      BackendThreadPool.async([&Job]() {
+        auto Start = std::chrono::steady_clock::now();
+        Job.Run();
+        Job.WallTime = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - Start)
+                           .count();
+      });
     BackendThreadPool.wait();
+
+    if (Conf.TimeThinLTOBackends)
+      printBackendTimes();
+    Jobs.clear();
+
     if (Err)
       return std::move(*Err);
     else
       return Error::success();
   }
+
+private:
+  void printBackendTimes() {
+    std::vector<const BackendJob *> SortedJobs;
+    for (const BackendJob &Job : Jobs)
+      SortedJobs.push_back(&Job);
+    std::stable_sort(SortedJobs.begin(), SortedJobs.end(),
+                     [](const BackendJob *A, const BackendJob *B) {
+                       return A->WallTime > B->WallTime;
+                     });
+
+    std::unique_ptr<raw_fd_ostream> OS = CreateInfoOutputFile();
+    *OS << "===" << std::string(73, '-') << "===\n";
+    OS->indent((80 - 22) / 2) << "ThinLTO Backend Timing\n";
+    *OS << "===" << std::string(73, '-') << "===\n";
+    *OS << "  ---Wall Time---  --Est. Cost--  --- Module ---\n";
+    for (const BackendJob *Job : SortedJobs)
+      *OS << format("  %10.4f (s)  %13" PRIu64 "  ", Job->WallTime, Job->Cost)
+          << Job->ModuleID << "\n";
+    *OS << "\n";
+    OS->flush();
+  }
 };
 } // end anonymous namespace
 
@@ -1067,8 +1239,302 @@ ThinBackend lto::createWriteIndexesThinBackend(std::string OldPrefix,
   };
 }
 
+static const uint32_t ThinLinkCacheVersion = 2;
+
+std::string LTO::getThinLinkCachePath() const {
+  if (Conf.ThinLinkCacheDir.empty() || Conf.CombinedIndexHook ||
+      ThinLTO.ModuleMap.empty())
+    return "";
+
+  SHA1 Hasher;
+  Hasher.update(LLVM_VERSION_STRING);
+#ifdef LLVM_REVISION
+  Hasher.update(LLVM_REVISION);
+#endif
+  auto AddString = [&](StringRef Str) {
+    Hasher.update(Str);
+    Hasher.update(ArrayRef<uint8_t>{0});
+  };
+  auto AddUint64 = [&](uint64_t I) {
+    uint8_t Data[8];
+    support::endian::write64le(Data, I);
+    Hasher.update(Data);
+  };
+  AddUint64(Conf.OptLevel);
+
+  // Include the hash of every module with a summary, in a fixed order. The
+  // thin link can't be cached if any of them has no hash.
+  std::vector<StringRef> ModulePaths;
+  for (auto &Entry : ThinLTO.CombinedIndex.modulePaths()) {
+    if (Entry.second.second == ModuleHash{{0}})
+      return "";
+    ModulePaths.push_back(Entry.first());
+  }
+  std::sort(ModulePaths.begin(), ModulePaths.end());
+  for (StringRef ModulePath : ModulePaths) {
+    AddString(ModulePath);
+    auto ModHash = ThinLTO.CombinedIndex.getModuleHash(ModulePath);
+    Hasher.update(ArrayRef<uint8_t>((uint8_t *)&ModHash[0], sizeof(ModHash)));
+  }
+
+  // Include the symbol resolutions, which determine the preserved symbols and
+  // the prevailing copies. They are kept in hash tables, so combine the hashes
+  // of their entries in an order-independent way.
+  uint64_t ResolutionHash[2] = {0, 0};
+  auto AddResolution = [&](MD5 &ResHasher) {
+    MD5::MD5Result Result;
+    ResHasher.final(Result);
+    ResolutionHash[0] += Result.low();
+    ResolutionHash[1] += Result.high();
+  };
+  for (auto &Res : GlobalResolutions) {
+    MD5 ResHasher;
+    ResHasher.update(Res.first());
+    ResHasher.update(ArrayRef<uint8_t>{0});
+    ResHasher.update(Res.second.IRName);
+    uint8_t Data[6] = {Res.second.VisibleOutsideSummary,
+                       Res.second.UnnamedAddr};
+    support::endian::write32le(Data + 2, Res.second.Partition);
+    ResHasher.update(Data);
+    AddResolution(ResHasher);
+  }
+  for (auto &Prevailing : ThinLTO.PrevailingModuleForGUID) {
+    MD5 ResHasher;
+    uint8_t Data[8];
+    support::endian::write64le(Data, Prevailing.first);
+    ResHasher.update(Data);
+    ResHasher.update(Prevailing.second);
+    AddResolution(ResHasher);
+  }
+  AddUint64(GlobalResolutions.size());
+  AddUint64(ThinLTO.PrevailingModuleForGUID.size());
+  AddUint64(ResolutionHash[0]);
+  AddUint64(ResolutionHash[1]);
+
+  // This choice of file name allows the cache to be pruned (see pruneCache()
+  // in include/llvm/Support/CachePruning.h).
+  SmallString<128> Path(Conf.ThinLinkCacheDir);
+  sys::path::append(Path, "llvmcache-thinlink-" + toHex(Hasher.result()));
+  return Path.str();
+}
+
+// The thin link cache file contains, in little endian:
+// - The format version (ThinLinkCacheVersion) as a uint32_t.
+// - Whether the index was dead stripped, as a uint8_t.
+// - The number of summaries in the index as a uint64_t, followed by, for each
+//   of them: its GUID as a uint64_t, its null-terminated module path, and its
+//   linkage and liveness as uint8_t's. A summary is identified by its GUID and
+//   module path, so the order of the summary lists doesn't matter.
+// - The number of modules as a uint32_t, followed by, for each module: its
+//   null-terminated identifier, its import list, its export list and its
+//   resolved ODR linkages. Each list starts with its size as a uint32_t.
+bool LTO::loadThinLink(StringRef Path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr = MemoryBuffer::getFile(Path);
+  if (!MBOrErr)
+    return false;
+  DataExtractor Data((*MBOrErr)->getBuffer(), /*IsLittleEndian=*/true,
+                     /*AddressSize=*/8);
+  uint32_t Offset = 0;
+  // Returns whether there are at least N entries of Size bytes left, so that
+  // a corrupted count can't make us loop for long.
+  auto HasEntries = [&](uint64_t N, uint64_t Size) {
+    return N * Size <= Data.getData().size() - Offset;
+  };
+
+  if (!Data.isValidOffsetForDataOfSize(Offset, 4 + 1 + 8) ||
+      Data.getU32(&Offset) != ThinLinkCacheVersion)
+    return false;
+  bool WithGlobalValueDeadStripping = Data.getU8(&Offset);
+  uint64_t NumSummaries = Data.getU64(&Offset);
+  uint64_t IndexSummaries = 0;
+  for (auto &Entry : ThinLTO.CombinedIndex)
+    IndexSummaries += Entry.second.SummaryList.size();
+  if (NumSummaries != IndexSummaries || !HasEntries(NumSummaries, 8 + 1 + 2))
+    return false;
+  std::map<std::pair<GlobalValue::GUID, StringRef>,
+           std::pair<GlobalValue::LinkageTypes, bool>>
+      SummaryStates;
+  for (uint64_t I = 0; I != NumSummaries; ++I) {
+    GlobalValue::GUID GUID = Data.getU64(&Offset);
+    StringRef ModulePath = Data.getCStrRef(&Offset);
+    if (!HasEntries(1, 2))
+      return false;
+    uint8_t Linkage = Data.getU8(&Offset);
+    if (Linkage > GlobalValue::CommonLinkage)
+      return false;
+    bool IsLive = Data.getU8(&Offset);
+    if (!SummaryStates
+             .insert({{GUID, ModulePath},
+                      {GlobalValue::LinkageTypes(Linkage), IsLive}})
+             .second)
+      return false;
+  }
+  // Every summary of the index must have a cached state, or this is a miss.
+  std::vector<GlobalValue::LinkageTypes> Linkages;
+  std::vector<bool> Live;
+  Linkages.reserve(NumSummaries);
+  Live.reserve(NumSummaries);
+  for (auto &Entry : ThinLTO.CombinedIndex)
+    for (auto &S : Entry.second.SummaryList) {
+      auto State = SummaryStates.find({Entry.first, S->modulePath()});
+      if (State == SummaryStates.end())
+        return false;
+      Linkages.push_back(State->second.first);
+      Live.push_back(State->second.second);
+    }
+
+  StringMap<FunctionImporter::ImportMapTy> ImportLists;
+  StringMap<FunctionImporter::ExportSetTy> ExportLists;
+  StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>>
+      ResolvedODR;
+  if (!HasEntries(1, 4) || Data.getU32(&Offset) != ThinLTO.ModuleMap.size())
+    return false;
+  for (unsigned I = 0, E = ThinLTO.ModuleMap.size(); I != E; ++I) {
+    StringRef ModuleID = Data.getCStrRef(&Offset);
+    if (!ThinLTO.ModuleMap.count(ModuleID) || !HasEntries(1, 4))
+      return false;
+
+    auto &ImportList = ImportLists[ModuleID];
+    uint32_t NumSources = Data.getU32(&Offset);
+    for (uint32_t J = 0; J != NumSources; ++J) {
+      StringRef Source = Data.getCStrRef(&Offset);
+      if (Source.empty() || !HasEntries(1, 4))
+        return false;
+      auto &Functions = ImportList[Source];
+      uint32_t NumFunctions = Data.getU32(&Offset);
+      if (!HasEntries(NumFunctions, 8 + 4))
+        return false;
+      for (uint32_t K = 0; K != NumFunctions; ++K) {
+        GlobalValue::GUID GUID = Data.getU64(&Offset);
+        Functions[GUID] = Data.getU32(&Offset);
+      }
+    }
+
+    if (!HasEntries(1, 4))
+      return false;
+    auto &ExportList = ExportLists[ModuleID];
+    uint32_t NumExports = Data.getU32(&Offset);
+    if (!HasEntries(NumExports, 8))
+      return false;
+    for (uint32_t J = 0; J != NumExports; ++J)
+      ExportList.insert(Data.getU64(&Offset));
+
+    if (!HasEntries(1, 4))
+      return false;
+    auto &ModuleODR = ResolvedODR[ModuleID];
+    uint32_t NumResolved = Data.getU32(&Offset);
+    if (!HasEntries(NumResolved, 8 + 1))
+      return false;
+    for (uint32_t J = 0; J != NumResolved; ++J) {
+      GlobalValue::GUID GUID = Data.getU64(&Offset);
+      uint8_t Linkage = Data.getU8(&Offset);
+      if (Linkage > GlobalValue::CommonLinkage)
+        return false;
+      ModuleODR[GUID] = GlobalValue::LinkageTypes(Linkage);
+    }
+  }
+  if (Offset != Data.getData().size())
+    return false;
+
+  // The results match the index: apply the liveness now, as computeDeadSymbols
+  // would, and keep the linkages for runThinLTO().
+  uint64_t I = 0;
+  for (auto &Entry : ThinLTO.CombinedIndex)
+    for (auto &S : Entry.second.SummaryList)
+      S->setLive(Live[I++]);
+  if (WithGlobalValueDeadStripping)
+    ThinLTO.CombinedIndex.setWithGlobalValueDeadStripping();
+  ThinLTO.CachedLinkages = std::move(Linkages);
+  ThinLTO.ImportLists = std::move(ImportLists);
+  ThinLTO.ExportLists = std::move(ExportLists);
+  ThinLTO.ResolvedODR = std::move(ResolvedODR);
+  return true;
+}
+
+Error LTO::saveThinLink(StringRef Path) const {
+  SmallString<0> Buffer;
+  raw_svector_ostream OS(Buffer);
+  support::endian::Writer<support::little> W(OS);
+
+  W.write<uint32_t>(ThinLinkCacheVersion);
+  W.write<uint8_t>(ThinLTO.CombinedIndex.withGlobalValueDeadStripping());
+  uint64_t NumSummaries = 0;
+  for (auto &Entry : ThinLTO.CombinedIndex)
+    NumSummaries += Entry.second.SummaryList.size();
+  W.write<uint64_t>(NumSummaries);
+  for (auto &Entry : ThinLTO.CombinedIndex)
+    for (auto &S : Entry.second.SummaryList) {
+      W.write<uint64_t>(Entry.first);
+      OS << S->modulePath() << '\0';
+      W.write<uint8_t>(S->linkage());
+      W.write<uint8_t>(S->flags().Live);
+    }
+
+  W.write<uint32_t>(ThinLTO.ModuleMap.size());
+  for (auto &Mod : ThinLTO.ModuleMap) {
+    OS << Mod.first << '\0';
+
+    auto ImportList = ThinLTO.ImportLists.find(Mod.first);
+    if (ImportList == ThinLTO.ImportLists.end()) {
+      W.write<uint32_t>(0);
+    } else {
+      W.write<uint32_t>(ImportList->second.size());
+      for (auto &Entry : ImportList->second) {
+        OS << Entry.first() << '\0';
+        W.write<uint32_t>(Entry.second.size());
+        for (auto &Function : Entry.second) {
+          W.write<uint64_t>(Function.first);
+          W.write<uint32_t>(Function.second);
+        }
+      }
+    }
+
+    auto ExportList = ThinLTO.ExportLists.find(Mod.first);
+    if (ExportList == ThinLTO.ExportLists.end()) {
+      W.write<uint32_t>(0);
+    } else {
+      W.write<uint32_t>(ExportList->second.size());
+      for (GlobalValue::GUID GUID : ExportList->second)
+        W.write<uint64_t>(GUID);
+    }
+
+    auto ModuleODR = ThinLTO.ResolvedODR.find(Mod.first);
+    if (ModuleODR == ThinLTO.ResolvedODR.end()) {
+      W.write<uint32_t>(0);
+    } else {
+      W.write<uint32_t>(ModuleODR->second.size());
+      for (auto &Resolved : ModuleODR->second) {
+        W.write<uint64_t>(Resolved.first);
+        W.write<uint8_t>(Resolved.second);
+      }
+    }
+  }
+
+  // Write to a temporary and rename it, so that concurrent links never see a
+  // partial file.
+  if (std::error_code EC = sys::fs::create_directories(Conf.ThinLinkCacheDir))
+    return errorCodeToError(EC);
+  int TempFD;
+  SmallString<128> TempFilenameModel, TempFilename;
+  sys::path::append(TempFilenameModel, Conf.ThinLinkCacheDir,
+                    "ThinLink-%%%%%%.tmp");
+  if (std::error_code EC =
+          sys::fs::createUniqueFile(TempFilenameModel, TempFD, TempFilename))
+    return errorCodeToError(EC);
+  {
+    raw_fd_ostream TempOS(TempFD, /*shouldClose=*/true);
+    TempOS << Buffer;
+  }
+  if (std::error_code EC = sys::fs::rename(TempFilename, Path)) {
+    sys::fs::remove(TempFilename);
+    return errorCodeToError(EC);
+  }
+  return Error::success();
+}
+
 Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
-                      bool HasRegularLTO) {
+                      bool HasRegularLTO, bool ThinLinkCached,
+                      StringRef ThinLinkCachePath) {
   if (ThinLTO.ModuleMap.empty())
     return Error::success();
 
@@ -1092,59 +1558,72 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
     if (!ModuleToDefinedGVSummaries.count(Mod.first))
       ModuleToDefinedGVSummaries.try_emplace(Mod.first);
 
-  StringMap<FunctionImporter::ImportMapTy> ImportLists(
-      ThinLTO.ModuleMap.size());
-  StringMap<FunctionImporter::ExportSetTy> ExportLists(
-      ThinLTO.ModuleMap.size());
-  StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>> ResolvedODR;
-
-  if (Conf.OptLevel > 0) {
-    ComputeCrossModuleImport(ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
-                             ImportLists, ExportLists);
+  auto &ImportLists = ThinLTO.ImportLists;
+  auto &ExportLists = ThinLTO.ExportLists;
+  auto &ResolvedODR = ThinLTO.ResolvedODR;
+
+  if (ThinLinkCached) {
+    // Apply the linkage changes that the thin link made to the index.
+    uint64_t I = 0;
+    for (auto &Entry : ThinLTO.CombinedIndex)
+      for (auto &S : Entry.second.SummaryList)
+        S->setLinkage(ThinLTO.CachedLinkages[I++]);
+  } else {
+    if (Conf.OptLevel > 0) {
+      ComputeCrossModuleImport(ThinLTO.CombinedIndex,
+                               ModuleToDefinedGVSummaries, ImportLists,
+                               ExportLists);
+
+      std::set<GlobalValue::GUID> ExportedGUIDs;
+      for (auto &Res : GlobalResolutions) {
+        // First check if the symbol was flagged as having external
+        // references.
+        if (Res.second.Partition != GlobalResolution::External)
+          continue;
+        // IRName will be defined if we have seen the prevailing copy of
+        // this value. If not, no need to mark as exported from a ThinLTO
+        // partition (and we can't get the GUID).
+        if (Res.second.IRName.empty())
+          continue;
+        auto GUID = GlobalValue::getGUID(
+            GlobalValue::dropLLVMManglingEscape(Res.second.IRName));
+        // Mark exported unless index-based analysis determined it to be dead.
+        if (ThinLTO.CombinedIndex.isGUIDLive(GUID))
+          ExportedGUIDs.insert(GUID);
+      }
 
-    std::set<GlobalValue::GUID> ExportedGUIDs;
-    for (auto &Res : GlobalResolutions) {
-      // First check if the symbol was flagged as having external references.
-      if (Res.second.Partition != GlobalResolution::External)
-        continue;
-      // IRName will be defined if we have seen the prevailing copy of
-      // this value. If not, no need to mark as exported from a ThinLTO
-      // partition (and we can't get the GUID).
-      if (Res.second.IRName.empty())
-        continue;
-      auto GUID = GlobalValue::getGUID(
-          GlobalValue::dropLLVMManglingEscape(Res.second.IRName));
-      // Mark exported unless index-based analysis determined it to be dead.
-      if (ThinLTO.CombinedIndex.isGUIDLive(GUID))
-        ExportedGUIDs.insert(GUID);
+      // Any functions referenced by the jump table in the regular LTO object
+      // must be exported.
+      for (auto &Def : ThinLTO.CombinedIndex.cfiFunctionDefs())
+        ExportedGUIDs.insert(
+            GlobalValue::getGUID(GlobalValue::dropLLVMManglingEscape(Def)));
+
+      auto isExported = [&](StringRef ModuleIdentifier,
+                            GlobalValue::GUID GUID) {
+        const auto &ExportList = ExportLists.find(ModuleIdentifier);
+        return (ExportList != ExportLists.end() &&
+                ExportList->second.count(GUID)) ||
+               ExportedGUIDs.count(GUID);
+      };
+      thinLTOInternalizeAndPromoteInIndex(ThinLTO.CombinedIndex, isExported);
     }
 
-    // Any functions referenced by the jump table in the regular LTO object must
-    // be exported.
-    for (auto &Def : ThinLTO.CombinedIndex.cfiFunctionDefs())
-      ExportedGUIDs.insert(
-          GlobalValue::getGUID(GlobalValue::dropLLVMManglingEscape(Def)));
-
-    auto isExported = [&](StringRef ModuleIdentifier, GlobalValue::GUID GUID) {
-      const auto &ExportList = ExportLists.find(ModuleIdentifier);
-      return (ExportList != ExportLists.end() &&
-              ExportList->second.count(GUID)) ||
-             ExportedGUIDs.count(GUID);
+    auto isPrevailing = [&](GlobalValue::GUID GUID,
+                            const GlobalValueSummary *S) {
+      return ThinLTO.PrevailingModuleForGUID[GUID] == S->modulePath();
     };
-    thinLTOInternalizeAndPromoteInIndex(ThinLTO.CombinedIndex, isExported);
-  }
+    auto recordNewLinkage = [&](StringRef ModuleIdentifier,
+                                GlobalValue::GUID GUID,
+                                GlobalValue::LinkageTypes NewLinkage) {
+      ResolvedODR[ModuleIdentifier][GUID] = NewLinkage;
+    };
+    thinLTOResolveWeakForLinkerInIndex(ThinLTO.CombinedIndex, isPrevailing,
+                                       recordNewLinkage);
 
-  auto isPrevailing = [&](GlobalValue::GUID GUID,
-                          const GlobalValueSummary *S) {
-    return ThinLTO.PrevailingModuleForGUID[GUID] == S->modulePath();
-  };
-  auto recordNewLinkage = [&](StringRef ModuleIdentifier,
-                              GlobalValue::GUID GUID,
-                              GlobalValue::LinkageTypes NewLinkage) {
-    ResolvedODR[ModuleIdentifier][GUID] = NewLinkage;
-  };
-  thinLTOResolveWeakForLinkerInIndex(ThinLTO.CombinedIndex, isPrevailing,
-                                     recordNewLinkage);
+    if (!ThinLinkCachePath.empty())
+      if (Error E = saveThinLink(ThinLinkCachePath))
+        return E;
+  }
 
   std::unique_ptr<ThinBackendProc> BackendProc =
       ThinLTO.Backend(Conf, ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
@@ -233,6 +233,19 @@ static void runNewPMCustomPasses(Module &Mod, TargetMachine *TM,
   MPM.run(Mod, MAM);
 }
 
+static void initPassManagerBuilder(PassManagerBuilder &PMB, Config &Conf,
+                                   TargetMachine *TM) {
+  PMB.LibraryInfo = new TargetLibraryInfoImpl(Triple(TM->getTargetTriple()));
+  // Unconditionally verify input since it is not verified before this
+  // point and has unknown origin.
+  PMB.VerifyInput = true;
+  PMB.VerifyOutput = !Conf.DisableVerify;
+  PMB.LoopVectorize = true;
+  PMB.SLPVectorize = true;
+  PMB.OptLevel = Conf.OptLevel;
+  PMB.PGOSampleUse = Conf.SampleProfile;
+}
+
 static void runOldPMPasses(Config &Conf, Module &Mod, TargetMachine *TM,
                            bool IsThinLTO, ModuleSummaryIndex *ExportSummary,
                            const ModuleSummaryIndex *ImportSummary) {
@@ -240,18 +253,10 @@ static void runOldPMPasses(Config &Conf, Module &Mod, TargetMachine *TM,
   passes.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
 
   PassManagerBuilder PMB;
-  PMB.LibraryInfo = new TargetLibraryInfoImpl(Triple(TM->getTargetTriple()));
+  initPassManagerBuilder(PMB, Conf, TM);
   PMB.Inliner = createFunctionInliningPass();
   PMB.ExportSummary = ExportSummary;
   PMB.ImportSummary = ImportSummary;
-  // Unconditionally verify input since it is not verified before this
-  // point and has unknown origin.
-  PMB.VerifyInput = true;
-  PMB.VerifyOutput = !Conf.DisableVerify;
-  PMB.LoopVectorize = true;
-  PMB.SLPVectorize = true;
-  PMB.OptLevel = Conf.OptLevel;
-  PMB.PGOSampleUse = Conf.SampleProfile;
   if (IsThinLTO)
     PMB.populateThinLTOPassManager(passes);
   else
@@ -259,6 +264,36 @@ static void runOldPMPasses(Config &Conf, Module &Mod, TargetMachine *TM,
   passes.run(Mod);
 }
 
+// Runs the whole-program part of the regular LTO pipeline, which has to see
+// the entire module before it can be partitioned.
+static void runOldPMIPOPasses(Config &Conf, Module &Mod, TargetMachine *TM,
+                              ModuleSummaryIndex *ExportSummary) {
+  legacy::PassManager passes;
+  passes.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
+
+  PassManagerBuilder PMB;
+  initPassManagerBuilder(PMB, Conf, TM);
+  PMB.Inliner = createFunctionInliningPass();
+  PMB.ExportSummary = ExportSummary;
+  PMB.populateLTOIPOPassManager(passes);
+  passes.run(Mod);
+}
+
+// Runs the rest of the regular LTO pipeline on a single partition.
+static bool optPartition(Config &Conf, TargetMachine *TM, unsigned Task,
+                         Module &Mod) {
+  legacy::PassManager passes;
+  passes.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
+
+  PassManagerBuilder PMB;
+  initPassManagerBuilder(PMB, Conf, TM);
+  // The partition was produced by the IPO passes, not read from the outside.
+  PMB.VerifyInput = false;
+  PMB.populateLTOPartitionPassManager(passes);
+  passes.run(Mod);
+  return !Conf.PostOptModuleHook || Conf.PostOptModuleHook(Task, Mod);
+}
+
 bool opt(Config &Conf, TargetMachine *TM, unsigned Task, Module &Mod,
          bool IsThinLTO, ModuleSummaryIndex *ExportSummary,
          const ModuleSummaryIndex *ImportSummary) {
@@ -285,9 +320,13 @@ void codegen(Config &Conf, TargetMachine *TM, AddStreamFn AddStream,
   CodeGenPasses.run(Mod);
 }
 
+// Splits Mod into partitions and code generates them concurrently, each in
+// its own context. If OptimizePartitions is set, each partition first goes
+// through the function-level part of the LTO pipeline. The partitions are
+// balanced by code size when they are optimized or when C asks for it.
 void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
                   unsigned ParallelCodeGenParallelismLevel,
-                  std::unique_ptr<Module> Mod) {
+                  std::unique_ptr<Module> Mod, bool OptimizePartitions) {
   ThreadPool CodegenThreadPool(ParallelCodeGenParallelismLevel);
   unsigned ThreadCount = 0;
   const Target *T = &TM->getTarget();
@@ -319,13 +358,18 @@ void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
               std::unique_ptr<TargetMachine> TM =
                   createTargetMachine(C, T, *MPartInCtx);
 
+              if (OptimizePartitions &&
+                  !optPartition(C, TM.get(), ThreadId, *MPartInCtx))
+                return;
+
               codegen(C, TM.get(), AddStream, ThreadId, *MPartInCtx);
             },
             // Pass BC using std::move to ensure that it get moved rather than
             // copied into the thread's context.
             std::move(BC), ThreadCount++);
       },
-      false);
+      /*PreserveLocals=*/false,
+      /*BalanceBySize=*/OptimizePartitions || C.BalanceCodeGenPartitions);
 
   // Because the inner lambda (which runs in a worker thread) captures our local
   // variables, we need to wait for the worker threads to terminate before we
@@ -375,6 +419,16 @@ Error lto::backend(Config &C, AddStreamFn AddStream,
     return DiagFileOrErr.takeError();
   auto DiagnosticOutputFile = std::move(*DiagFileOrErr);
 
+  // Remarks are emitted to the context of the module, so they would be lost
+  // for the passes run on the partitions.
+  if (C.ParallelOpt && !C.CodeGenOnly && ParallelCodeGenParallelismLevel > 1 &&
+      C.OptPipeline.empty() && !C.UseNewPM && !DiagnosticOutputFile) {
+    runOldPMIPOPasses(C, *Mod, TM.get(), &CombinedIndex);
+    splitCodeGen(C, TM.get(), AddStream, ParallelCodeGenParallelismLevel,
+                 std::move(Mod), /*OptimizePartitions=*/true);
+    return Error::success();
+  }
+
   if (!C.CodeGenOnly) {
     if (!opt(C, TM.get(), 0, *Mod, /*IsThinLTO=*/false,
              /*ExportSummary=*/&CombinedIndex, /*ImportSummary=*/nullptr)) {
@@ -387,7 +441,7 @@ Error lto::backend(Config &C, AddStreamFn AddStream,
     codegen(C, TM.get(), AddStream, 0, *Mod);
   } else {
     splitCodeGen(C, TM.get(), AddStream, ParallelCodeGenParallelismLevel,
-                 std::move(Mod));
+                 std::move(Mod), /*OptimizePartitions=*/false);
   }
   finalizeOptimizationRemarks(std::move(DiagnosticOutputFile));
   return Error::success();
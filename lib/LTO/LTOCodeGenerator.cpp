@@ -104,6 +104,12 @@ cl::opt<bool> LTOPassRemarksWithHotness(
     cl::Hidden);
 }
 
+static cl::opt<bool> LTOBalanceCodeGenPartitions(
+    "lto-balance-codegen-partitions",
+    cl::desc("Balance parallel code generation partitions by estimated code "
+             "size"),
+    cl::init(false), cl::Hidden);
+
 LTOCodeGenerator::LTOCodeGenerator(LLVMContext &Context)
     : Context(Context), MergedModule(new Module("ld-temp.o", Context)),
       TheLinker(new Linker(*MergedModule)) {
@@ -591,7 +597,8 @@ bool LTOCodeGenerator::compileOptimized(ArrayRef<raw_pwrite_stream *> Out) {
   // MergedModule.
   MergedModule = splitCodeGen(std::move(MergedModule), Out, {},
                               [&]() { return createTargetMachine(); }, FileType,
-                              ShouldRestoreGlobalsLinkage);
+                              ShouldRestoreGlobalsLinkage,
+                              LTOBalanceCodeGenPartitions);
 
   // If statistics were requested, print them out after codegen.
   if (llvm::AreStatisticsEnabled())
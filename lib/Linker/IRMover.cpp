@@ -1032,6 +1032,8 @@ void IRLinker::prepareCompileUnitsForImport() {
     // if reached from the mapped IR. Do this by setting their value map
     // entries to nullptr, which will automatically prevent their importing
     // when reached from the DICompileUnit during metadata mapping.
+    // When the source module's metadata is lazy-loaded for importing, the
+    // bitcode reader doesn't even load these lists and they are null here.
     ValueMap.MD()[CU->getRawEnumTypes()].reset(nullptr);
     ValueMap.MD()[CU->getRawMacros()].reset(nullptr);
     ValueMap.MD()[CU->getRawRetainedTypes()].reset(nullptr);
@@ -548,6 +548,75 @@ data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
   return DataBuffer;
 }
 
+bool InstrProfLookupTrait::findRecord(const unsigned char *D, offset_type N,
+                                      uint64_t FuncHash,
+                                      IndexedInstrProfRecordRef &Record,
+                                      bool &Found) const {
+  using namespace support;
+
+  // This walks the records the same way ReadData does, but only reads their
+  // headers.
+  Found = false;
+  if (N % sizeof(uint64_t))
+    return false;
+
+  const unsigned char *End = D + N;
+  while (D < End) {
+    if (D + sizeof(uint64_t) >= End)
+      return false;
+    uint64_t Hash = endian::readNext<uint64_t, little, unaligned>(D);
+
+    uint64_t CountsSize = N / sizeof(uint64_t) - 1;
+    if (GET_VERSION(FormatVersion) != IndexedInstrProf::ProfVersion::Version1) {
+      if (D + sizeof(uint64_t) > End)
+        return false;
+      CountsSize = endian::readNext<uint64_t, little, unaligned>(D);
+    }
+    if (CountsSize > uint64_t(End - D) / sizeof(uint64_t))
+      return false;
+    ArrayRef<ulittle64_t> Counts(reinterpret_cast<const ulittle64_t *>(D),
+                                 CountsSize);
+    D += CountsSize * sizeof(uint64_t);
+
+    // Skip the value profiling data. It starts with its total size.
+    const unsigned char *ValueData = D;
+    if (GET_VERSION(FormatVersion) > IndexedInstrProf::ProfVersion::Version2) {
+      if (D + sizeof(uint32_t) > End)
+        return false;
+      uint32_t TotalSize =
+          endian::read<uint32_t, unaligned>(D, ValueProfDataEndianness);
+      if (TotalSize < sizeof(ValueProfData) || TotalSize > uint64_t(End - D))
+        return false;
+      D += TotalSize;
+    }
+
+    if (Hash == FuncHash) {
+      Record.Hash = Hash;
+      Record.Counts = Counts;
+      Record.ValueProfData = makeArrayRef(ValueData, D);
+      Found = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+template <typename HashTableImpl>
+Error InstrProfReaderIndex<HashTableImpl>::getRecordRef(
+    StringRef FuncName, uint64_t FuncHash, IndexedInstrProfRecordRef &Record) {
+  auto Iter = HashTable->find(FuncName);
+  if (Iter == HashTable->end())
+    return make_error<InstrProfError>(instrprof_error::unknown_function);
+
+  bool Found;
+  if (!HashTable->getInfoObj().findRecord(Iter.getDataPtr(), Iter.getDataLen(),
+                                          FuncHash, Record, Found))
+    return make_error<InstrProfError>(instrprof_error::malformed);
+  if (!Found)
+    return make_error<InstrProfError>(instrprof_error::hash_mismatch);
+  return Error::success();
+}
+
 template <typename HashTableImpl>
 Error InstrProfReaderIndex<HashTableImpl>::getRecords(
     StringRef FuncName, ArrayRef<NamedInstrProfRecord> &Data) {
@@ -704,31 +773,55 @@ InstrProfSymtab &IndexedInstrProfReader::getSymtab() {
   return *Symtab.get();
 }
 
+Expected<IndexedInstrProfRecordRef>
+IndexedInstrProfReader::getInstrProfRecordRef(StringRef FuncName,
+                                              uint64_t FuncHash) {
+  IndexedInstrProfRecordRef Record;
+  if (Error E = Index->getRecordRef(FuncName, FuncHash, Record)) {
+    // Like a read error, a hash mismatch is recorded as the last error.
+    instrprof_error IPE = InstrProfError::take(std::move(E));
+    if (IPE == instrprof_error::hash_mismatch)
+      return error(IPE);
+    return make_error<InstrProfError>(IPE);
+  }
+  return Record;
+}
+
 Expected<InstrProfRecord>
 IndexedInstrProfReader::getInstrProfRecord(StringRef FuncName,
                                            uint64_t FuncHash) {
-  ArrayRef<NamedInstrProfRecord> Data;
-  Error Err = Index->getRecords(FuncName, Data);
-  if (Err)
-    return std::move(Err);
-  // Found it. Look for counters with the right hash.
-  for (unsigned I = 0, E = Data.size(); I < E; ++I) {
-    // Check for a match and fill the vector if there is one.
-    if (Data[I].Hash == FuncHash) {
-      return std::move(Data[I]);
+  // Only decode the record that matches, rather than all the records with
+  // this name.
+  Expected<IndexedInstrProfRecordRef> RecordRef =
+      getInstrProfRecordRef(FuncName, FuncHash);
+  if (Error E = RecordRef.takeError())
+    return std::move(E);
+
+  InstrProfRecord Record(std::vector<uint64_t>(RecordRef->Counts.begin(),
+                                               RecordRef->Counts.end()));
+  ArrayRef<uint8_t> ValueData = RecordRef->ValueProfData;
+  if (!ValueData.empty()) {
+    Expected<std::unique_ptr<ValueProfData>> VDataPtrOrErr =
+        ValueProfData::getValueProfData(ValueData.begin(), ValueData.end(),
+                                        Index->getValueProfDataEndianness());
+    if (Error E = VDataPtrOrErr.takeError()) {
+      consumeError(std::move(E));
+      return error(instrprof_error::malformed);
     }
+    VDataPtrOrErr.get()->deserializeTo(Record, nullptr);
   }
-  return error(instrprof_error::hash_mismatch);
+  return std::move(Record);
 }
 
 Error IndexedInstrProfReader::getFunctionCounts(StringRef FuncName,
                                                 uint64_t FuncHash,
                                                 std::vector<uint64_t> &Counts) {
-  Expected<InstrProfRecord> Record = getInstrProfRecord(FuncName, FuncHash);
+  Expected<IndexedInstrProfRecordRef> Record =
+      getInstrProfRecordRef(FuncName, FuncHash);
   if (Error E = Record.takeError())
     return error(std::move(E));
 
-  Counts = Record.get().Counts;
+  Counts.assign(Record->Counts.begin(), Record->Counts.end());
   return success();
 }
 
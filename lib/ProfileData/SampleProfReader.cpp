@@ -8,15 +8,17 @@
 //===----------------------------------------------------------------------===//
 //
 // This file implements the class that reads LLVM sample profiles. It
-// supports three file formats: text, binary and gcov.
+// supports four file formats: text, binary, compact binary and gcov.
 //
 // The textual representation is useful for debugging and testing purposes. The
 // binary representation is more compact, resulting in smaller file sizes.
+// The compact binary representation additionally indexes the functions, so
+// that only the profiles of the functions being compiled need to be read.
 //
 // The gcov encoding is the one generated by GCC's AutoFDO profile creation
 // tool (https://github.com/google/autofdo)
 //
-// All three encodings can be used interchangeably as an input sample profile.
+// All four encodings can be used interchangeably as an input sample profile.
 //
 //===----------------------------------------------------------------------===//
 
@@ -24,12 +26,15 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
 #include "llvm/IR/ProfileSummary.h"
 #include "llvm/ProfileData/ProfileCommon.h"
 #include "llvm/ProfileData/SampleProf.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -373,29 +378,63 @@ SampleProfileReaderBinary::readProfile(FunctionSamples &FProfile) {
   return sampleprof_error::success;
 }
 
+std::error_code SampleProfileReaderBinary::readFuncProfile() {
+  auto NumHeadSamples = readNumber<uint64_t>();
+  if (std::error_code EC = NumHeadSamples.getError())
+    return EC;
+
+  auto FName(readStringFromTable());
+  if (std::error_code EC = FName.getError())
+    return EC;
+
+  Profiles[*FName] = FunctionSamples();
+  FunctionSamples &FProfile = Profiles[*FName];
+  FProfile.setName(*FName);
+
+  FProfile.addHeadSamples(*NumHeadSamples);
+
+  if (std::error_code EC = readProfile(FProfile))
+    return EC;
+  return sampleprof_error::success;
+}
+
 std::error_code SampleProfileReaderBinary::read() {
   while (!at_eof()) {
-    auto NumHeadSamples = readNumber<uint64_t>();
-    if (std::error_code EC = NumHeadSamples.getError())
-      return EC;
-
-    auto FName(readStringFromTable());
-    if (std::error_code EC = FName.getError())
+    if (std::error_code EC = readFuncProfile())
       return EC;
+  }
 
-    Profiles[*FName] = FunctionSamples();
-    FunctionSamples &FProfile = Profiles[*FName];
-    FProfile.setName(*FName);
+  return sampleprof_error::success;
+}
 
-    FProfile.addHeadSamples(*NumHeadSamples);
+std::error_code SampleProfileReaderCompactBinary::read() {
+  if (UseAllFuncs)
+    return SampleProfileReaderBinary::read();
 
-    if (std::error_code EC = readProfile(FProfile))
+  const uint8_t *Start =
+      reinterpret_cast<const uint8_t *>(Buffer->getBufferStart());
+  for (uint64_t FuncMD5 : FuncsToUse) {
+    auto I = FuncOffsetTable.find(FuncMD5);
+    if (I == FuncOffsetTable.end())
+      continue;
+    Data = Start + I->second;
+    if (std::error_code EC = readFuncProfile())
       return EC;
   }
 
   return sampleprof_error::success;
 }
 
+void SampleProfileReaderCompactBinary::collectFuncsToUse(const Module &M) {
+  UseAllFuncs = false;
+  FuncsToUse.clear();
+  // The function names in the profile are stripped of any suffix, see
+  // getSamplesFor().
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      FuncsToUse.insert(MD5Hash(F.getName().split('.').first));
+}
+
 std::error_code SampleProfileReaderBinary::readHeader() {
   Data = reinterpret_cast<const uint8_t *>(Buffer->getBufferStart());
   End = Data + Buffer->getBufferSize();
@@ -404,7 +443,7 @@ std::error_code SampleProfileReaderBinary::readHeader() {
   auto Magic = readNumber<uint64_t>();
   if (std::error_code EC = Magic.getError())
     return EC;
-  else if (*Magic != SPMagic())
+  else if (!verifySPMagic(*Magic))
     return sampleprof_error::bad_magic;
 
   // Read the version number.
@@ -432,6 +471,54 @@ std::error_code SampleProfileReaderBinary::readHeader() {
   return sampleprof_error::success;
 }
 
+std::error_code SampleProfileReaderCompactBinary::readHeader() {
+  if (std::error_code EC = SampleProfileReaderBinary::readHeader())
+    return EC;
+  return readFuncOffsetTable();
+}
+
+std::error_code SampleProfileReaderCompactBinary::readFuncOffsetTable() {
+  const uint8_t *Start =
+      reinterpret_cast<const uint8_t *>(Buffer->getBufferStart());
+  const uint8_t *BodyStart = Data;
+  if (End - BodyStart < static_cast<ptrdiff_t>(sizeof(uint64_t)))
+    return sampleprof_error::truncated;
+
+  // The trailer holds the offset of the table, which follows the bodies.
+  const uint8_t *TableEnd = End - sizeof(uint64_t);
+  uint64_t TableOffset = support::endian::read64le(TableEnd);
+  if (TableOffset < uint64_t(BodyStart - Start) ||
+      TableOffset > uint64_t(TableEnd - Start))
+    return sampleprof_error::malformed;
+  const uint8_t *TableStart = Start + TableOffset;
+
+  Data = TableStart;
+  End = TableEnd;
+  auto Size = readNumber<uint64_t>();
+  if (std::error_code EC = Size.getError())
+    return EC;
+  FuncOffsetTable.reserve(*Size);
+  for (uint64_t I = 0; I < *Size; ++I) {
+    auto FuncMD5 = readNumber<uint64_t>();
+    if (std::error_code EC = FuncMD5.getError())
+      return EC;
+
+    auto Offset = readNumber<uint64_t>();
+    if (std::error_code EC = Offset.getError())
+      return EC;
+    if (*Offset < uint64_t(BodyStart - Start) || *Offset >= TableOffset)
+      return sampleprof_error::malformed;
+
+    FuncOffsetTable[*FuncMD5] = *Offset;
+  }
+
+  // Leave the reader positioned at the first function body, so that reading
+  // all the profiles stops at the table.
+  Data = BodyStart;
+  End = TableStart;
+  return sampleprof_error::success;
+}
+
 std::error_code SampleProfileReaderBinary::readSummaryEntry(
     std::vector<ProfileSummaryEntry> &Entries) {
   auto Cutoff = readNumber<uint64_t>();
@@ -495,6 +582,13 @@ bool SampleProfileReaderBinary::hasFormat(const MemoryBuffer &Buffer) {
   return Magic == SPMagic();
 }
 
+bool SampleProfileReaderCompactBinary::hasFormat(const MemoryBuffer &Buffer) {
+  const uint8_t *Data =
+      reinterpret_cast<const uint8_t *>(Buffer.getBufferStart());
+  uint64_t Magic = decodeULEB128(Data);
+  return Magic == SPMagic(SPF_Compact_Binary);
+}
+
 std::error_code SampleProfileReaderGCC::skipNextWord() {
   uint32_t dummy;
   if (!GcovBuffer.readInt(dummy))
@@ -786,6 +880,8 @@ SampleProfileReader::create(std::unique_ptr<MemoryBuffer> &B, LLVMContext &C) {
   std::unique_ptr<SampleProfileReader> Reader;
   if (SampleProfileReaderBinary::hasFormat(*B))
     Reader.reset(new SampleProfileReaderBinary(std::move(B), C));
+  else if (SampleProfileReaderCompactBinary::hasFormat(*B))
+    Reader.reset(new SampleProfileReaderCompactBinary(std::move(B), C));
   else if (SampleProfileReaderGCC::hasFormat(*B))
     Reader.reset(new SampleProfileReaderGCC(std::move(B), C));
   else if (SampleProfileReaderText::hasFormat(*B))
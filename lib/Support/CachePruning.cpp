@@ -22,8 +22,10 @@
 
 #define DEBUG_TYPE "cache-pruning"
 
+#include <algorithm>
 #include <set>
 #include <system_error>
+#include <vector>
 
 using namespace llvm;
 
@@ -113,6 +115,15 @@ llvm::parseCachePruningPolicy(StringRef PolicyStr) {
         return make_error<StringError>("'" + Value + "' not an integer",
                                        inconvertibleErrorCode());
       Policy.MaxSizeBytes = Size * Mult;
+    } else if (Key == "prune_by") {
+      if (Value == "size")
+        Policy.PruneByCost = false;
+      else if (Value == "cost")
+        Policy.PruneByCost = true;
+      else
+        return make_error<StringError>("'" + Value +
+                                           "' must be one of 'size' or 'cost'",
+                                       inconvertibleErrorCode());
     } else {
       return make_error<StringError>("Unknown key: '" + Key + "'",
                                      inconvertibleErrorCode());
@@ -122,6 +133,15 @@ llvm::parseCachePruningPolicy(StringRef PolicyStr) {
   return Policy;
 }
 
+/// Returns CostMs * Size, which needs up to 96 bits, as a (high, low) pair of
+/// which the low half holds the low 32 bits.
+static std::pair<uint64_t, uint64_t> mulCostBySize(uint32_t CostMs,
+                                                   uint64_t Size) {
+  uint64_t Low = uint64_t(CostMs) * (Size & 0xffffffff);
+  uint64_t High = uint64_t(CostMs) * (Size >> 32) + (Low >> 32);
+  return std::make_pair(High, Low & 0xffffffff);
+}
+
 /// Prune the cache of files that haven't been accessed in a long time.
 bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
   using namespace std::chrono;
@@ -139,6 +159,10 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
   Policy.MaxSizePercentageOfAvailableSpace =
       std::min(Policy.MaxSizePercentageOfAvailableSpace, 100u);
 
+  // Without a way to find the cost of the entries, fall back to size order.
+  if (Policy.PruneByCost && !Policy.GetEntryCost)
+    Policy.PruneByCost = false;
+
   if (Policy.Expiration == seconds(0) &&
       Policy.MaxSizePercentageOfAvailableSpace == 0 &&
       Policy.MaxSizeBytes == 0) {
@@ -185,15 +209,27 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
   // Keep track of space
   std::set<std::pair<uint64_t, std::string>> FileSizes;
   uint64_t TotalSize = 0;
+  // The files to consider for cost-based pruning, with their recorded cost.
+  struct CostedFile {
+    uint32_t CostMs;
+    uint64_t Size;
+    std::string Path;
+  };
+  std::vector<CostedFile> CostedFiles;
   // Helper to add a path to the set of files to consider for size-based
   // pruning, sorted by size.
   auto AddToFileListForSizePruning =
       [&](StringRef Path) {
         if (!ShouldComputeSize)
           return;
-        TotalSize += FileStatus.getSize();
-        FileSizes.insert(
-            std::make_pair(FileStatus.getSize(), std::string(Path)));
+        uint64_t Size = FileStatus.getSize();
+        TotalSize += Size;
+        if (!Policy.PruneByCost) {
+          FileSizes.insert(std::make_pair(Size, std::string(Path)));
+          return;
+        }
+        if (Optional<uint32_t> CostMs = Policy.GetEntryCost(Path))
+          CostedFiles.push_back({*CostMs, Size, Path});
       };
 
   // Walk the entire directory cache, looking for unused files.
@@ -218,7 +254,10 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
     }
 
     // If the file hasn't been used recently enough, delete it
-    const auto FileAccessTime = FileStatus.getLastAccessedTime();
+    const auto FileAccessTime =
+        Policy.UsesModificationTime && Policy.UsesModificationTime(File->path())
+            ? FileStatus.getLastModificationTime()
+            : FileStatus.getLastAccessedTime();
     auto FileAge = CurrentTime - FileAccessTime;
     if (FileAge > Policy.Expiration) {
       DEBUG(dbgs() << "Remove " << File->path() << " ("
@@ -252,6 +291,25 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
                  << "% target is: " << Policy.MaxSizePercentageOfAvailableSpace
                  << "%, " << Policy.MaxSizeBytes << " bytes\n");
 
+    if (Policy.PruneByCost) {
+      // Remove the files that free the most space per millisecond of
+      // recompilation first. Compare CostMs/Size without dividing.
+      std::sort(CostedFiles.begin(), CostedFiles.end(),
+                [](const CostedFile &L, const CostedFile &R) {
+                  return mulCostBySize(L.CostMs, R.Size) <
+                         mulCostBySize(R.CostMs, L.Size);
+                });
+      for (auto I = CostedFiles.begin(), E = CostedFiles.end();
+           TotalSize > TotalSizeTarget && I != E; ++I) {
+        sys::fs::remove(I->Path);
+        TotalSize -= I->Size;
+        DEBUG(dbgs() << " - Remove " << I->Path << " (size " << I->Size
+                     << ", cost " << I->CostMs << "ms), new occupancy is "
+                     << TotalSize << "\n");
+      }
+      return true;
+    }
+
     auto FileAndSize = FileSizes.rbegin();
     // Remove the oldest accessed files first, till we get below the threshold
     while (TotalSize > TotalSizeTarget && FileAndSize != FileSizes.rend()) {
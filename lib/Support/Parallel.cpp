@@ -9,12 +9,16 @@
 
 #include "llvm/Support/Parallel.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
 
 #include <atomic>
+#include <deque>
 #include <stack>
 #include <thread>
+#include <vector>
 
 using namespace llvm;
+using parallel::detail::ExecutorKind;
 
 namespace {
 
@@ -24,7 +28,12 @@ public:
   virtual ~Executor() = default;
   virtual void add(std::function<void()> func) = 0;
 
-  static Executor *getDefaultExecutor();
+#if LLVM_ENABLE_THREADS
+  /// Blocks until the count of \p L reaches zero.
+  virtual void wait(const parallel::detail::Latch &L) { L.sync(); }
+#endif
+
+  static Executor *getExecutor(ExecutorKind Kind);
 };
 
 #if !LLVM_ENABLE_THREADS
@@ -33,7 +42,7 @@ public:
   virtual void add(std::function<void()> F) { F(); }
 };
 
-Executor *Executor::getDefaultExecutor() {
+Executor *Executor::getExecutor(ExecutorKind Kind) {
   static SyncExecutor Exec;
   return &Exec;
 }
@@ -60,7 +69,7 @@ public:
   }
 };
 
-Executor *Executor::getDefaultExecutor() {
+Executor *Executor::getExecutor(ExecutorKind Kind) {
   static ConcRTExecutor exec;
   return &exec;
 }
@@ -120,8 +129,160 @@ private:
   parallel::detail::Latch Done;
 };
 
-Executor *Executor::getDefaultExecutor() {
-  static ThreadPoolExecutor exec;
+class WorkStealingExecutor;
+
+// The executor the current thread is a worker of, and the index of its deque.
+static LLVM_THREAD_LOCAL WorkStealingExecutor *CurrentExecutor = nullptr;
+static LLVM_THREAD_LOCAL unsigned CurrentWorker = 0;
+// How many TaskGroups the current worker is running queued tasks for.
+static LLVM_THREAD_LOCAL unsigned HelpDepth = 0;
+
+/// \brief An implementation of an Executor that gives each worker thread its
+///   own task deque. Workers push and pop their own tasks in filo order and
+///   steal tasks in fifo order from the other workers when they run dry, so
+///   there is no single queue lock all threads contend on.
+class WorkStealingExecutor : public Executor {
+public:
+  explicit WorkStealingExecutor(
+      unsigned ThreadCount = std::thread::hardware_concurrency())
+      : Queues(std::max(ThreadCount, 1u)), Done(Queues.size()) {
+    // Spawn all but one of the threads in another thread as spawning threads
+    // can take a while.
+    unsigned NumWorkers = Queues.size();
+    std::thread([&, NumWorkers] {
+      for (unsigned I = 1; I < NumWorkers; ++I)
+        std::thread([=] { work(I); }).detach();
+      work(0);
+    }).detach();
+  }
+
+  ~WorkStealingExecutor() override {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Stop = true;
+    Lock.unlock();
+    Cond.notify_all();
+    // Wait for ~Latch.
+  }
+
+  void add(std::function<void()> F) override {
+    // Tasks spawned by a worker go to its own deque. Tasks coming from
+    // outside the pool are spread over the deques round-robin.
+    unsigned Idx = CurrentExecutor == this
+                       ? CurrentWorker
+                       : NextQueue.fetch_add(1) % Queues.size();
+    // Count the task before publishing it, so that Pending never drops below
+    // the number of queued tasks when a worker takes it right away.
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      ++Pending;
+    }
+    {
+      std::lock_guard<std::mutex> Lock(Queues[Idx].Mutex);
+      Queues[Idx].Tasks.push_back(std::move(F));
+    }
+    Cond.notify_one();
+  }
+
+  void wait(const parallel::detail::Latch &L) override {
+    // Each task run here nests on the waiter's stack, and may wait for a
+    // group of its own. Past MaxHelpDepth, block and leave the group to the
+    // other workers.
+    if (CurrentExecutor != this || HelpDepth >= MaxHelpDepth) {
+      L.sync();
+      return;
+    }
+    // A worker that blocked here would be lost to the pool while the group
+    // runs, and with nested groups every worker could end up waiting for
+    // tasks nobody is left to run. Keep running queued tasks instead, and
+    // sleep until either a task is queued or one finishes.
+    ++HelpDepth;
+    while (!L.done()) {
+      std::function<void()> Task;
+      if (getTask(CurrentWorker, Task)) {
+        runTask(Task);
+        continue;
+      }
+      std::unique_lock<std::mutex> Lock(Mutex);
+      ++Waiters;
+      Cond.wait(Lock, [&] { return Pending != 0 || L.done(); });
+      --Waiters;
+    }
+    --HelpDepth;
+  }
+
+private:
+  struct WorkQueue {
+    std::mutex Mutex;
+    std::deque<std::function<void()>> Tasks;
+  };
+
+  static const unsigned MaxHelpDepth = 64;
+
+  /// Runs \p Task and wakes up the workers waiting in wait(), as the task
+  /// may have completed their group.
+  void runTask(std::function<void()> &Task) {
+    Task();
+    if (Waiters != 0) {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Cond.notify_all();
+    }
+  }
+
+  /// Pops the newest task of worker Idx, or steals the oldest task of the
+  /// first other worker that has one.
+  bool getTask(unsigned Idx, std::function<void()> &Task) {
+    for (unsigned I = 0, E = Queues.size(); I != E; ++I) {
+      WorkQueue &Q = Queues[(Idx + I) % E];
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      if (Q.Tasks.empty())
+        continue;
+      if (I == 0) {
+        Task = std::move(Q.Tasks.back());
+        Q.Tasks.pop_back();
+      } else {
+        Task = std::move(Q.Tasks.front());
+        Q.Tasks.pop_front();
+      }
+      --Pending;
+      return true;
+    }
+    return false;
+  }
+
+  void work(unsigned Idx) {
+    CurrentExecutor = this;
+    CurrentWorker = Idx;
+    while (true) {
+      std::function<void()> Task;
+      if (getTask(Idx, Task)) {
+        runTask(Task);
+        continue;
+      }
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Cond.wait(Lock, [&] { return Stop || Pending != 0; });
+      if (Stop)
+        break;
+    }
+    Done.dec();
+  }
+
+  std::atomic<bool> Stop{false};
+  std::atomic<size_t> Pending{0};
+  /// Number of workers sleeping in wait().
+  std::atomic<unsigned> Waiters{0};
+  std::atomic<unsigned> NextQueue{0};
+  std::vector<WorkQueue> Queues;
+  std::mutex Mutex;
+  std::condition_variable Cond;
+  parallel::detail::Latch Done;
+};
+
+Executor *Executor::getExecutor(ExecutorKind Kind) {
+  if (Kind == ExecutorKind::SharedQueue) {
+    static ThreadPoolExecutor exec;
+    return &exec;
+  }
+  static WorkStealingExecutor exec;
   return &exec;
 }
 #endif
@@ -130,9 +291,13 @@ Executor *Executor::getDefaultExecutor() {
 #if LLVM_ENABLE_THREADS
 void parallel::detail::TaskGroup::spawn(std::function<void()> F) {
   L.inc();
-  Executor::getDefaultExecutor()->add([&, F] {
+  Executor::getExecutor(Kind)->add([&, F] {
     F();
     L.dec();
   });
 }
+
+void parallel::detail::TaskGroup::sync() const {
+  Executor::getExecutor(Kind)->wait(L);
+}
 #endif
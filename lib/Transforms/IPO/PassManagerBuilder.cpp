@@ -685,7 +685,7 @@ void PassManagerBuilder::populateModulePassManager(
   addExtensionsToPM(EP_OptimizerLast, MPM);
 }
 
-void PassManagerBuilder::addLTOOptimizationPasses(legacy::PassManagerBase &PM) {
+void PassManagerBuilder::addLTOIPOPasses(legacy::PassManagerBase &PM) {
   // Remove unused virtual tables to improve the quality of code generated by
   // whole-program devirtualization and bitset lowering.
   PM.add(createGlobalDCEPass());
@@ -766,7 +766,10 @@ void PassManagerBuilder::addLTOOptimizationPasses(legacy::PassManagerBase &PM) {
   // If we didn't decide to inline a function, check to see if we can
   // transform it to pass arguments by value instead of by reference.
   PM.add(createArgumentPromotionPass());
+}
 
+void PassManagerBuilder::addLTOFunctionOptimizationPasses(
+    legacy::PassManagerBase &PM) {
   // The IPO passes may leave cruft around.  Clean up after them.
   addInstructionCombiningPass(PM);
   addExtensionsToPM(EP_Peephole, PM);
@@ -826,6 +829,12 @@ void PassManagerBuilder::addLTOOptimizationPasses(legacy::PassManagerBase &PM) {
   PM.add(createJumpThreadingPass());
 }
 
+void PassManagerBuilder::addLTOOptimizationPasses(legacy::PassManagerBase &PM) {
+  addLTOIPOPasses(PM);
+  if (OptLevel > 1)
+    addLTOFunctionOptimizationPasses(PM);
+}
+
 void PassManagerBuilder::addLateLTOOptimizationPasses(
     legacy::PassManagerBase &PM) {
   // Delete basic blocks, which optimization passes may have killed.
@@ -906,6 +915,53 @@ void PassManagerBuilder::populateLTOPassManager(legacy::PassManagerBase &PM) {
     PM.add(createVerifierPass());
 }
 
+void PassManagerBuilder::populateLTOIPOPassManager(
+    legacy::PassManagerBase &PM) {
+  if (LibraryInfo)
+    PM.add(new TargetLibraryInfoWrapperPass(*LibraryInfo));
+
+  if (VerifyInput)
+    PM.add(createVerifierPass());
+
+  if (OptLevel != 0)
+    addLTOIPOPasses(PM);
+  else
+    PM.add(createWholeProgramDevirtPass(ExportSummary, nullptr));
+
+  // CFI lowering needs to see the whole program, so it runs before the module
+  // is partitioned rather than at the end of the pipeline.
+  PM.add(createCrossDSOCFIPass());
+  PM.add(createLowerTypeTestsPass(ExportSummary, nullptr));
+
+  if (OptLevel != 0) {
+    // The inliner has run, so available externally bodies are of no further
+    // use, and dropping them keeps them out of the partitions.
+    PM.add(createEliminateAvailableExternallyPass());
+    PM.add(createGlobalDCEPass());
+  }
+}
+
+void PassManagerBuilder::populateLTOPartitionPassManager(
+    legacy::PassManagerBase &PM) {
+  if (LibraryInfo)
+    PM.add(new TargetLibraryInfoWrapperPass(*LibraryInfo));
+
+  if (OptLevel > 1) {
+    addInitialAliasAnalysisPasses(PM);
+    addLTOFunctionOptimizationPasses(PM);
+  }
+
+  if (OptLevel != 0) {
+    // Delete basic blocks, which optimization passes may have killed.
+    PM.add(createCFGSimplificationPass());
+    if (MergeFunctions)
+      PM.add(createMergeFunctionsPass());
+  }
+
+  if (VerifyOutput)
+    PM.add(createVerifierPass());
+}
+
 inline PassManagerBuilder *unwrap(LLVMPassManagerBuilderRef P) {
     return reinterpret_cast<PassManagerBuilder*>(P);
 }
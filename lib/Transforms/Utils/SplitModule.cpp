@@ -73,12 +73,27 @@ static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
   }
 }
 
+// Returns the weight GV contributes to a partition. Without size balancing
+// every global counts as one, otherwise functions are weighted by their
+// instruction count, which roughly tracks the cost of code generating them.
+static unsigned getGlobalWeight(const GlobalValue *GV, bool BalanceBySize) {
+  unsigned Weight = 1;
+  if (!BalanceBySize)
+    return Weight;
+  if (const Function *F = dyn_cast<Function>(GV))
+    for (const BasicBlock &BB : *F)
+      Weight += BB.size();
+  return Weight;
+}
+
 // Find partitions for module in the way that no locals need to be
 // globalized.
 // Try to balance pack those partitions into N files since this roughly equals
 // thread balancing for the backend codegen step.
+// If BalanceBySize is true, every definition takes part in the balancing,
+// not only the ones that have to be kept together with locals.
 static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
-                           unsigned N) {
+                           unsigned N, bool BalanceBySize) {
   // At this point module should have the proper mix of globals and locals.
   // As we attempt to partition this module, we must not change any
   // locals to globals.
@@ -86,13 +101,17 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   ClusterMapType GVtoClusterMap;
   ComdatMembersType ComdatMembers;
 
-  auto recordGVSet = [&GVtoClusterMap, &ComdatMembers](GlobalValue &GV) {
+  auto recordGVSet = [&GVtoClusterMap, &ComdatMembers,
+                      BalanceBySize](GlobalValue &GV) {
     if (GV.isDeclaration())
       return;
 
     if (!GV.hasName())
       GV.setName("__llvmsplit_unnamed");
 
+    if (BalanceBySize)
+      GVtoClusterMap.insert(&GV);
+
     // Comdat groups must not be partitioned. For comdat groups that contain
     // locals, record all their members here so we can keep them together.
     // Comdat groups that only contain external globals are already handled by
@@ -128,9 +147,10 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   std::for_each(M->begin(), M->end(), recordGVSet);
   std::for_each(M->global_begin(), M->global_end(), recordGVSet);
   std::for_each(M->alias_begin(), M->alias_end(), recordGVSet);
+  std::for_each(M->ifunc_begin(), M->ifunc_end(), recordGVSet);
 
-  // Assigned all GVs to merged clusters while balancing number of objects in
-  // each.
+  // Assigned all GVs to merged clusters while balancing the total weight of
+  // objects in each.
   auto CompareClusters = [](const std::pair<unsigned, unsigned> &a,
                             const std::pair<unsigned, unsigned> &b) {
     if (a.second || b.second)
@@ -154,11 +174,15 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   // To guarantee determinism, we have to sort SCC according to size.
   // When size is the same, use leader's name.
   for (ClusterMapType::iterator I = GVtoClusterMap.begin(),
-                                E = GVtoClusterMap.end(); I != E; ++I)
-    if (I->isLeader())
-      Sets.push_back(
-          std::make_pair(std::distance(GVtoClusterMap.member_begin(I),
-                                       GVtoClusterMap.member_end()), I));
+                                E = GVtoClusterMap.end(); I != E; ++I) {
+    if (!I->isLeader())
+      continue;
+    unsigned ClusterWeight = 0;
+    for (ClusterMapType::member_iterator MI = GVtoClusterMap.member_begin(I);
+         MI != GVtoClusterMap.member_end(); ++MI)
+      ClusterWeight += getGlobalWeight(*MI, BalanceBySize);
+    Sets.push_back(std::make_pair(ClusterWeight, I));
+  }
 
   std::sort(Sets.begin(), Sets.end(), [](const SortType &a, const SortType &b) {
     if (a.first == b.first)
@@ -184,7 +208,7 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
                    << ((*MI)->hasLocalLinkage() ? " l " : " e ") << "\n");
       Visited.insert(*MI);
       ClusterIDMap[*MI] = CurrentClusterID;
-      CurrentClusterSize++;
+      CurrentClusterSize += getGlobalWeight(*MI, BalanceBySize);
     }
     // Add this set size to the number of entries in this cluster.
     BalancinQueue.push(std::make_pair(CurrentClusterID, CurrentClusterSize));
@@ -228,7 +252,7 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
 void llvm::SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals) {
+    bool PreserveLocals, bool BalanceBySize) {
   if (!PreserveLocals) {
     for (Function &F : *M)
       externalize(&F);
@@ -243,7 +267,7 @@ void llvm::SplitModule(
   // This performs splitting without a need for externalization, which might not
   // always be possible.
   ClusterIDMapType ClusterIDMap;
-  findPartitions(M.get(), ClusterIDMap, N);
+  findPartitions(M.get(), ClusterIDMap, N, BalanceBySize);
 
   // FIXME: We should be able to reuse M as the last partition instead of
   // cloning it.
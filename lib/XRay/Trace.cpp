@@ -15,6 +15,7 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Process.h"
 #include "llvm/XRay/YAMLXRayRecord.h"
 
 using namespace llvm;
@@ -55,8 +56,7 @@ Error readBinaryFormatHeader(StringRef Data, XRayFileHeader &FileHeader) {
   return Error::success();
 }
 
-Error loadNaiveFormatLog(StringRef Data, XRayFileHeader &FileHeader,
-                         std::vector<XRayRecord> &Records) {
+Error checkNaiveFormatLog(StringRef Data, XRayFileHeader &FileHeader) {
   if (Data.size() < 32)
     return make_error<StringError>(
         "Not enough bytes for an XRay log.",
@@ -67,45 +67,43 @@ Error loadNaiveFormatLog(StringRef Data, XRayFileHeader &FileHeader,
         "Invalid-sized XRay data.",
         std::make_error_code(std::errc::invalid_argument));
 
-  if (auto E = readBinaryFormatHeader(Data, FileHeader))
-    return E;
+  return readBinaryFormatHeader(Data, FileHeader);
+}
 
-  // Each record after the header will be 32 bytes, in the following format:
-  //
-  //   (2)   uint16 : record type
-  //   (1)   uint8  : cpu id
-  //   (1)   uint8  : type
-  //   (4)   sint32 : function id
-  //   (8)   uint64 : tsc
-  //   (4)   uint32 : thread id
-  //   (12)  -      : padding
-  for (auto S = Data.drop_front(32); !S.empty(); S = S.drop_front(32)) {
-    DataExtractor RecordExtractor(S, true, 8);
-    uint32_t OffsetPtr = 0;
-    Records.emplace_back();
-    auto &Record = Records.back();
-    Record.RecordType = RecordExtractor.getU16(&OffsetPtr);
-    Record.CPU = RecordExtractor.getU8(&OffsetPtr);
-    auto Type = RecordExtractor.getU8(&OffsetPtr);
-    switch (Type) {
-    case 0:
-      Record.Type = RecordTypes::ENTER;
-      break;
-    case 1:
-      Record.Type = RecordTypes::EXIT;
-      break;
-    case 2:
-      Record.Type = RecordTypes::TAIL_EXIT;
-      break;
-    default:
-      return make_error<StringError>(
-          Twine("Unknown record type '") + Twine(int{Type}) + "'",
-          std::make_error_code(std::errc::executable_format_error));
-    }
-    Record.FuncId = RecordExtractor.getSigned(&OffsetPtr, sizeof(int32_t));
-    Record.TSC = RecordExtractor.getU64(&OffsetPtr);
-    Record.TId = RecordExtractor.getU32(&OffsetPtr);
+// Each record after the header will be 32 bytes, in the following format:
+//
+//   (2)   uint16 : record type
+//   (1)   uint8  : cpu id
+//   (1)   uint8  : type
+//   (4)   sint32 : function id
+//   (8)   uint64 : tsc
+//   (4)   uint32 : thread id
+//   (12)  -      : padding
+Error readNaiveFormatRecord(StringRef S, XRayRecord &Record) {
+  DataExtractor RecordExtractor(S, true, 8);
+  uint32_t OffsetPtr = 0;
+  Record.RecordType = RecordExtractor.getU16(&OffsetPtr);
+  Record.CPU = RecordExtractor.getU8(&OffsetPtr);
+  auto Type = RecordExtractor.getU8(&OffsetPtr);
+  switch (Type) {
+  case 0:
+    Record.Type = RecordTypes::ENTER;
+    break;
+  case 1:
+    Record.Type = RecordTypes::EXIT;
+    break;
+  case 2:
+    Record.Type = RecordTypes::TAIL_EXIT;
+    break;
+  default:
+    return make_error<StringError>(
+        Twine("Unknown record type '") + Twine(int{Type}) + "'",
+        std::make_error_code(std::errc::executable_format_error));
   }
+  Record.FuncId = RecordExtractor.getSigned(&OffsetPtr, sizeof(int32_t));
+  Record.TSC = RecordExtractor.getU64(&OffsetPtr);
+  Record.TId = RecordExtractor.getU32(&OffsetPtr);
+  Record.CallArgs.clear();
   return Error::success();
 }
 
@@ -241,12 +239,17 @@ Error processCustomEventMarker(FDRState &State, uint8_t RecordFirstByte,
   return Error::success();
 }
 
-/// State transition when a CallArgumentRecord is encountered.
+/// State transition when a CallArgumentRecord is encountered. LastRecord is
+/// the last function record read, if any.
 Error processFDRCallArgumentRecord(FDRState &State, uint8_t RecordFirstByte,
                                    DataExtractor &RecordExtractor,
-                                   std::vector<XRayRecord> &Records) {
+                                   XRayRecord *LastRecord) {
   uint32_t OffsetPtr = 1; // Read starting after the first byte.
-  auto &Enter = Records.back();
+  if (!LastRecord)
+    return make_error<StringError>(
+        "CallArgument needs to be right after a function entry",
+        std::make_error_code(std::errc::executable_format_error));
+  auto &Enter = *LastRecord;
 
   if (Enter.Type != RecordTypes::ENTER)
     return make_error<StringError>(
@@ -264,8 +267,7 @@ Error processFDRCallArgumentRecord(FDRState &State, uint8_t RecordFirstByte,
 /// to determine that this is a metadata record as opposed to a function record.
 Error processFDRMetadataRecord(FDRState &State, uint8_t RecordFirstByte,
                                DataExtractor &RecordExtractor,
-                               size_t &RecordSize,
-                               std::vector<XRayRecord> &Records) {
+                               size_t &RecordSize, XRayRecord *LastRecord) {
   // The remaining 7 bits are the RecordKind enum.
   uint8_t RecordKind = RecordFirstByte >> 1;
   switch (RecordKind) {
@@ -301,7 +303,7 @@ Error processFDRMetadataRecord(FDRState &State, uint8_t RecordFirstByte,
     break;
   case 6: // CallArgument
     if (auto E = processFDRCallArgumentRecord(State, RecordFirstByte,
-                                              RecordExtractor, Records))
+                                              RecordExtractor, LastRecord))
       return E;
     break;
   default:
@@ -314,16 +316,15 @@ Error processFDRMetadataRecord(FDRState &State, uint8_t RecordFirstByte,
   return Error::success();
 }
 
-/// Reads a function record from an FDR format log, appending a new XRayRecord
-/// to the vector being populated and updating the State with a new value
-/// reference value to interpret TSC deltas.
+/// Reads a function record from an FDR format log into Record, and updates
+/// the State with a new value reference value to interpret TSC deltas.
 ///
 /// The XRayRecord constructed includes information from the function record
 /// processed here as well as Thread ID and CPU ID formerly extracted into
 /// State.
 Error processFDRFunctionRecord(FDRState &State, uint8_t RecordFirstByte,
                                DataExtractor &RecordExtractor,
-                               std::vector<XRayRecord> &Records) {
+                               XRayRecord &Record) {
   switch (State.Expects) {
   case FDRState::Token::NEW_BUFFER_RECORD_OR_EOF:
     return make_error<StringError>(
@@ -338,9 +339,8 @@ Error processFDRFunctionRecord(FDRState &State, uint8_t RecordFirstByte,
         "Malformed log. Received Function Record before first CPU record.",
         std::make_error_code(std::errc::executable_format_error));
   default:
-    Records.emplace_back();
-    auto &Record = Records.back();
     Record.RecordType = 0; // Record is type NORMAL.
+    Record.CallArgs.clear();
     // Strip off record type bit and use the next three bits.
     uint8_t RecordType = (RecordFirstByte >> 1) & 0x07;
     switch (RecordType) {
@@ -409,8 +409,8 @@ Error processFDRFunctionRecord(FDRState &State, uint8_t RecordFirstByte,
 /// FunctionSequence: NewCPUId | TSCWrap | FunctionRecord
 /// TSCWrap: 16 byte metadata record with a full 64 bit TSC reading.
 /// FunctionRecord: 8 byte record with FunctionId, entry/exit, and TSC delta.
-Error loadFDRLog(StringRef Data, XRayFileHeader &FileHeader,
-                 std::vector<XRayRecord> &Records) {
+Error checkFDRLog(StringRef Data, XRayFileHeader &FileHeader,
+                  uint64_t &BufferSize) {
   if (Data.size() < 32)
     return make_error<StringError>(
         "Not enough bytes for an XRay log.",
@@ -427,47 +427,112 @@ Error loadFDRLog(StringRef Data, XRayFileHeader &FileHeader,
   if (auto E = readBinaryFormatHeader(Data, FileHeader))
     return E;
 
-  uint64_t BufferSize = 0;
-  {
-    StringRef ExtraDataRef(FileHeader.FreeFormData, 16);
-    DataExtractor ExtraDataExtractor(ExtraDataRef, true, 8);
-    uint32_t ExtraDataOffset = 0;
-    BufferSize = ExtraDataExtractor.getU64(&ExtraDataOffset);
+  StringRef ExtraDataRef(FileHeader.FreeFormData, 16);
+  DataExtractor ExtraDataExtractor(ExtraDataRef, true, 8);
+  uint32_t ExtraDataOffset = 0;
+  BufferSize = ExtraDataExtractor.getU64(&ExtraDataOffset);
+  return Error::success();
+}
+
+} // namespace
+
+class TraceStream::RecordReader {
+public:
+  virtual ~RecordReader() = default;
+
+  /// Reads the next record into Record. Returns false at the end of the log.
+  virtual Expected<bool> readNext(XRayRecord &Record) = 0;
+};
+
+namespace {
+
+class NaiveRecordReader : public TraceStream::RecordReader {
+  // The records that haven't been read yet.
+  StringRef Data;
+
+public:
+  explicit NaiveRecordReader(StringRef Data) : Data(Data) {}
+
+  Expected<bool> readNext(XRayRecord &Record) override {
+    if (Data.empty())
+      return false;
+    if (auto E = readNaiveFormatRecord(Data.take_front(32), Record))
+      return std::move(E);
+    Data = Data.drop_front(32);
+    return true;
   }
-  FDRState State{0,          0, 0, FDRState::Token::NEW_BUFFER_RECORD_OR_EOF,
-                 BufferSize, 0};
-  // RecordSize will tell the loop how far to seek ahead based on the record
-  // type that we have just read.
-  size_t RecordSize = 0;
-  for (auto S = Data.drop_front(32); !S.empty(); S = S.drop_front(RecordSize)) {
-    DataExtractor RecordExtractor(S, true, 8);
+};
+
+/// Reads the records of an FDR log, one thread buffer after the other.
+class FDRRecordReader : public TraceStream::RecordReader {
+  // The records that haven't been read yet.
+  StringRef Data;
+  FDRState State;
+
+  // The call argument records that follow a function entry record are part of
+  // the XRayRecord for that entry, so a function record is only returned once
+  // the next one, or the end of the log, is read.
+  XRayRecord Pending;
+  bool HasPending = false;
+
+public:
+  FDRRecordReader(StringRef Data, uint64_t BufferSize)
+      : Data(Data), State{0,          0, 0,
+                          FDRState::Token::NEW_BUFFER_RECORD_OR_EOF,
+                          BufferSize, 0} {}
+
+  Expected<bool> readNext(XRayRecord &Record) override;
+};
+
+Expected<bool> FDRRecordReader::readNext(XRayRecord &Record) {
+  while (!Data.empty()) {
+    DataExtractor RecordExtractor(Data, true, 8);
     uint32_t OffsetPtr = 0;
+    // RecordSize tells how far to seek ahead based on the record type that we
+    // have just read.
+    size_t RecordSize;
     if (State.Expects == FDRState::Token::SCAN_TO_END_OF_THREAD_BUF) {
       RecordSize = State.CurrentBufferSize - State.CurrentBufferConsumed;
-      if (S.size() < RecordSize) {
+      if (Data.size() < RecordSize) {
         return make_error<StringError>(
             Twine("Incomplete thread buffer. Expected at least ") +
-                Twine(RecordSize) + " bytes but found " + Twine(S.size()),
+                Twine(RecordSize) + " bytes but found " + Twine(Data.size()),
             make_error_code(std::errc::invalid_argument));
       }
       State.CurrentBufferConsumed = 0;
       State.Expects = FDRState::Token::NEW_BUFFER_RECORD_OR_EOF;
+      Data = Data.drop_front(RecordSize);
       continue;
     }
     uint8_t BitField = RecordExtractor.getU8(&OffsetPtr);
     bool isMetadataRecord = BitField & 0x01uL;
     if (isMetadataRecord) {
       RecordSize = 16;
-      if (auto E = processFDRMetadataRecord(State, BitField, RecordExtractor,
-                                            RecordSize, Records))
-        return E;
-    } else { // Process Function Record
-      RecordSize = 8;
-      if (auto E = processFDRFunctionRecord(State, BitField, RecordExtractor,
-                                            Records))
-        return E;
+      if (auto E =
+              processFDRMetadataRecord(State, BitField, RecordExtractor,
+                                       RecordSize,
+                                       HasPending ? &Pending : nullptr))
+        return std::move(E);
+      State.CurrentBufferConsumed += RecordSize;
+      Data = Data.drop_front(RecordSize);
+      continue;
     }
+
+    // Process Function Record
+    RecordSize = 8;
+    XRayRecord Next;
+    if (auto E = processFDRFunctionRecord(State, BitField, RecordExtractor,
+                                          Next))
+      return std::move(E);
     State.CurrentBufferConsumed += RecordSize;
+    Data = Data.drop_front(RecordSize);
+    bool HadPending = HasPending;
+    if (HadPending)
+      Record = std::move(Pending);
+    Pending = std::move(Next);
+    HasPending = true;
+    if (HadPending)
+      return true;
   }
 
   // Having iterated over everything we've been given, we've either consumed
@@ -482,7 +547,11 @@ Error loadFDRLog(StringRef Data, XRayFileHeader &FileHeader,
             Twine(State.CurrentBufferSize - State.CurrentBufferConsumed),
         std::make_error_code(std::errc::executable_format_error));
 
-  return Error::success();
+  if (!HasPending)
+    return false;
+  Record = std::move(Pending);
+  HasPending = false;
+  return true;
 }
 
 Error loadYAMLLog(StringRef Data, XRayFileHeader &FileHeader,
@@ -512,9 +581,46 @@ Error loadYAMLLog(StringRef Data, XRayFileHeader &FileHeader,
                  });
   return Error::success();
 }
+
+class YAMLRecordReader : public TraceStream::RecordReader {
+  std::vector<XRayRecord> Records;
+  size_t Next = 0;
+
+public:
+  explicit YAMLRecordReader(std::vector<XRayRecord> Records)
+      : Records(std::move(Records)) {}
+
+  Expected<bool> readNext(XRayRecord &Record) override {
+    if (Next == Records.size())
+      return false;
+    Record = std::move(Records[Next++]);
+    return true;
+  }
+};
 } // namespace
 
-Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
+TraceStream::TraceStream() = default;
+TraceStream::TraceStream(TraceStream &&Other) = default;
+TraceStream &TraceStream::operator=(TraceStream &&Other) = default;
+TraceStream::~TraceStream() = default;
+
+Expected<bool> TraceStream::readNext(XRayRecord &Record) {
+  return Reader->readNext(Record);
+}
+
+TraceStream::record_iterator &TraceStream::record_iterator::operator++() {
+  assert(S && "Can't increment the end iterator");
+  ErrorAsOutParameter ErrAsOutParam(Err);
+  auto MoreOrErr = S->readNext(Record);
+  if (!MoreOrErr) {
+    *Err = MoreOrErr.takeError();
+    S = nullptr;
+  } else if (!*MoreOrErr)
+    S = nullptr;
+  return *this;
+}
+
+Expected<TraceStream> llvm::xray::openTraceFile(StringRef Filename) {
   int Fd;
   if (auto EC = sys::fs::openFileForRead(Filename, Fd)) {
     return make_error<StringError>(
@@ -523,24 +629,30 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
 
   uint64_t FileSize;
   if (auto EC = sys::fs::file_size(Filename, FileSize)) {
+    sys::Process::SafelyCloseFileDescriptor(Fd);
     return make_error<StringError>(
         Twine("Cannot read log from '") + Filename + "'", EC);
   }
   if (FileSize < 4) {
+    sys::Process::SafelyCloseFileDescriptor(Fd);
     return make_error<StringError>(
         Twine("File '") + Filename + "' too small for XRay.",
         std::make_error_code(std::errc::executable_format_error));
   }
 
   // Map the opened file into memory and use a StringRef to access it later.
+  // The pages are only read when the records they hold are, and can be
+  // reclaimed after that, so this works for logs larger than the memory.
   std::error_code EC;
-  sys::fs::mapped_file_region MappedFile(
+  TraceStream S;
+  S.MappedFile = llvm::make_unique<sys::fs::mapped_file_region>(
       Fd, sys::fs::mapped_file_region::mapmode::readonly, FileSize, 0, EC);
+  sys::Process::SafelyCloseFileDescriptor(Fd);
   if (EC) {
     return make_error<StringError>(
         Twine("Cannot read log from '") + Filename + "'", EC);
   }
-  auto Data = StringRef(MappedFile.data(), MappedFile.size());
+  auto Data = StringRef(S.MappedFile->data(), S.MappedFile->size());
 
   // Attempt to detect the file type using file magic. We have a slight bias
   // towards the binary format, and we do this by making sure that the first 4
@@ -555,7 +667,7 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
   //
   // Only if we can't load either the binary or the YAML format will we yield an
   // error.
-  StringRef Magic(MappedFile.data(), 4);
+  StringRef Magic(Data.data(), 4);
   DataExtractor HeaderExtractor(Magic, true, 8);
   uint32_t OffsetPtr = 0;
   uint16_t Version = HeaderExtractor.getU16(&OffsetPtr);
@@ -563,16 +675,42 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
 
   enum BinaryFormatType { NAIVE_FORMAT = 0, FLIGHT_DATA_RECORDER_FORMAT = 1 };
 
-  Trace T;
   if (Type == NAIVE_FORMAT && (Version == 1 || Version == 2)) {
-    if (auto E = loadNaiveFormatLog(Data, T.FileHeader, T.Records))
+    if (auto E = checkNaiveFormatLog(Data, S.FileHeader))
       return std::move(E);
+    S.Reader = llvm::make_unique<NaiveRecordReader>(Data.drop_front(32));
   } else if (Version == 1 && Type == FLIGHT_DATA_RECORDER_FORMAT) {
-    if (auto E = loadFDRLog(Data, T.FileHeader, T.Records))
+    uint64_t BufferSize;
+    if (auto E = checkFDRLog(Data, S.FileHeader, BufferSize))
       return std::move(E);
+    S.Reader =
+        llvm::make_unique<FDRRecordReader>(Data.drop_front(32), BufferSize);
   } else {
-    if (auto E = loadYAMLLog(Data, T.FileHeader, T.Records))
+    std::vector<XRayRecord> Records;
+    if (auto E = loadYAMLLog(Data, S.FileHeader, Records))
       return std::move(E);
+    S.Reader = llvm::make_unique<YAMLRecordReader>(std::move(Records));
+  }
+
+  return std::move(S);
+}
+
+Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
+  auto StreamOrErr = openTraceFile(Filename);
+  if (!StreamOrErr)
+    return StreamOrErr.takeError();
+  auto &S = *StreamOrErr;
+
+  Trace T;
+  T.FileHeader = S.getFileHeader();
+  XRayRecord Record;
+  while (true) {
+    auto MoreOrErr = S.readNext(Record);
+    if (!MoreOrErr)
+      return MoreOrErr.takeError();
+    if (!*MoreOrErr)
+      break;
+    T.Records.push_back(std::move(Record));
   }
 
   if (Sort)
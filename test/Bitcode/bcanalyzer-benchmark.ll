@@ -0,0 +1,19 @@
+; RUN: llvm-as < %s | llvm-bcanalyzer -benchmark=3 | FileCheck %s
+
+; CHECK: Benchmark of -:
+; CHECK-NEXT: Iterations: 3
+; CHECK-NEXT: Records per pass: {{[1-9][0-9]*}}
+; CHECK-NEXT: Total time: {{[0-9.]+}}s
+; CHECK-NEXT: Throughput: {{([0-9.]+ MB/s|n/a)}}
+; CHECK-NOT: Summary of
+
+; Exercise arrays of each element encoding: char6 and fixed strings, and VBR6
+; operand lists.
+@str = constant [12 x i8] c"hello_world\00"
+@bytes = constant [4 x i8] c"\FF\00\80\01"
+
+define i64 @f(i64 %a, i64 %b) {
+  %c = add i64 %a, 123456789012
+  %d = mul i64 %c, %b
+  ret i64 %d
+}
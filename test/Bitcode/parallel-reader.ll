@@ -0,0 +1,20 @@
+; Check that decoding the function blocks on worker threads while the module
+; is materialized gives the same module as reading them serially.
+
+; RUN: llvm-as < %S/parallel-writer.ll > %t.bc
+; RUN: llvm-dis < %t.bc > %t.serial.ll
+; RUN: llvm-dis -bitcode-reader-threads=3 < %t.bc > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: llvm-dis -bitcode-reader-threads=16 < %t.bc > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+
+; Errors in function bodies are still diagnosed.
+; RUN: not llvm-dis -disable-output -bitcode-reader-threads=2 \
+; RUN:   %p/Inputs/invalid-call-mismatched-explicit-type.bc 2>&1 | \
+; RUN:   FileCheck --check-prefix=MISMATCHED-EXPLICIT-CALL %s
+; RUN: not llvm-dis -disable-output -bitcode-reader-threads=2 \
+; RUN:   %p/Inputs/invalid-bad-abbrev-number.bc 2>&1 | \
+; RUN:   FileCheck --check-prefix=BAD-ABBREV-NUMBER %s
+
+; MISMATCHED-EXPLICIT-CALL: Explicit call type does not match pointee type of callee operand
+; BAD-ABBREV-NUMBER: Malformed block
@@ -0,0 +1,105 @@
+; Check that encoding the function blocks concurrently produces the same
+; bitcode as encoding them serially, with and without use-list orders.
+
+; RUN: llvm-as -module-hash < %s > %t.serial.bc
+; RUN: llvm-as -module-hash -bitcode-writer-threads=3 < %s > %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+
+; RUN: llvm-as -preserve-bc-uselistorder=false < %s > %t.serial.bc
+; RUN: llvm-as -preserve-bc-uselistorder=false -bitcode-writer-threads=4 \
+; RUN:   < %s > %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+
+; More threads than functions.
+; RUN: llvm-as -bitcode-writer-threads=16 < %s > %t.parallel.bc
+; RUN: llvm-as < %s | cmp - %t.parallel.bc
+
+@g = global i32 0
+@table = global [2 x i8*] [i8* blockaddress(@indirect, %a), i8* blockaddress(@indirect, %b)]
+
+declare void @llvm.dbg.value(metadata, metadata, metadata)
+declare void @ext(i32)
+
+; CHECK: define i32 @first(i32 %x)
+define i32 @first(i32 %x) !dbg !6 {
+entry:
+  call void @llvm.dbg.value(metadata i32 %x, metadata !9, metadata !DIExpression()), !dbg !10
+  %v = load i32, i32* @g, !dbg !10
+  %s = add i32 %v, %x, !dbg !11
+  store i32 %s, i32* @g, !tbaa !12
+  ret i32 %s, !dbg !11
+}
+
+; CHECK: define void @indirect(i8* %p)
+define void @indirect(i8* %p) {
+entry:
+  indirectbr i8* %p, [label %a, label %b]
+a:
+  call void @ext(i32 1)
+  ret void
+b:
+  call void @ext(i32 2)
+  ret void
+}
+
+; CHECK: define i32 @uses(i32 %x, i32 %y)
+define i32 @uses(i32 %x, i32 %y) {
+  %a = add i32 %y, %x
+  %b = mul i32 %x, %y
+  %c = sub i32 %x, %b
+  %d = xor i32 %a, %c
+  ret i32 %d
+  uselistorder i32 %x, { 1, 2, 0 }
+}
+
+define float @consts(float %f) {
+  %a = fadd float %f, 1.5
+  %b = fmul float %a, 2.5
+  %c = select i1 true, float %b, float 0x7FF8000000000000
+  ret float %c
+}
+
+define void @loop(i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %next, %loop ]
+  call void @ext(i32 %i)
+  %next = add i32 %i, 1
+  %done = icmp eq i32 %next, %n
+  br i1 %done, label %exit, label %loop
+exit:
+  ret void
+}
+
+declare void @between()
+
+; CHECK: define i32 @last()
+define i32 @last() {
+  %r = call i32 @first(i32 42), !prof !15
+  call void @between()
+  ret i32 %r
+}
+
+uselistorder i32* @g, { 1, 0 }
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "t.c", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !{i32 2, !"Dwarf Version", i32 4}
+!6 = distinct !DISubprogram(name: "first", scope: !1, file: !1, line: 1, type: !7, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, variables: !2)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null}
+!9 = !DILocalVariable(name: "x", arg: 1, scope: !6, file: !1, line: 1, type: !14)
+!10 = !DILocation(line: 2, column: 3, scope: !6)
+!11 = !DILocation(line: 3, column: 3, scope: !6)
+!12 = !{!13, !13, i64 0}
+!13 = !{!"int", !16}
+!14 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!15 = !{!"branch_weights", i32 7}
+!16 = !{!"tbaa root"}
@@ -0,0 +1,45 @@
+; Check that with -lto-balance-partitions, the code generation partitions are
+; balanced by estimated code size: the large function gets a partition of its
+; own, the small ones are packed together into the other partition.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-lto2 run %t.bc -o %t.o -lto-partitions=2 -lto-balance-partitions \
+; RUN:     -r=%t.bc,big,px -r=%t.bc,small1,px -r=%t.bc,small2,px \
+; RUN:     -r=%t.bc,small3,px
+; RUN: llvm-nm %t.o.0 | FileCheck %s --check-prefix=NM0
+; RUN: llvm-nm %t.o.1 | FileCheck %s --check-prefix=NM1
+
+; NM0-NOT: small
+; NM0: T big
+; NM0-NOT: small
+
+; NM1-NOT: big
+; NM1: T small1
+; NM1: T small2
+; NM1: T small3
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @big(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = add i32 %b, %a
+  %d = mul i32 %c, %b
+  %e = add i32 %d, %c
+  %f = mul i32 %e, %d
+  %g = add i32 %f, %e
+  %h = mul i32 %g, %f
+  ret i32 %h
+}
+
+define i32 @small1(i32 %x) {
+  ret i32 %x
+}
+
+define i32 @small2(i32 %x) {
+  ret i32 %x
+}
+
+define i32 @small3(i32 %x) {
+  ret i32 %x
+}
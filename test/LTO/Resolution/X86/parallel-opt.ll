@@ -0,0 +1,57 @@
+; Check that with -lto-parallel-opt, the function-level optimizations run on
+; each code generation partition, which is then code generated as its own task.
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-lto2 run %t.bc -o %t.o -save-temps -lto-partitions=2 \
+; RUN:     -lto-parallel-opt -r=%t.bc,foo,px -r=%t.bc,bar,px
+; RUN: llvm-dis %t.o.0.4.opt.bc -o %t.opt0.ll
+; RUN: llvm-dis %t.o.1.4.opt.bc -o %t.opt1.ll
+; RUN: grep "^define" %t.opt0.ll | count 1
+; RUN: grep "^define" %t.opt1.ll | count 1
+; RUN: cat %t.opt0.ll %t.opt1.ll | FileCheck %s
+; RUN: cat %t.opt0.ll %t.opt1.ll | FileCheck %s --check-prefix=LICM
+; RUN: llvm-nm %t.o.0 %t.o.1 | FileCheck %s --check-prefix=NM
+
+; CHECK-DAG: define i32 @foo(
+; CHECK-DAG: define i32 @bar(
+
+; NM-DAG: T bar
+; NM-DAG: T foo
+
+; The invariant load in @foo's loop was hoisted into the entry block, which
+; only the function-level part of the pipeline does.
+; LICM-LABEL: define i32 @foo(
+; LICM-NOT: br
+; LICM: load i32, i32*
+
+; Without it, the whole module is optimized as a single task.
+; RUN: llvm-lto2 run %t.bc -o %t2.o -save-temps -lto-partitions=2 \
+; RUN:     -r=%t.bc,foo,px -r=%t.bc,bar,px
+; RUN: llvm-dis %t2.o.0.4.opt.bc -o %t2.opt.ll
+; RUN: FileCheck %s < %t2.opt.ll
+; RUN: FileCheck %s --check-prefix=LICM < %t2.opt.ll
+; RUN: not ls %t2.o.1.4.opt.bc
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @foo(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+  %v = load i32, i32* %p
+  %sum.next = add i32 %sum, %v
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %sum.next
+}
+
+define i32 @bar(i32 %x) {
+  %y = mul i32 %x, 2
+  ret i32 %y
+}
@@ -0,0 +1,16 @@
+#!/usr/bin/env python
+
+# Flips the last byte of every object stored in the compressed ThinLTO cache
+# directory given as argument, so that the object no longer validates.
+
+import glob
+import os
+import sys
+
+for path in glob.glob(os.path.join(sys.argv[1], 'llvmcache-z-*')):
+    with open(path, 'r+b') as f:
+        f.seek(-1, os.SEEK_END)
+        last = bytearray(f.read(1))
+        last[0] ^= 0xff
+        f.seek(-1, os.SEEK_END)
+        f.write(last)
@@ -0,0 +1,59 @@
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; Each object is stored once, along with an entry for its key that refers to
+; it.
+; RUN: rm -Rf %t.cache
+; RUN: llvm-lto2 run -o %t.o %t2.bc  %t.bc -cache-dir %t.cache -compressed-cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache | count 4
+; RUN: ls %t.cache/llvmcache-z-* | count 2
+
+; A second link is served from the cache and produces the same objects.
+; RUN: llvm-lto2 run -o %t.hit.o %t2.bc  %t.bc -cache-dir %t.cache -compressed-cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.o.0 %t.hit.o.0
+; RUN: cmp %t.o.1 %t.hit.o.1
+; RUN: ls %t.cache | count 4
+
+; Entries whose objects have been pruned are misses, and are recreated.
+; RUN: rm %t.cache/llvmcache-z-*
+; RUN: llvm-lto2 run -o %t.miss.o %t2.bc  %t.bc -cache-dir %t.cache -compressed-cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.o.0 %t.miss.o.0
+; RUN: cmp %t.o.1 %t.miss.o.1
+; RUN: ls %t.cache | count 4
+; RUN: ls %t.cache/llvmcache-z-* | count 2
+
+; Corrupted objects fail validation when they are loaded, and are recreated.
+; RUN: %python %p/Inputs/corrupt-cache-objects.py %t.cache
+; RUN: llvm-lto2 run -o %t.corrupt.o %t2.bc  %t.bc -cache-dir %t.cache -compressed-cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.o.0 %t.corrupt.o.0
+; RUN: cmp %t.o.1 %t.corrupt.o.1
+; RUN: ls %t.cache | count 4
+; RUN: ls %t.cache/llvmcache-z-* | count 2
+
+; The recreated objects are valid again.
+; RUN: llvm-lto2 run -o %t.rehit.o %t2.bc  %t.bc -cache-dir %t.cache -compressed-cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.o.0 %t.rehit.o.0
+; RUN: cmp %t.o.1 %t.rehit.o.1
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() #0 {
+entry:
+  ret void
+}
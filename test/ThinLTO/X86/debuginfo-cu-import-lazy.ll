@@ -0,0 +1,24 @@
+; REQUIRES: asserts
+; Check that the enums, macros, retained types and globals lists of the
+; DICompileUnit, which are not imported, are not loaded from the source
+; module either when its metadata is lazy-loaded.
+
+; RUN: opt -module-summary %p/debuginfo-cu-import.ll -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/debuginfo-cu-import.ll -o %t2.bc
+; RUN: llvm-lto -thinlto-action=thinlink -o %t.index.bc %t1.bc %t2.bc
+
+; RUN: llvm-lto -thinlto-action=import %t2.bc -thinlto-index=%t.index.bc \
+; RUN:          -o %t.lazy.bc -stats 2>&1 | FileCheck %s -check-prefix=LAZY
+; LAZY: 74 bitcode-reader  - Number of Metadata records loaded
+; LAZY: 13 bitcode-reader  - Number of MDStrings loaded
+
+; RUN: llvm-lto -thinlto-action=import %t2.bc -thinlto-index=%t.index.bc \
+; RUN:          -o %t.notlazy.bc -disable-ondemand-mds-loading -stats 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=NOTLAZY
+; NOTLAZY: 90 bitcode-reader  - Number of Metadata records loaded
+; NOTLAZY: 19 bitcode-reader  - Number of MDStrings loaded
+
+; The imported metadata is the same either way.
+; RUN: llvm-dis %t.lazy.bc -o - | sed 1d > %t.lazy.ll
+; RUN: llvm-dis %t.notlazy.bc -o - | sed 1d > %t.notlazy.ll
+; RUN: diff %t.lazy.ll %t.notlazy.ll
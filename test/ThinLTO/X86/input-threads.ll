@@ -0,0 +1,31 @@
+; Check that reading the inputs and their summaries concurrently produces the
+; same combined index and objects as reading them serially.
+; RUN: opt -module-summary %s -o %t.bc
+; RUN: opt -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; RUN: llvm-lto2 run -o %t.serial.o %t2.bc %t.bc -save-temps \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: llvm-lto2 run -o %t.parallel.o %t2.bc %t.bc -save-temps \
+; RUN:  -input-threads 4 \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.serial.o.index.bc %t.parallel.o.index.bc
+; RUN: cmp %t.serial.o.0 %t.parallel.o.0
+; RUN: cmp %t.serial.o.1 %t.parallel.o.1
+
+; Errors reading the inputs are still reported.
+; RUN: echo "not bitcode" > %t.bad.bc
+; RUN: not llvm-lto2 run -o %t.bad.o %t.bad.bc -input-threads 4 2>&1 \
+; RUN:  | FileCheck %s --check-prefix=BAD
+; BAD: llvm-lto2: {{.*}}.bad.bc:
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() #0 {
+entry:
+  ret void
+}
@@ -0,0 +1,53 @@
+; REQUIRES: asserts
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; The first link runs the thin link and saves its results.
+; RUN: rm -Rf %t.cache
+; RUN: llvm-lto2 run -o %t.o %t2.bc  %t.bc -thinlink-cache-dir %t.cache \
+; RUN:  -debug-only=lto \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx 2>&1 | FileCheck %s --check-prefix=MISS \
+; RUN:  --allow-empty
+; RUN: ls %t.cache/llvmcache-thinlink-* | count 1
+; MISS-NOT: Loaded the thin link
+
+; A second link with the same inputs loads them and produces the same objects.
+; RUN: llvm-lto2 run -o %t.hit.o %t2.bc  %t.bc -thinlink-cache-dir %t.cache \
+; RUN:  -debug-only=lto \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx 2>&1 | FileCheck %s --check-prefix=HIT
+; RUN: cmp %t.o.0 %t.hit.o.0
+; RUN: cmp %t.o.1 %t.hit.o.1
+; HIT: Loaded the thin link from {{.*}}llvmcache-thinlink-
+
+; The same inputs in another order load the same thin link. The summaries of
+; _globalfunc are then listed in another order, and each must get back its own
+; linkage and liveness. The tasks follow the order of the inputs.
+; RUN: llvm-lto2 run -o %t.rev.o %t.bc  %t2.bc -thinlink-cache-dir %t.cache \
+; RUN:  -debug-only=lto \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx 2>&1 | FileCheck %s --check-prefix=HIT
+; RUN: cmp %t.o.0 %t.rev.o.1
+; RUN: cmp %t.o.1 %t.rev.o.0
+; RUN: ls %t.cache/llvmcache-thinlink-* | count 1
+
+; Different symbol resolutions make a different thin link.
+; RUN: llvm-lto2 run -o %t.other.o %t2.bc  %t.bc -thinlink-cache-dir %t.cache \
+; RUN:  -debug-only=lto \
+; RUN:  -r=%t2.bc,_main,pl \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx 2>&1 | FileCheck %s --check-prefix=MISS \
+; RUN:  --allow-empty
+; RUN: ls %t.cache/llvmcache-thinlink-* | count 2
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() #0 {
+entry:
+  ret void
+}
@@ -0,0 +1,29 @@
+; Check that the time taken by each backend is reported along with the cost
+; estimated for it, which counts both the defined and the imported functions.
+; RUN: opt -module-summary %s -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/funcimport2.ll -o %t2.bc
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -time-thinlto-backends \
+; RUN:     -thinlto-threads=2 \
+; RUN:     -r=%t1.bc,_foo,plx \
+; RUN:     -r=%t2.bc,_main,plx \
+; RUN:     -r=%t2.bc,_foo,l 2>&1 | FileCheck %s
+
+; CHECK: ThinLTO Backend Timing
+; CHECK: ---Wall Time---  --Est. Cost--  --- Module ---
+; CHECK-DAG: {{[0-9]+\.[0-9]+}} (s){{ +}}1 {{.*}}time-backends.ll.tmp1.bc
+; CHECK-DAG: {{[0-9]+\.[0-9]+}} (s){{ +}}3 {{.*}}time-backends.ll.tmp2.bc
+
+; Without the option, nothing is reported.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o \
+; RUN:     -r=%t1.bc,_foo,plx \
+; RUN:     -r=%t2.bc,_main,plx \
+; RUN:     -r=%t2.bc,_foo,l 2>&1 | count 0
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @foo() #0 {
+entry:
+  ret void
+}
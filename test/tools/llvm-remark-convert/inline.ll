@@ -0,0 +1,79 @@
+; Check that the binary remarks file converts to the YAML file written for the
+; same remarks, with locations, hotness and argument locations.
+
+; RUN: opt < %s -S -inline -pass-remarks-with-hotness \
+; RUN:     -pass-remarks-output=%t.yaml > /dev/null
+; RUN: opt < %s -S -inline -pass-remarks-with-hotness \
+; RUN:     -pass-remarks-format=binary -pass-remarks-output=%t.bin > /dev/null
+; RUN: llvm-remark-convert %t.bin -o %t.conv.yaml
+; RUN: diff %t.yaml %t.conv.yaml
+; RUN: llvm-remark-convert < %t.bin | FileCheck %s
+
+; RUN: opt < %s -S -passes=inline -pass-remarks-with-hotness \
+; RUN:     -pass-remarks-format=binary -pass-remarks-output=%t.bin > /dev/null
+; RUN: llvm-remark-convert %t.bin | FileCheck %s
+
+; No remarks still make a valid file.
+; RUN: opt < %s -S -pass-remarks-format=binary -pass-remarks-output=%t.bin \
+; RUN:     > /dev/null
+; RUN: llvm-remark-convert %t.bin | count 0
+
+; RUN: not opt < %s -S -pass-remarks-format=xml -pass-remarks-output=%t.bin \
+; RUN:     2>&1 | FileCheck -check-prefix=FORMAT %s
+; RUN: not llvm-remark-convert %t.yaml 2>&1 | FileCheck -check-prefix=INVALID %s
+
+; CHECK:      --- !Passed
+; CHECK-NEXT: Pass:            inline
+; CHECK-NEXT: Name:            Inlined
+; CHECK-NEXT: DebugLoc:        { File: /tmp/s.c, Line: 4, Column: 10 }
+; CHECK-NEXT: Function:        bar
+; CHECK-NEXT: Hotness:         30
+; CHECK-NEXT: Args:
+; CHECK-NEXT:   - Callee:          foo
+; CHECK-NEXT:     DebugLoc:        { File: /tmp/s.c, Line: 1, Column: 0 }
+; CHECK-NEXT:   - String:          ' inlined into '
+; CHECK-NEXT:   - Caller:          bar
+; CHECK-NEXT:     DebugLoc:        { File: /tmp/s.c, Line: 3, Column: 0 }
+; CHECK:      ...
+
+; FORMAT: for the -pass-remarks-format option: Cannot find option named 'xml'!
+; INVALID: Invalid binary remarks file: bad header
+
+; ModuleID = '/tmp/s.c'
+source_filename = "/tmp/s.c"
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+; Function Attrs: nounwind ssp uwtable
+define i32 @foo() #0 !dbg !7 {
+entry:
+  ret i32 1, !dbg !9
+}
+
+; Function Attrs: nounwind ssp uwtable
+define i32 @bar() #0 !dbg !10 !prof !13 {
+entry:
+  %call = call i32 @foo(), !dbg !11
+  ret i32 %call, !dbg !12
+}
+
+attributes #0 = { nounwind ssp uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="true" "no-frame-pointer-elim-non-leaf" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="core2" "target-features"="+cx16,+fxsr,+mmx,+sse,+sse2,+sse3,+ssse3,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4, !5}
+!llvm.ident = !{!6}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang version 4.0.0 (trunk 282540) (llvm/trunk 282542)", isOptimized: true, runtimeVersion: 0, emissionKind: LineTablesOnly, enums: !2)
+!1 = !DIFile(filename: "/tmp/s.c", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !{i32 1, !"PIC Level", i32 2}
+!6 = !{!"clang version 4.0.0 (trunk 282540) (llvm/trunk 282542)"}
+!7 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 1, type: !8, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, variables: !2)
+!8 = !DISubroutineType(types: !2)
+!9 = !DILocation(line: 1, column: 13, scope: !7)
+!10 = distinct !DISubprogram(name: "bar", scope: !1, file: !1, line: 3, type: !8, isLocal: false, isDefinition: true, scopeLine: 3, isOptimized: true, unit: !0, variables: !2)
+!11 = !DILocation(line: 4, column: 10, scope: !10)
+!12 = !DILocation(line: 4, column: 3, scope: !10)
+!13 = !{!"function_entry_count", i64 30}
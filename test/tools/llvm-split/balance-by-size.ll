@@ -0,0 +1,36 @@
+; RUN: llvm-split -balance-by-size -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; The large function gets a partition of its own, the small ones are packed
+; together into the other partition.
+
+; CHECK0: define i32 @big
+; CHECK1: declare i32 @big
+define i32 @big(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = add i32 %b, %a
+  %d = mul i32 %c, %b
+  %e = add i32 %d, %c
+  %f = mul i32 %e, %d
+  %g = add i32 %f, %e
+  %h = mul i32 %g, %f
+  ret i32 %h
+}
+
+; CHECK0-NOT: define
+; CHECK1: define i32 @small1
+define i32 @small1(i32 %x) {
+  ret i32 %x
+}
+
+; CHECK1: define i32 @small2
+define i32 @small2(i32 %x) {
+  ret i32 %x
+}
+
+; CHECK1: define i32 @small3
+define i32 @small3(i32 %x) {
+  ret i32 %x
+}
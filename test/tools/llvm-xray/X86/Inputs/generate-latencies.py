@@ -0,0 +1,24 @@
+#!/usr/bin/env python
+
+# Prints a YAML trace with as many calls to function 1 as the argument, whose
+# latencies are 1, 2, 3, and so on. Thread 111 makes the calls with odd
+# latencies and thread 222 the others.
+
+import sys
+
+print('---')
+print('header:')
+print('  version: 1')
+print('  type: 0')
+print('  constant-tsc: true')
+print('  nonstop-tsc: true')
+print('  cycle-frequency: 0')
+print('records:')
+tsc = 10000
+for latency in range(1, int(sys.argv[1]) + 1):
+    thread = 111 if latency % 2 else 222
+    for kind, delta in (('function-enter', 0), ('function-exit', latency)):
+        print('  - { type: 0, func-id: 1, cpu: 1, thread: %d, '
+              'kind: %s, tsc: %d }' % (thread, kind, tsc + delta))
+    tsc += latency + 1
+print('...')
@@ -35,8 +35,10 @@
 #include "llvm/Object/MachO.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include <deque>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -1111,8 +1113,7 @@ void DwarfStreamer::emitFDE(uint32_t CIEOffset, uint32_t AddrSize,
 class DwarfLinker {
 public:
   DwarfLinker(StringRef OutputFilename, const LinkOptions &Options)
-      : OutputFilename(OutputFilename), Options(Options),
-        BinHolder(Options.Verbose) {}
+      : OutputFilename(OutputFilename), Options(Options) {}
 
   /// Link the contents of the DebugMap.
   bool link(const DebugMap &);
@@ -1121,6 +1122,18 @@ public:
                      const DWARFDie *DIE = nullptr) const;
 
 private:
+  struct LinkContext;
+
+  /// Load the object file of \p Context, look for its valid relocations
+  /// and parse its debug info. This only touches state owned by \p Context,
+  /// and can thus run concurrently for different objects.
+  void loadDebugObject(LinkContext &Context, const DebugMap &Map);
+
+  /// Link the debug info of an object prepared by loadDebugObject() into
+  /// the output. Objects have to be linked one at a time in debug map
+  /// order.
+  void linkDebugObject(LinkContext &Context, DebugMap &ModuleMap);
+
   /// Called at the start of a debug object link.
   void startDebugObject(DWARFContext &, DebugMapObject &);
 
@@ -1163,11 +1176,17 @@ private:
     /// root DIE selection and during DIE cloning.
     unsigned NextValidReloc;
 
+    /// Warnings found while looking for the valid relocations. That
+    /// search can run ahead of the link on a worker thread, so they
+    /// are only reported when the object gets linked.
+    std::vector<std::string> Warnings;
+
   public:
     RelocationManager(DwarfLinker &Linker)
         : Linker(Linker), NextValidReloc(0) {}
 
     bool hasValidRelocs() const { return !ValidRelocs.empty(); }
+    ArrayRef<std::string> getWarnings() const { return Warnings; }
     /// Reset the NextValidReloc counter.
     void resetValidRelocs() { NextValidReloc = 0; }
 
@@ -1194,6 +1213,26 @@ private:
                           bool isLittleEndian);
   };
 
+  /// The state of a debug map object between the time it is loaded and
+  /// the time it has been linked.
+  struct LinkContext {
+    DebugMapObject &DMO;
+    /// Owns the object file. Every context has its own holder so that
+    /// several objects can be loaded at the same time.
+    BinaryHolder BinHolder;
+    /// The error encountered while loading the object file, if any.
+    std::error_code LoadError;
+    RelocationManager RelocMgr;
+    /// The debug info of the object. Null when the object has no
+    /// valid relocations, as there is nothing to link then.
+    std::unique_ptr<DWARFContext> DwarfContext;
+    /// Errors reported by the DWARF parser while loading the object.
+    std::string DwarfErrors;
+
+    LinkContext(DwarfLinker &Linker, DebugMapObject &DMO)
+        : DMO(DMO), BinHolder(Linker.Options.Verbose), RelocMgr(Linker) {}
+  };
+
   /// \defgroup FindRootDIEs Find DIEs corresponding to debug map entries.
   ///
   /// @{
@@ -1423,14 +1462,13 @@ private:
   bool createStreamer(const Triple &TheTriple, StringRef OutputFilename);
 
   /// Attempt to load a debug object from disk.
-  ErrorOr<const object::ObjectFile &> loadObject(BinaryHolder &BinaryHolder,
-                                                 DebugMapObject &Obj,
-                                                 const DebugMap &Map);
+  static ErrorOr<const object::ObjectFile &>
+  loadObject(BinaryHolder &BinaryHolder, DebugMapObject &Obj,
+             const DebugMap &Map);
   /// @}
 
   std::string OutputFilename;
   LinkOptions Options;
-  BinaryHolder BinHolder;
   std::unique_ptr<DwarfStreamer> Streamer;
   uint64_t OutputDebugInfoSize;
   unsigned UnitID; ///< A unique ID that identifies each compile unit.
@@ -1928,14 +1966,14 @@ findValidRelocsMachO(const object::SectionRef &Section,
     if (isMachOPairedReloc(Obj.getAnyRelocationType(MachOReloc),
                            Obj.getArch())) {
       SkipNext = true;
-      Linker.reportWarning(" unsupported relocation in debug_info section.");
+      Warnings.push_back(" unsupported relocation in debug_info section.");
       continue;
     }
 
     unsigned RelocSize = 1 << Obj.getAnyRelocationLength(MachOReloc);
     uint64_t Offset64 = Reloc.getOffset();
     if ((RelocSize != 4 && RelocSize != 8)) {
-      Linker.reportWarning(" unsupported relocation in debug_info section.");
+      Warnings.push_back(" unsupported relocation in debug_info section.");
       continue;
     }
     uint32_t Offset = Offset64;
@@ -1960,7 +1998,7 @@ findValidRelocsMachO(const object::SectionRef &Section,
       Expected<StringRef> SymbolName = Sym->getName();
       if (!SymbolName) {
         consumeError(SymbolName.takeError());
-        Linker.reportWarning("error getting relocation symbol name.");
+        Warnings.push_back("error getting relocation symbol name.");
         continue;
       }
       if (const auto *Mapping = DMO.lookupSymbol(*SymbolName))
@@ -1983,8 +2021,8 @@ bool DwarfLinker::RelocationManager::findValidRelocs(
   if (auto *MachOObj = dyn_cast<object::MachOObjectFile>(&Obj))
     findValidRelocsMachO(Section, *MachOObj, DMO);
   else
-    Linker.reportWarning(Twine("unsupported object file type: ") +
-                         Obj.getFileName());
+    Warnings.push_back(
+        (Twine("unsupported object file type: ") + Obj.getFileName()).str());
 
   if (ValidRelocs.empty())
     return false;
@@ -3310,14 +3348,9 @@ DwarfLinker::loadObject(BinaryHolder &BinaryHolder, DebugMapObject &Obj,
                         const DebugMap &Map) {
   auto ErrOrObjs =
       BinaryHolder.GetObjectFiles(Obj.getObjectFilename(), Obj.getTimestamp());
-  if (std::error_code EC = ErrOrObjs.getError()) {
-    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
+  if (std::error_code EC = ErrOrObjs.getError())
     return EC;
-  }
-  auto ErrOrObj = BinaryHolder.Get(Map.getTriple());
-  if (std::error_code EC = ErrOrObj.getError())
-    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
-  return ErrOrObj;
+  return BinaryHolder.Get(Map.getTriple());
 }
 
 void DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
@@ -3332,7 +3365,8 @@ void DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
   auto &Obj =
       ModuleMap.addDebugMapObject(Path, sys::TimePoint<std::chrono::seconds>());
   auto ErrOrObj = loadObject(ObjHolder, Obj, ModuleMap);
-  if (!ErrOrObj) {
+  if (std::error_code EC = ErrOrObj.getError()) {
+    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
     // Try and emit more helpful warnings by applying some heuristics.
     StringRef ObjFile = CurrentDebugObject->getObjectFilename();
     bool isClangModule = sys::path::extension(Filename).equals(".pcm");
@@ -3459,6 +3493,100 @@ void DwarfLinker::DIECloner::cloneAllCompileUnits(DWARFContext &DwarfContext) {
   }
 }
 
+void DwarfLinker::loadDebugObject(LinkContext &Context, const DebugMap &Map) {
+  auto ErrOrObj = loadObject(Context.BinHolder, Context.DMO, Map);
+  if (std::error_code EC = ErrOrObj.getError()) {
+    Context.LoadError = EC;
+    return;
+  }
+
+  // Look for relocations that correspond to debug map entries.
+  if (!Context.RelocMgr.findValidRelocsInDebugInfo(*ErrOrObj, Context.DMO))
+    return;
+
+  // Setup access to the debug info.
+  Context.DwarfContext =
+      DWARFContext::create(*ErrOrObj, nullptr, [&](Error E) {
+        Context.DwarfErrors += "error: " + toString(std::move(E)) + "\n";
+        return ErrorPolicy::Continue;
+      });
+
+  // Extracting the DIEs of the units is the bulk of the reading work, do it
+  // here rather than on first use while linking.
+  for (const auto &CU : Context.DwarfContext->compile_units())
+    CU->getUnitDIE(false);
+}
+
+void DwarfLinker::linkDebugObject(LinkContext &Context, DebugMap &ModuleMap) {
+  DebugMapObject &Obj = Context.DMO;
+  CurrentDebugObject = &Obj;
+
+  if (Context.LoadError) {
+    reportWarning(Twine(Obj.getObjectFilename()) + ": " +
+                  Context.LoadError.message());
+    return;
+  }
+
+  RelocationManager &RelocMgr = Context.RelocMgr;
+  for (const std::string &Warning : RelocMgr.getWarnings())
+    reportWarning(Warning);
+  if (!Context.DwarfContext) {
+    if (Options.Verbose)
+      outs() << "No valid relocations found. Skipping.\n";
+    return;
+  }
+  errs() << Context.DwarfErrors;
+
+  DWARFContext &DwarfContext = *Context.DwarfContext;
+  startDebugObject(DwarfContext, Obj);
+
+  // In a first phase, just read in the debug info and load all clang modules.
+  for (const auto &CU : DwarfContext.compile_units()) {
+    auto CUDie = CU->getUnitDIE(false);
+    if (Options.Verbose) {
+      outs() << "Input compilation unit:";
+      DIDumpOptions DumpOpts;
+      DumpOpts.RecurseDepth = 0;
+      DumpOpts.Verbose = Options.Verbose;
+      CUDie.dump(outs(), 0, DumpOpts);
+    }
+
+    if (!registerModuleReference(CUDie, *CU, ModuleMap)) {
+      Units.push_back(llvm::make_unique<CompileUnit>(*CU, UnitID++,
+                                                     !Options.NoODR, ""));
+      maybeUpdateMaxDwarfVersion(CU->getVersion());
+    }
+  }
+
+  // Now build the DIE parent links that we will use during the next phase.
+  for (auto &CurrentUnit : Units)
+    analyzeContextInfo(CurrentUnit->getOrigUnit().getUnitDIE(), 0, *CurrentUnit,
+                       &ODRContexts.getRoot(), StringPool, ODRContexts);
+
+  // Then mark all the DIEs that need to be present in the linked
+  // output and collect some information about them. Note that this
+  // loop can not be merged with the previous one becaue cross-cu
+  // references require the ParentIdx to be setup for every CU in
+  // the object file before calling this.
+  for (auto &CurrentUnit : Units)
+    lookForDIEsToKeep(RelocMgr, CurrentUnit->getOrigUnit().getUnitDIE(), Obj,
+                      *CurrentUnit, 0);
+
+  // The calls to applyValidRelocs inside cloneDIE will walk the
+  // reloc array again (in the same way findValidRelocsInDebugInfo()
+  // did). We need to reset the NextValidReloc index to the beginning.
+  RelocMgr.resetValidRelocs();
+  if (RelocMgr.hasValidRelocs())
+    DIECloner(*this, RelocMgr, DIEAlloc, Units, Options)
+        .cloneAllCompileUnits(DwarfContext);
+  if (!Options.NoOutput && !Units.empty())
+    patchFrameInfoForObject(Obj, DwarfContext,
+                            Units[0]->getOrigUnit().getAddressByteSize());
+
+  // Clean-up before starting working on the next object.
+  endDebugObject();
+}
+
 bool DwarfLinker::link(const DebugMap &Map) {
 
   if (!createStreamer(Map.getTriple(), OutputFilename))
@@ -3470,72 +3598,45 @@ bool DwarfLinker::link(const DebugMap &Map) {
   UnitID = 0;
   DebugMap ModuleMap(Map.getTriple(), Map.getBinaryPath());
 
-  for (const auto &Obj : Map.objects()) {
-    CurrentDebugObject = Obj.get();
-
-    if (Options.Verbose)
-      outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename() << "\n";
-    auto ErrOrObj = loadObject(BinHolder, *Obj, Map);
-    if (!ErrOrObj)
-      continue;
-
-    // Look for relocations that correspond to debug map entries.
-    RelocationManager RelocMgr(*this);
-    if (!RelocMgr.findValidRelocsInDebugInfo(*ErrOrObj, *Obj)) {
+  // Loading an object and parsing its debug info doesn't depend on any other
+  // object, so with more than one thread this is done on a thread pool ahead
+  // of the link. Marking and cloning the DIEs depends on the ODR uniquing
+  // state left by the objects linked before, and on the output offsets, so
+  // objects are still linked one at a time in debug map order. This keeps the
+  // output identical to the one of a single threaded link. The verbose output
+  // of the loading phase can't be kept in order, so verbose links are always
+  // single threaded.
+  unsigned NumThreads = Options.Verbose ? 1 : Options.Threads;
+  if (NumThreads <= 1) {
+    for (const auto &Obj : Map.objects()) {
       if (Options.Verbose)
-        outs() << "No valid relocations found. Skipping.\n";
-      continue;
+        outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename() << "\n";
+      LinkContext Context(*this, *Obj);
+      loadDebugObject(Context, Map);
+      linkDebugObject(Context, ModuleMap);
     }
-
-    // Setup access to the debug info.
-    auto DwarfContext = DWARFContext::create(*ErrOrObj);
-    startDebugObject(*DwarfContext, *Obj);
-
-    // In a first phase, just read in the debug info and load all clang modules.
-    for (const auto &CU : DwarfContext->compile_units()) {
-      auto CUDie = CU->getUnitDIE(false);
-      if (Options.Verbose) {
-        outs() << "Input compilation unit:";
-        DIDumpOptions DumpOpts;
-        DumpOpts.RecurseDepth = 0;
-        DumpOpts.Verbose = Options.Verbose;
-        CUDie.dump(outs(), 0, DumpOpts);
-      }
-
-      if (!registerModuleReference(CUDie, *CU, ModuleMap)) {
-        Units.push_back(llvm::make_unique<CompileUnit>(*CU, UnitID++,
-                                                       !Options.NoODR, ""));
-        maybeUpdateMaxDwarfVersion(CU->getVersion());
+  } else {
+    // Bound the number of objects loaded ahead of the link to keep the
+    // memory usage in check.
+    const size_t MaxLoadedObjects = 2 * NumThreads;
+    ThreadPool LoadPool(NumThreads);
+    std::deque<std::pair<std::shared_future<void>,
+                         std::unique_ptr<LinkContext>>> LoadedObjects;
+    auto NextObj = Map.objects().begin(), EndObj = Map.objects().end();
+    while (NextObj != EndObj || !LoadedObjects.empty()) {
+      for (; NextObj != EndObj && LoadedObjects.size() < MaxLoadedObjects;
+           ++NextObj) {
+        auto Context = llvm::make_unique<LinkContext>(*this, **NextObj);
+        LinkContext *ContextPtr = Context.get();
+        LoadedObjects.emplace_back(
+            LoadPool.async(
+                [this, ContextPtr, &Map] { loadDebugObject(*ContextPtr, Map); }),
+            std::move(Context));
       }
+      LoadedObjects.front().first.wait();
+      linkDebugObject(*LoadedObjects.front().second, ModuleMap);
+      LoadedObjects.pop_front();
     }
-
-    // Now build the DIE parent links that we will use during the next phase.
-    for (auto &CurrentUnit : Units)
-      analyzeContextInfo(CurrentUnit->getOrigUnit().getUnitDIE(), 0, *CurrentUnit,
-                         &ODRContexts.getRoot(), StringPool, ODRContexts);
-
-    // Then mark all the DIEs that need to be present in the linked
-    // output and collect some information about them. Note that this
-    // loop can not be merged with the previous one becaue cross-cu
-    // references require the ParentIdx to be setup for every CU in
-    // the object file before calling this.
-    for (auto &CurrentUnit : Units)
-      lookForDIEsToKeep(RelocMgr, CurrentUnit->getOrigUnit().getUnitDIE(), *Obj,
-                        *CurrentUnit, 0);
-
-    // The calls to applyValidRelocs inside cloneDIE will walk the
-    // reloc array again (in the same way findValidRelocsInDebugInfo()
-    // did). We need to reset the NextValidReloc index to the beginning.
-    RelocMgr.resetValidRelocs();
-    if (RelocMgr.hasValidRelocs())
-      DIECloner(*this, RelocMgr, DIEAlloc, Units, Options)
-          .cloneAllCompileUnits(*DwarfContext);
-    if (!Options.NoOutput && !Units.empty())
-      patchFrameInfoForObject(*Obj, *DwarfContext,
-                              Units[0]->getOrigUnit().getAddressByteSize());
-
-    // Clean-up before starting working on the next object.
-    endDebugObject();
   }
 
   // Emit everything that's global.
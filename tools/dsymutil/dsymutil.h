@@ -29,6 +29,7 @@ struct LinkOptions {
   bool NoOutput; ///< Skip emitting output
   bool NoODR;    ///< Do not unique types according to ODR
   std::string PrependPath; ///< -oso-prepend-path
+  unsigned Threads = 1;    ///< Number of threads loading object files
 
   LinkOptions() : Verbose(false), NoOutput(false) {}
 };
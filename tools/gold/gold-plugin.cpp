@@ -126,6 +126,14 @@ namespace options {
   static unsigned Parallelism = 0;
   // Default regular LTO codegen parallelism (number of partitions).
   static unsigned ParallelCodeGenParallelismLevel = 1;
+  // Whether to also run the function-level regular LTO optimizations on the
+  // codegen partitions.
+  static bool ParallelOpt = false;
+  // Whether to balance the codegen partitions by estimated code size.
+  static bool BalancePartitions = false;
+  // Number of threads used to read module summaries in the background, or 0
+  // to read them when each file is claimed.
+  static unsigned InputThreads = 0;
 #ifdef NDEBUG
   static bool DisableVerify = true;
 #else
@@ -177,6 +185,10 @@ namespace options {
   static std::string cache_dir;
   // Optional pruning policy for ThinLTO caches.
   static std::string cache_policy;
+  // Store ThinLTO cache entries compressed and deduplicated by contents.
+  static bool cache_compress = false;
+  // Also cache the results of the ThinLTO thin link in the cache directory.
+  static bool cache_thin_link = false;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -227,6 +239,10 @@ namespace options {
       cache_dir = opt.substr(strlen("cache-dir="));
     } else if (opt.startswith("cache-policy=")) {
       cache_policy = opt.substr(strlen("cache-policy="));
+    } else if (opt == "cache-compress") {
+      cache_compress = true;
+    } else if (opt == "cache-thin-link") {
+      cache_thin_link = true;
     } else if (opt.size() == 2 && opt[0] == 'O') {
       if (opt[1] < '0' || opt[1] > '3')
         message(LDPL_FATAL, "Optimization level must be between 0 and 3");
@@ -238,6 +254,14 @@ namespace options {
       if (opt.substr(strlen("lto-partitions="))
               .getAsInteger(10, ParallelCodeGenParallelismLevel))
         message(LDPL_FATAL, "Invalid codegen partition level: %s", opt_ + 5);
+    } else if (opt == "parallel-opt") {
+      ParallelOpt = true;
+    } else if (opt == "balance-partitions") {
+      BalancePartitions = true;
+    } else if (opt.startswith("input-threads=")) {
+      if (opt.substr(strlen("input-threads=")).getAsInteger(10, InputThreads))
+        message(LDPL_FATAL, "Invalid input threads: %s",
+                opt_ + strlen("input-threads="));
     } else if (opt == "disable-verify") {
       DisableVerify = true;
     } else if (opt.startswith("sample-profile=")) {
@@ -767,6 +791,11 @@ static std::unique_ptr<LTO> createLTO() {
   Conf.CGOptLevel = getCGOptLevel();
   Conf.DisableVerify = options::DisableVerify;
   Conf.OptLevel = options::OptLevel;
+  Conf.ParallelOpt = options::ParallelOpt;
+  Conf.BalanceCodeGenPartitions = options::BalancePartitions;
+  Conf.InputThreads = options::InputThreads;
+  if (options::cache_thin_link)
+    Conf.ThinLinkCacheDir = options::cache_dir;
   if (options::Parallelism)
     Backend = createInProcessThinBackend(options::Parallelism);
   if (options::thinlto_index_only) {
@@ -915,14 +944,20 @@ static ld_plugin_status allSymbolsReadHook() {
 
   auto AddBuffer = [&](size_t Task, std::unique_ptr<MemoryBuffer> MB,
                        StringRef Path) {
-    // Note that this requires that the memory buffers provided to AddBuffer are
-    // backed by a file.
+    // The compressed cache provides buffers that are not backed by a file, so
+    // write them out.
+    if (Path.empty()) {
+      *AddStream(Task)->OS << MB->getBuffer();
+      return;
+    }
     Filenames[Task] = Path;
   };
 
   NativeObjectCache Cache;
   if (!options::cache_dir.empty())
-    Cache = check(localCache(options::cache_dir, AddBuffer));
+    Cache = check(options::cache_compress
+                      ? compressedLocalCache(options::cache_dir, AddBuffer)
+                      : localCache(options::cache_dir, AddBuffer));
 
   check(Lto->run(AddStream, Cache));
 
@@ -979,6 +1014,8 @@ static ld_plugin_status cleanup_hook(void) {
   // Prune cache
   if (!options::cache_policy.empty()) {
     CachePruningPolicy policy = check(parseCachePruningPolicy(options::cache_policy));
+    if (options::cache_compress)
+      setCompressedCachePruningCallbacks(policy);
     pruneCache(options::cache_dir, policy);
   }
 
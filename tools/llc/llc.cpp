@@ -15,6 +15,7 @@
 
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/CommandFlags.h"
@@ -24,6 +25,7 @@
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
@@ -140,9 +142,18 @@ static cl::opt<unsigned> PassRemarksHotnessThreshold(
 
 static cl::opt<std::string>
     RemarksFilename("pass-remarks-output",
-                    cl::desc("YAML output filename for pass remarks"),
+                    cl::desc("Output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+enum RemarksFormatKind { RF_YAML, RF_Binary };
+
+static cl::opt<RemarksFormatKind> RemarksFormat(
+    "pass-remarks-format",
+    cl::desc("The format of the pass remarks output file"), cl::init(RF_YAML),
+    cl::values(clEnumValN(RF_YAML, "yaml", "YAML optimization records"),
+               clEnumValN(RF_Binary, "binary",
+                          "Binary remarks, see llvm-remark-convert")));
+
 namespace {
 static ManagedStatic<std::vector<std::string>> RunPassNames;
 
@@ -330,9 +341,19 @@ int main(int argc, char **argv) {
       errs() << EC.message() << '\n';
       return 1;
     }
-    Context.setDiagnosticsOutputFile(
-        llvm::make_unique<yaml::Output>(YamlFile->os()));
+    if (RemarksFormat == RF_Binary)
+      Context.setDiagnosticsBinaryOutput(
+          llvm::make_unique<remarks::Writer>(YamlFile->os()));
+    else
+      Context.setDiagnosticsOutputFile(
+          llvm::make_unique<yaml::Output>(YamlFile->os()));
   }
+  // Binary remarks are written out on every way out of main, while the remarks
+  // file is still open.
+  auto FinalizeRemarks = make_scope_exit([&]() {
+    if (remarks::Writer *W = Context.getDiagnosticsBinaryOutput())
+      W->finalize();
+  });
 
   if (InputLanguage != "" && InputLanguage != "ir" &&
       InputLanguage != "mir") {
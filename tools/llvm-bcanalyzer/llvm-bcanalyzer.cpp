@@ -42,6 +42,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <map>
 #include <system_error>
 using namespace llvm;
@@ -75,6 +76,11 @@ static cl::opt<std::string> CheckHash(
     "check-hash",
     cl::desc("Check module hash using the argument as a string table"));
 
+static cl::opt<unsigned>
+    Benchmark("benchmark", cl::value_desc("N"),
+              cl::desc("Decode all the records of the file N times and report "
+                       "the decoding throughput instead of analyzing it"));
+
 namespace {
 
 /// CurStreamTypeType - A type for CurStreamType
@@ -811,6 +817,79 @@ static bool openBitcodeFile(StringRef Path,
   return false;
 }
 
+/// decodeBlock - Read every record of the block with the specified ID, and of
+/// its nested blocks, without analyzing them. This is the work that is timed
+/// by -benchmark.
+static bool decodeBlock(BitstreamCursor &Stream, BitstreamBlockInfo &BlockInfo,
+                        unsigned BlockID, uint64_t &NumRecords) {
+  if (BlockID == bitc::BLOCKINFO_BLOCK_ID) {
+    Optional<BitstreamBlockInfo> NewBlockInfo = Stream.ReadBlockInfoBlock();
+    if (!NewBlockInfo)
+      return ReportError("Malformed BlockInfoBlock");
+    BlockInfo = std::move(*NewBlockInfo);
+    return false;
+  }
+
+  if (Stream.EnterSubBlock(BlockID))
+    return ReportError("Malformed block record");
+
+  SmallVector<uint64_t, 64> Record;
+  StringRef Blob;
+  while (1) {
+    BitstreamEntry Entry = Stream.advance();
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return ReportError("malformed bitcode file");
+    case BitstreamEntry::EndBlock:
+      return false;
+    case BitstreamEntry::SubBlock:
+      if (decodeBlock(Stream, BlockInfo, Entry.ID, NumRecords))
+        return true;
+      break;
+    case BitstreamEntry::Record:
+      Record.clear();
+      Stream.readRecord(Entry.ID, Record, &Blob);
+      ++NumRecords;
+      break;
+    }
+  }
+}
+
+/// BenchmarkBitcode - Decode the stream Benchmark times and print the decoding
+/// throughput.
+static int BenchmarkBitcode(BitstreamCursor &Stream,
+                            BitstreamBlockInfo &BlockInfo) {
+  uint64_t StartBit = Stream.GetCurrentBitNo();
+  uint64_t NumRecords = 0;
+  auto Start = std::chrono::steady_clock::now();
+  for (unsigned I = 0; I != Benchmark; ++I) {
+    Stream.JumpToBit(StartBit);
+    NumRecords = 0;
+    while (!Stream.AtEndOfStream()) {
+      if (Stream.ReadCode() != bitc::ENTER_SUBBLOCK)
+        return ReportError("Invalid record at top-level");
+      if (decodeBlock(Stream, BlockInfo, Stream.ReadSubBlockID(), NumRecords))
+        return true;
+    }
+  }
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+
+  double MBytes =
+      (double)Stream.getBitcodeBytes().size() * Benchmark / (1024 * 1024);
+  outs() << "Benchmark of " << InputFilename << ":\n";
+  outs() << "         Iterations: " << Benchmark << "\n";
+  outs() << "   Records per pass: " << NumRecords << "\n";
+  outs() << "         Total time: " << format("%.6fs", Elapsed.count())
+         << "\n";
+  outs() << "         Throughput: ";
+  if (Elapsed.count() > 0)
+    outs() << format("%.2f MB/s", MBytes / Elapsed.count()) << "\n";
+  else
+    outs() << "n/a\n";
+  return 0;
+}
+
 /// AnalyzeBitcode - Analyze the bitcode file specified by InputFilename.
 static int AnalyzeBitcode() {
   std::unique_ptr<MemoryBuffer> StreamBuffer;
@@ -850,6 +929,9 @@ static int AnalyzeBitcode() {
     }
   }
 
+  if (Benchmark)
+    return BenchmarkBitcode(Stream, BlockInfo);
+
   unsigned NumTopBlocks = 0;
 
   // Parse the top-level structure.  We only allow blocks at the top-level.
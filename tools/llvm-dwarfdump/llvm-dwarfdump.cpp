@@ -185,6 +185,14 @@ static opt<bool> Verify("verify", desc("Verify the DWARF debug info"),
                         cat(DwarfDumpCategory));
 static opt<bool> Quiet("quiet", desc("Use with -verify to not emit to STDOUT."),
                        cat(DwarfDumpCategory));
+static opt<unsigned> NumThreads(
+    "num-threads",
+    desc("Use with -verify to verify up to N units concurrently. The output\n"
+         "doesn't depend on the number of threads. Defaults to the number of\n"
+         "cores."),
+    cat(DwarfDumpCategory), init(0), value_desc("N"));
+static alias NumThreadsAlias("j", desc("Alias for -num-threads"),
+                             aliasopt(NumThreads));
 static opt<bool> DumpUUID("uuid", desc("Show the UUID for each architecture"),
                           cat(DwarfDumpCategory));
 static alias DumpUUIDAlias("u", desc("Alias for -uuid"), aliasopt(DumpUUID));
@@ -321,7 +329,7 @@ static bool verifyObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
   raw_ostream &stream = Quiet ? nulls() : OS;
   stream << "Verifying " << Filename.str() << ":\tfile format "
   << Obj.getFileFormatName() << "\n";
-  bool Result = DICtx.verify(stream, getDumpOpts());
+  bool Result = DICtx.verify(stream, getDumpOpts(), NumThreads);
   if (Result)
     stream << "No errors.\n";
   else
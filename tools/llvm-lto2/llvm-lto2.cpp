@@ -24,6 +24,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
 
 using namespace llvm;
@@ -49,6 +50,17 @@ static cl::opt<std::string> OutputFilename("o", cl::Required,
 static cl::opt<std::string> CacheDir("cache-dir", cl::desc("Cache Directory"),
                                      cl::value_desc("directory"));
 
+static cl::opt<std::string>
+    ThinLinkCacheDir("thinlink-cache-dir",
+                     cl::desc("Directory to cache the results of the thin "
+                              "link in"),
+                     cl::value_desc("directory"));
+
+static cl::opt<bool>
+    CompressedCache("compressed-cache",
+                    cl::desc("Store cache entries compressed and deduplicated "
+                             "by contents"));
+
 static cl::opt<std::string> OptPipeline("opt-pipeline",
                                         cl::desc("Optimizer Pipeline"),
                                         cl::value_desc("pipeline"));
@@ -68,6 +80,26 @@ static cl::opt<bool>
 static cl::opt<int> Threads("thinlto-threads",
                             cl::init(llvm::heavyweight_hardware_concurrency()));
 
+static cl::opt<unsigned>
+    Partitions("lto-partitions", cl::init(1),
+               cl::desc("Number of code generation partitions for regular "
+                        "LTO"));
+
+static cl::opt<unsigned> InputThreads(
+    "input-threads", cl::init(0),
+    cl::desc("Number of threads used to read the input files and their "
+             "summaries (0 reads them on the main thread)"));
+
+static cl::opt<bool> ParallelOpt(
+    "lto-parallel-opt", cl::init(false),
+    cl::desc("Run the function-level regular LTO optimizations on the code "
+             "generation partitions in parallel"));
+
+static cl::opt<bool> BalancePartitions(
+    "lto-balance-partitions", cl::init(false),
+    cl::desc("Balance the regular LTO code generation partitions by "
+             "estimated code size"));
+
 static cl::list<std::string> SymbolResolutions(
     "r",
     cl::desc("Specify a symbol resolution: filename,symbolname,resolution\n"
@@ -113,6 +145,10 @@ static cl::opt<bool>
     DebugPassManager("debug-pass-manager", cl::init(false), cl::Hidden,
                      cl::desc("Print pass management debugging information"));
 
+static cl::opt<bool> TimeThinLTOBackends(
+    "time-thinlto-backends", cl::init(false),
+    cl::desc("Report the time taken by each ThinLTO backend"));
+
 static void check(Error E, std::string Msg) {
   if (!E)
     return;
@@ -200,6 +236,11 @@ static int run(int argc, char **argv) {
   Conf.CodeModel = getCodeModel();
 
   Conf.DebugPassManager = DebugPassManager;
+  Conf.TimeThinLTOBackends = TimeThinLTOBackends;
+  Conf.ParallelOpt = ParallelOpt;
+  Conf.BalanceCodeGenPartitions = BalancePartitions;
+  Conf.ThinLinkCacheDir = ThinLinkCacheDir;
+  Conf.InputThreads = InputThreads;
 
   if (SaveTemps)
     check(Conf.addSaveTemps(OutputFilename + "."),
@@ -246,13 +287,31 @@ static int run(int argc, char **argv) {
     Backend = createWriteIndexesThinBackend("", "", true, "");
   else
     Backend = createInProcessThinBackend(Threads);
-  LTO Lto(std::move(Conf), std::move(Backend));
+  LTO Lto(std::move(Conf), std::move(Backend), Partitions);
+
+  // Read the input files up front, so that their symbol tables can be built
+  // concurrently. They are still resolved and added in command line order.
+  for (const std::string &F : InputFilenames)
+    MBs.push_back(check(MemoryBuffer::getFile(F), F));
+  std::vector<Optional<Expected<std::unique_ptr<InputFile>>>> Inputs(
+      MBs.size());
+  {
+    ThreadPool Pool(std::max(InputThreads.getValue(), 1u));
+    for (size_t I = 0; I != MBs.size(); ++I) {
+      auto CreateInput = [&, I]() {
+        Inputs[I] = InputFile::create(MBs[I]->getMemBufferRef());
+      };
+      if (InputThreads)
+        Pool.async(CreateInput);
+      else
+        CreateInput();
+    }
+  }
 
   bool HasErrors = false;
-  for (std::string F : InputFilenames) {
-    std::unique_ptr<MemoryBuffer> MB = check(MemoryBuffer::getFile(F), F);
-    std::unique_ptr<InputFile> Input =
-        check(InputFile::create(MB->getMemBufferRef()), F);
+  for (size_t I = 0; I != MBs.size(); ++I) {
+    const std::string &F = InputFilenames[I];
+    std::unique_ptr<InputFile> Input = check(std::move(*Inputs[I]), F);
 
     std::vector<SymbolResolution> Res;
     for (const InputFile::Symbol &Sym : Input->symbols()) {
@@ -272,7 +331,6 @@ static int run(int argc, char **argv) {
     if (HasErrors)
       continue;
 
-    MBs.push_back(std::move(MB));
     check(Lto.add(std::move(Input), Res), F);
   }
 
@@ -303,7 +361,9 @@ static int run(int argc, char **argv) {
 
   NativeObjectCache Cache;
   if (!CacheDir.empty())
-    Cache = check(localCache(CacheDir, AddBuffer), "failed to create cache");
+    Cache = check(CompressedCache ? compressedLocalCache(CacheDir, AddBuffer)
+                                  : localCache(CacheDir, AddBuffer),
+                  "failed to create cache");
 
   check(Lto.run(AddStream, Cache), "LTO::run failed");
   return 0;
@@ -37,6 +37,7 @@
 #include "llvm/DebugInfo/CodeView/SymbolDumper.h"
 #include "llvm/DebugInfo/CodeView/SymbolVisitorCallbackPipeline.h"
 #include "llvm/DebugInfo/CodeView/SymbolVisitorCallbacks.h"
+#include "llvm/DebugInfo/CodeView/TypeCollection.h"
 #include "llvm/DebugInfo/CodeView/TypeDumpVisitor.h"
 #include "llvm/DebugInfo/CodeView/TypeIndexDiscovery.h"
 #include "llvm/DebugInfo/CodeView/TypeVisitorCallbackPipeline.h"
@@ -59,8 +60,12 @@
 #include "llvm/Support/BinaryStreamReader.h"
 #include "llvm/Support/FormatAdapters.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 
 #include <cctype>
+#include <deque>
+#include <mutex>
 #include <unordered_map>
 
 using namespace llvm;
@@ -349,29 +354,6 @@ Error DumpOutputStyle::dumpStreamSummary() {
   return Error::success();
 }
 
-static Expected<ModuleDebugStreamRef> getModuleDebugStream(PDBFile &File,
-                                                           uint32_t Index) {
-  ExitOnError Err("Unexpected error: ");
-
-  auto &Dbi = Err(File.getPDBDbiStream());
-  const auto &Modules = Dbi.modules();
-  auto Modi = Modules.getModuleDescriptor(Index);
-
-  uint16_t ModiStream = Modi.getModuleStreamIndex();
-  if (ModiStream == kInvalidStreamIndex)
-    return make_error<RawError>(raw_error_code::no_stream,
-                                "Module stream not present");
-
-  auto ModStreamData = File.createIndexedStream(ModiStream);
-
-  ModuleDebugStreamRef ModS(Modi, std::move(ModStreamData));
-  if (auto EC = ModS.reload())
-    return make_error<RawError>(raw_error_code::corrupt_file,
-                                "Invalid module stream");
-
-  return std::move(ModS);
-}
-
 template <typename CallbackT>
 static void
 iterateOneModule(InputFile &File, const Optional<PrintScope> &HeaderScope,
@@ -414,6 +396,162 @@ static void iterateSymbolGroups(InputFile &Input,
   }
 }
 
+namespace {
+/// Forwards to a type collection while holding a lock.  Type collections
+/// read records and compute names on demand, so they can't be used by several
+/// threads at once without one.
+class LockedTypeCollection : public TypeCollection {
+public:
+  LockedTypeCollection(TypeCollection &Types, std::mutex &Lock)
+      : Types(Types), Lock(Lock) {}
+
+  Optional<TypeIndex> getFirst() override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.getFirst();
+  }
+  Optional<TypeIndex> getNext(TypeIndex Prev) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.getNext(Prev);
+  }
+  CVType getType(TypeIndex Index) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.getType(Index);
+  }
+  StringRef getTypeName(TypeIndex Index) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.getTypeName(Index);
+  }
+  bool contains(TypeIndex Index) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.contains(Index);
+  }
+  uint32_t size() override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.size();
+  }
+  uint32_t capacity() override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Types.capacity();
+  }
+
+private:
+  TypeCollection &Types;
+  std::mutex &Lock;
+};
+
+/// A PDB module being dumped on a worker thread.  The module's streams read
+/// into its own allocator, and its output is buffered until it is printed.
+struct ModuleDumpTask {
+  ModuleDumpTask(InputFile &File, uint32_t Modi)
+      : Modi(Modi), SG(&File, Modi, Allocator) {}
+
+  uint32_t Modi;
+  BumpPtrAllocator Allocator;
+  SymbolGroup SG;
+  std::string Output;
+  std::shared_future<void> Done;
+};
+} // namespace
+
+/// Prints text that was formatted by a printer starting at indentation level
+/// zero as if it had been formatted by \p P at its current indentation level.
+/// Everything the printers indent is indented relative to the current level,
+/// so this only needs to indent each new line.
+static void printIndented(LinePrinter &P, StringRef Text) {
+  raw_ostream &OS = P.getStream();
+  size_t Pos;
+  while ((Pos = Text.find('\n')) != StringRef::npos) {
+    OS << Text.take_front(Pos + 1);
+    OS.indent(P.getIndentLevel());
+    Text = Text.drop_front(Pos + 1);
+  }
+  OS << Text;
+}
+
+/// Like iterateSymbolGroups, but the callback is given the printer to write
+/// to, and when dumping more than one module of a PDB, the callback runs for
+/// several modules at once on a thread pool.  Each module is formatted into
+/// its own buffer, and the buffers are printed in module order, so the output
+/// is the same as when dumping the modules one at a time.  The streams of the
+/// PDB file that all modules share must only be read while holding
+/// \p InputLock.
+template <typename CallbackT>
+static void iterateSymbolGroupsInParallel(InputFile &Input,
+                                          const PrintScope &HeaderScope,
+                                          std::mutex &InputLock,
+                                          CallbackT Callback) {
+  LinePrinter &P = HeaderScope.P;
+  unsigned Threads = opts::dump::NumThreads;
+  if (Threads == 0)
+    Threads = heavyweight_hardware_concurrency();
+  if (Threads <= 1 || !Input.isPdb() ||
+      opts::dump::DumpModi.getNumOccurrences() > 0) {
+    iterateSymbolGroups(Input, HeaderScope,
+                        [&](uint32_t Modi, const SymbolGroup &SG) {
+                          Callback(P, Modi, SG);
+                        });
+    return;
+  }
+
+  AutoIndent Indent(HeaderScope);
+
+  auto &Dbi = cantFail(Input.pdb().getPDBDbiStream());
+  uint32_t Count = Dbi.modules().getModuleCount();
+
+  // Keep a bounded number of modules in flight, so that the output of a large
+  // PDB isn't all held in memory before it is printed.
+  ThreadPool Pool(Threads);
+  std::deque<std::unique_ptr<ModuleDumpTask>> Pending;
+  auto PrintFirstPending = [&] {
+    ModuleDumpTask &Task = *Pending.front();
+    Task.Done.wait();
+    iterateOneModule(Input, withLabelWidth(HeaderScope, NumDigits(Task.Modi)),
+                     Task.SG, Task.Modi,
+                     [&](uint32_t, const SymbolGroup &) {
+                       printIndented(P, Task.Output);
+                     });
+    Pending.pop_front();
+  };
+
+  for (uint32_t I = 0; I < Count; ++I) {
+    std::unique_ptr<ModuleDumpTask> Task;
+    {
+      // Loading a module reads its descriptor from the DBI stream.
+      std::lock_guard<std::mutex> Guard(InputLock);
+      Task = llvm::make_unique<ModuleDumpTask>(Input, I);
+    }
+    if (!shouldDumpSymbolGroup(I, Task->SG))
+      continue;
+
+    ModuleDumpTask *T = Task.get();
+    T->Done = Pool.async([T, &Callback] {
+      raw_string_ostream OS(T->Output);
+      LinePrinter TaskP(2, false, OS);
+      Callback(TaskP, T->Modi, T->SG);
+    });
+    Pending.push_back(std::move(Task));
+    if (Pending.size() > 4 * Threads)
+      PrintFirstPending();
+  }
+  while (!Pending.empty())
+    PrintFirstPending();
+}
+
+template <typename SubsectionT, typename CallbackT>
+static void iterateSubsections(const SymbolGroup &SG, CallbackT Callback) {
+  for (const auto &SS : SG.getDebugSubsections()) {
+    SubsectionT Subsection;
+
+    if (SS.kind() != Subsection.kind())
+      continue;
+
+    BinaryStreamReader Reader(SS.getRecordData());
+    if (auto EC = Subsection.initialize(Reader))
+      continue;
+    Callback(Subsection);
+  }
+}
+
 template <typename SubsectionT>
 static void iterateModuleSubsections(
     InputFile &File, const Optional<PrintScope> &HeaderScope,
@@ -422,17 +560,10 @@ static void iterateModuleSubsections(
 
   iterateSymbolGroups(File, HeaderScope,
                       [&](uint32_t Modi, const SymbolGroup &SG) {
-                        for (const auto &SS : SG.getDebugSubsections()) {
-                          SubsectionT Subsection;
-
-                          if (SS.kind() != Subsection.kind())
-                            continue;
-
-                          BinaryStreamReader Reader(SS.getRecordData());
-                          if (auto EC = Subsection.initialize(Reader))
-                            continue;
-                          Callback(Modi, SG, Subsection);
-                        }
+                        iterateSubsections<SubsectionT>(
+                            SG, [&](SubsectionT &Subsection) {
+                              Callback(Modi, SG, Subsection);
+                            });
                       });
 }
 
@@ -513,7 +644,7 @@ Error DumpOutputStyle::dumpSymbolStats() {
 
     if (SG.getFile().isPdb()) {
       AutoIndent Indent(P);
-      auto Modules = cantFail(File.pdb().getPDBDbiStream()).modules();
+      const auto &Modules = cantFail(File.pdb().getPDBDbiStream()).modules();
       uint32_t ModCount = Modules.getModuleCount();
       DbiModuleDescriptor Desc = Modules.getModuleDescriptor(Modi);
       uint32_t StreamIdx = Desc.getModuleStreamIndex();
@@ -744,34 +875,34 @@ static void typesetLinesAndColumns(LinePrinter &P, uint32_t Start,
 Error DumpOutputStyle::dumpLines() {
   printHeader(P, "Lines");
 
-  uint32_t LastModi = UINT32_MAX;
-  uint32_t LastNameIndex = UINT32_MAX;
-  iterateModuleSubsections<DebugLinesSubsectionRef>(
-      File, PrintScope{P, 4},
-      [this, &LastModi, &LastNameIndex](uint32_t Modi,
-                                        const SymbolGroup &Strings,
-                                        DebugLinesSubsectionRef &Lines) {
-        uint16_t Segment = Lines.header()->RelocSegment;
-        uint32_t Begin = Lines.header()->RelocOffset;
-        uint32_t End = Begin + Lines.header()->CodeSize;
-        for (const auto &Block : Lines) {
-          if (LastModi != Modi || LastNameIndex != Block.NameIndex) {
-            LastModi = Modi;
-            LastNameIndex = Block.NameIndex;
-            Strings.formatFromChecksumsOffset(P, Block.NameIndex);
-          }
-
-          AutoIndent Indent(P, 2);
-          P.formatLine("{0:X-4}:{1:X-8}-{2:X-8}, ", Segment, Begin, End);
-          uint32_t Count = Block.LineNumbers.size();
-          if (Lines.hasColumnInfo())
-            P.format("line/column/addr entries = {0}", Count);
-          else
-            P.format("line/addr entries = {0}", Count);
-
-          P.NewLine();
-          typesetLinesAndColumns(P, Begin, Block);
-        }
+  std::mutex InputLock;
+  iterateSymbolGroupsInParallel(
+      File, PrintScope{P, 4}, InputLock,
+      [](LinePrinter &P, uint32_t Modi, const SymbolGroup &Strings) {
+        Optional<uint32_t> LastNameIndex;
+        iterateSubsections<DebugLinesSubsectionRef>(
+            Strings, [&](DebugLinesSubsectionRef &Lines) {
+              uint16_t Segment = Lines.header()->RelocSegment;
+              uint32_t Begin = Lines.header()->RelocOffset;
+              uint32_t End = Begin + Lines.header()->CodeSize;
+              for (const auto &Block : Lines) {
+                if (LastNameIndex != uint32_t(Block.NameIndex)) {
+                  LastNameIndex = Block.NameIndex;
+                  Strings.formatFromChecksumsOffset(P, Block.NameIndex);
+                }
+
+                AutoIndent Indent(P, 2);
+                P.formatLine("{0:X-4}:{1:X-8}-{2:X-8}, ", Segment, Begin, End);
+                uint32_t Count = Block.LineNumbers.size();
+                if (Lines.hasColumnInfo())
+                  P.format("line/column/addr entries = {0}", Count);
+                else
+                  P.format("line/addr entries = {0}", Count);
+
+                P.NewLine();
+                typesetLinesAndColumns(P, Begin, Block);
+              }
+            });
       });
 
   return Error::success();
@@ -780,17 +911,22 @@ Error DumpOutputStyle::dumpLines() {
 Error DumpOutputStyle::dumpInlineeLines() {
   printHeader(P, "Inlinee Lines");
 
-  iterateModuleSubsections<DebugInlineeLinesSubsectionRef>(
-      File, PrintScope{P, 2},
-      [this](uint32_t Modi, const SymbolGroup &Strings,
-             DebugInlineeLinesSubsectionRef &Lines) {
-        P.formatLine("{0,+8} | {1,+5} | {2}", "Inlinee", "Line", "Source File");
-        for (const auto &Entry : Lines) {
-          P.formatLine("{0,+8} | {1,+5} | ", Entry.Header->Inlinee,
-                       fmtle(Entry.Header->SourceLineNum));
-          Strings.formatFromChecksumsOffset(P, Entry.Header->FileID, true);
-        }
-        P.NewLine();
+  std::mutex InputLock;
+  iterateSymbolGroupsInParallel(
+      File, PrintScope{P, 2}, InputLock,
+      [](LinePrinter &P, uint32_t Modi, const SymbolGroup &Strings) {
+        iterateSubsections<DebugInlineeLinesSubsectionRef>(
+            Strings, [&](DebugInlineeLinesSubsectionRef &Lines) {
+              P.formatLine("{0,+8} | {1,+5} | {2}", "Inlinee", "Line",
+                           "Source File");
+              for (const auto &Entry : Lines) {
+                P.formatLine("{0,+8} | {1,+5} | ", Entry.Header->Inlinee,
+                             fmtle(Entry.Header->SourceLineNum));
+                Strings.formatFromChecksumsOffset(P, Entry.Header->FileID,
+                                                  true);
+              }
+              P.NewLine();
+            });
       });
 
   return Error::success();
@@ -1099,19 +1235,20 @@ Error DumpOutputStyle::dumpModuleSymsForPdb() {
 
   ExitOnError Err("Unexpected error processing symbols: ");
 
-  auto &Ids = File.ids();
-  auto &Types = File.types();
+  std::mutex InputLock;
+  LockedTypeCollection Ids(File.ids(), InputLock);
+  LockedTypeCollection Types(File.types(), InputLock);
 
-  iterateSymbolGroups(
-      File, PrintScope{P, 2}, [&](uint32_t I, const SymbolGroup &Strings) {
-        auto ExpectedModS = getModuleDebugStream(File.pdb(), I);
-        if (!ExpectedModS) {
+  iterateSymbolGroupsInParallel(
+      File, PrintScope{P, 2}, InputLock,
+      [&](LinePrinter &P, uint32_t I, const SymbolGroup &Strings) {
+        if (!Strings.hasPdbModuleStream()) {
           P.formatLine("Error loading module stream {0}.  {1}", I,
-                       toString(ExpectedModS.takeError()));
+                       Strings.getPdbModuleStreamError());
           return;
         }
 
-        ModuleDebugStreamRef &ModS = *ExpectedModS;
+        const ModuleDebugStreamRef &ModS = Strings.getPdbModuleStream();
 
         SymbolVisitorCallbackPipeline Pipeline;
         SymbolDeserializer Deserializer(nullptr, CodeViewContainer::Pdb);
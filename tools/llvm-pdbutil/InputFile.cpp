@@ -16,6 +16,7 @@
 #include "llvm/DebugInfo/CodeView/CodeView.h"
 #include "llvm/DebugInfo/CodeView/LazyRandomTypeCollection.h"
 #include "llvm/DebugInfo/CodeView/StringsAndChecksums.h"
+#include "llvm/DebugInfo/MSF/MappedBlockStream.h"
 #include "llvm/DebugInfo/PDB/Native/DbiStream.h"
 #include "llvm/DebugInfo/PDB/Native/NativeSession.h"
 #include "llvm/DebugInfo/PDB/Native/PDBFile.h"
@@ -29,6 +30,7 @@
 
 using namespace llvm;
 using namespace llvm::codeview;
+using namespace llvm::msf;
 using namespace llvm::object;
 using namespace llvm::pdb;
 
@@ -36,7 +38,8 @@ InputFile::InputFile() {}
 InputFile::~InputFile() {}
 
 static Expected<ModuleDebugStreamRef>
-getModuleDebugStream(PDBFile &File, StringRef &ModuleName, uint32_t Index) {
+getModuleDebugStream(PDBFile &File, StringRef &ModuleName, uint32_t Index,
+                     BumpPtrAllocator &Allocator) {
   ExitOnError Err("Unexpected error: ");
 
   auto &Dbi = Err(File.getPDBDbiStream());
@@ -50,7 +53,8 @@ getModuleDebugStream(PDBFile &File, StringRef &ModuleName, uint32_t Index) {
     return make_error<RawError>(raw_error_code::no_stream,
                                 "Module stream not present");
 
-  auto ModStreamData = File.createIndexedStream(ModiStream);
+  auto ModStreamData = MappedBlockStream::createIndexedStream(
+      File.getMsfLayout(), File.getMsfBuffer(), ModiStream, Allocator);
 
   ModuleDebugStreamRef ModS(Modi, std::move(ModStreamData));
   if (auto EC = ModS.reload())
@@ -111,10 +115,6 @@ static std::string formatChecksumKind(FileChecksumKind Kind) {
   return formatUnknownEnum(Kind);
 }
 
-static const DebugStringTableSubsectionRef &extractStringTable(PDBFile &File) {
-  return cantFail(File.getStringTable()).getStringTable();
-}
-
 template <typename... Args>
 static void formatInternal(LinePrinter &Printer, bool Append, Args &&... args) {
   if (Append)
@@ -123,6 +123,13 @@ static void formatInternal(LinePrinter &Printer, bool Append, Args &&... args) {
     Printer.formatLine(std::forward<Args>(args)...);
 }
 
+SymbolGroup::SymbolGroup(InputFile *File, uint32_t GroupIndex,
+                         BumpPtrAllocator &Allocator)
+    : File(File), Allocator(&Allocator) {
+  assert(File && File->isPdb());
+  initializeForPdb(GroupIndex);
+}
+
 SymbolGroup::SymbolGroup(InputFile *File, uint32_t GroupIndex) : File(File) {
   if (!File)
     return;
@@ -164,15 +171,20 @@ void SymbolGroup::initializeForPdb(uint32_t Modi) {
   // PDB always uses the same string table, but each module has its own
   // checksums.  So we only set the strings if they're not already set.
   if (!SC.hasStrings())
-    SC.setStrings(extractStringTable(File->pdb()));
+    SC.setStrings(File->pdbStrings());
 
   SC.resetChecksums();
-  auto MDS = getModuleDebugStream(File->pdb(), Name, Modi);
+  PDBFile &Pdb = File->pdb();
+  auto MDS = getModuleDebugStream(Pdb, Name, Modi,
+                                  Allocator ? *Allocator : Pdb.getAllocator());
   if (!MDS) {
-    consumeError(MDS.takeError());
+    DebugStream.reset();
+    DebugStreamError = toString(MDS.takeError());
+    Subsections = DebugSubsectionArray();
     return;
   }
 
+  DebugStreamError.clear();
   DebugStream = std::make_shared<ModuleDebugStreamRef>(std::move(*MDS));
   Subsections = DebugStream->getSubsectionsArray();
   SC.initialize(Subsections);
@@ -380,6 +392,19 @@ codeview::LazyRandomTypeCollection &InputFile::ids() {
   return getOrCreateTypeCollection(kIds);
 }
 
+const DebugStringTableSubsectionRef &InputFile::pdbStrings() {
+  if (PdbStrings.valid())
+    return PdbStrings;
+
+  const DebugStringTableSubsectionRef &Strings =
+      cantFail(pdb().getStringTable()).getStringTable();
+  BinaryStreamReader Reader(Strings.getBuffer());
+  ArrayRef<uint8_t> Bytes;
+  cantFail(Reader.readBytes(Bytes, Reader.bytesRemaining()));
+  cantFail(PdbStrings.initialize(BinaryStreamRef(Bytes, support::little)));
+  return PdbStrings;
+}
+
 iterator_range<SymbolGroupIterator> InputFile::symbol_groups() {
   return make_range<SymbolGroupIterator>(symbol_groups_begin(),
                                          symbol_groups_end());
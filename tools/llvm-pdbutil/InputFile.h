@@ -19,6 +19,7 @@
 #include "llvm/DebugInfo/PDB/Native/ModuleDebugStream.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Error.h"
 
 namespace llvm {
@@ -50,6 +51,8 @@ class InputFile {
   TypeCollectionPtr Types;
   TypeCollectionPtr Ids;
 
+  codeview::DebugStringTableSubsectionRef PdbStrings;
+
   enum TypeCollectionKind { kTypes, kIds };
   codeview::LazyRandomTypeCollection &
   getOrCreateTypeCollection(TypeCollectionKind Kind);
@@ -71,6 +74,11 @@ public:
   codeview::LazyRandomTypeCollection &types();
   codeview::LazyRandomTypeCollection &ids();
 
+  /// The PDB string table, read into contiguous memory so that looking up a
+  /// string doesn't go through the MSF stream and is safe to do from several
+  /// threads once the table has been loaded.
+  const codeview::DebugStringTableSubsectionRef &pdbStrings();
+
   iterator_range<SymbolGroupIterator> symbol_groups();
   SymbolGroupIterator symbol_groups_begin();
   SymbolGroupIterator symbol_groups_end();
@@ -85,6 +93,12 @@ class SymbolGroup {
 public:
   explicit SymbolGroup(InputFile *File, uint32_t GroupIndex = 0);
 
+  /// Creates the symbol group of a PDB module whose streams read into
+  /// \p Allocator instead of the allocator of the PDB file, so that the
+  /// module can be dumped on a different thread than other modules.
+  SymbolGroup(InputFile *File, uint32_t GroupIndex,
+              BumpPtrAllocator &Allocator);
+
   Expected<StringRef> getNameFromStringTable(uint32_t Offset) const;
 
   void formatFromFileName(LinePrinter &Printer, StringRef File,
@@ -98,7 +112,10 @@ public:
   codeview::DebugSubsectionArray getDebugSubsections() const {
     return Subsections;
   }
+  bool hasPdbModuleStream() const { return DebugStream != nullptr; }
   const ModuleDebugStreamRef &getPdbModuleStream() const;
+  /// Why the stream of this PDB module couldn't be loaded, if it couldn't.
+  StringRef getPdbModuleStreamError() const { return DebugStreamError; }
 
   const InputFile &getFile() const { return *File; }
   InputFile &getFile() { return *File; }
@@ -110,9 +127,11 @@ private:
 
   void rebuildChecksumMap();
   InputFile *File = nullptr;
+  BumpPtrAllocator *Allocator = nullptr;
   StringRef Name;
   codeview::DebugSubsectionArray Subsections;
   std::shared_ptr<ModuleDebugStreamRef> DebugStream;
+  std::string DebugStreamError;
   codeview::StringsAndChecksumsRef SC;
   StringMap<codeview::FileChecksumEntry> ChecksumsByFile;
 };
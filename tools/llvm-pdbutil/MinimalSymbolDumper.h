@@ -14,7 +14,7 @@
 
 namespace llvm {
 namespace codeview {
-class LazyRandomTypeCollection;
+class TypeCollection;
 }
 
 namespace pdb {
@@ -23,8 +23,8 @@ class LinePrinter;
 class MinimalSymbolDumper : public codeview::SymbolVisitorCallbacks {
 public:
   MinimalSymbolDumper(LinePrinter &P, bool RecordBytes,
-                      codeview::LazyRandomTypeCollection &Ids,
-                      codeview::LazyRandomTypeCollection &Types)
+                      codeview::TypeCollection &Ids,
+                      codeview::TypeCollection &Types)
       : P(P), RecordBytes(RecordBytes), Ids(Ids), Types(Types) {}
 
   Error visitSymbolBegin(codeview::CVSymbol &Record) override;
@@ -45,8 +45,8 @@ private:
 
   LinePrinter &P;
   bool RecordBytes;
-  codeview::LazyRandomTypeCollection &Ids;
-  codeview::LazyRandomTypeCollection &Types;
+  codeview::TypeCollection &Ids;
+  codeview::TypeCollection &Types;
 };
 } // namespace pdb
 } // namespace llvm
@@ -526,6 +526,14 @@ cl::opt<bool> JustMyCode("jmc", cl::Optional,
                          cl::desc("For all options that iterate over modules, "
                                   "ignore modules from system libraries"),
                          cl::cat(FileOptions), cl::sub(DumpSubcommand));
+cl::opt<unsigned>
+    NumThreads("num-threads",
+               cl::desc("Number of threads to dump the symbols and lines of "
+                        "modules with (default: one per core)"),
+               cl::init(0), cl::cat(FileOptions), cl::sub(DumpSubcommand));
+cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                      cl::aliasopt(NumThreads), cl::cat(FileOptions),
+                      cl::sub(DumpSubcommand));
 
 // MISCELLANEOUS OPTIONS
 cl::opt<bool> DumpStringTable("string-table", cl::desc("dump PDB String Table"),
@@ -631,6 +639,13 @@ cl::list<std::string> InputFilenames(cl::Positional,
 cl::opt<std::string>
     PdbOutputFile("pdb", cl::desc("the name of the PDB file to write"),
                   cl::sub(MergeSubcommand));
+cl::opt<unsigned>
+    NumThreads("num-threads",
+               cl::desc("Number of threads to merge the type streams with "
+                        "(default: one per core)"),
+               cl::init(0), cl::sub(MergeSubcommand));
+cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                      cl::aliasopt(NumThreads), cl::sub(MergeSubcommand));
 }
 }
 
@@ -991,24 +1006,28 @@ static void mergePdbs() {
   TypeTableBuilder MergedTpi(Allocator);
   TypeTableBuilder MergedIpi(Allocator);
 
-  // Create a Tpi and Ipi type table with all types from all input files.
-  for (const auto &Path : opts::merge::InputFilenames) {
-    std::unique_ptr<IPDBSession> Session;
-    auto &File = loadPDB(Path, Session);
-    SmallVector<TypeIndex, 128> TypeMap;
-    SmallVector<TypeIndex, 128> IdMap;
-    if (File.hasPDBTpiStream()) {
-      auto &Tpi = ExitOnErr(File.getPDBTpiStream());
-      ExitOnErr(
-          codeview::mergeTypeRecords(MergedTpi, TypeMap, Tpi.typeArray()));
-    }
-    if (File.hasPDBIpiStream()) {
-      auto &Ipi = ExitOnErr(File.getPDBIpiStream());
-      ExitOnErr(codeview::mergeIdRecords(MergedIpi, TypeMap, IdMap,
-                                         Ipi.typeArray()));
-    }
+  // Create a Tpi and Ipi type table with all types from all input files. The
+  // streams of all the files are merged at once, so the files stay open until
+  // then.
+  size_t NumFiles = opts::merge::InputFilenames.size();
+  std::vector<std::unique_ptr<IPDBSession>> Sessions(NumFiles);
+  std::vector<CVTypeArray> TpiStreams(NumFiles);
+  std::vector<CVTypeArray> IpiStreams(NumFiles);
+  for (size_t I = 0; I != NumFiles; ++I) {
+    auto &File = loadPDB(opts::merge::InputFilenames[I], Sessions[I]);
+    if (File.hasPDBTpiStream())
+      TpiStreams[I] = ExitOnErr(File.getPDBTpiStream()).typeArray();
+    if (File.hasPDBIpiStream())
+      IpiStreams[I] = ExitOnErr(File.getPDBIpiStream()).typeArray();
   }
 
+  std::vector<SmallVector<TypeIndex, 0>> TypeMaps(NumFiles);
+  std::vector<SmallVector<TypeIndex, 0>> IdMaps(NumFiles);
+  ExitOnErr(codeview::mergeTypeRecords(MergedTpi, TypeMaps, TpiStreams,
+                                       opts::merge::NumThreads));
+  ExitOnErr(codeview::mergeIdRecords(MergedIpi, TypeMaps, IdMaps, IpiStreams,
+                                     opts::merge::NumThreads));
+
   // Then write the PDB.
   PDBFileBuilder Builder(Allocator);
   ExitOnErr(Builder.initialize(4096));
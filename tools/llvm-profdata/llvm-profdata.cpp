@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
@@ -35,7 +36,13 @@
 
 using namespace llvm;
 
-enum ProfileFormat { PF_None = 0, PF_Text, PF_Binary, PF_GCC };
+enum ProfileFormat {
+  PF_None = 0,
+  PF_Text,
+  PF_Compact_Binary,
+  PF_GCC,
+  PF_Binary
+};
 
 static void exitWithError(const Twine &Message, StringRef Whence = "",
                           StringRef Hint = "") {
@@ -114,81 +121,124 @@ struct WeightedFile {
 };
 typedef SmallVector<WeightedFile, 5> WeightedFileVector;
 
-/// Keep track of merged data and reported errors.
-struct WriterContext {
-  std::mutex Lock;
-  InstrProfWriter Writer;
+/// The profile being merged, split into shards by function name. Each shard
+/// has its own lock, so inputs can be folded into the profile concurrently,
+/// and the memory in use is bounded by the size of the merged profile rather
+/// than by the number of inputs or threads.
+struct ShardedWriterContext {
+  struct Shard {
+    std::mutex Lock;
+    InstrProfWriter Writer;
+
+    Shard(bool IsSparse) : Writer(IsSparse) {}
+  };
+  std::vector<std::unique_ptr<Shard>> Shards;
+
+  /// Guards the fields below, as well as the reporting of warnings.
+  std::mutex ErrLock;
+  SmallSet<instrprof_error, 4> WriterErrorCodes;
+  /// The first hard error encountered, and the input it came from.
   Error Err;
-  StringRef ErrWhence;
-  std::mutex &ErrLock;
-  SmallSet<instrprof_error, 4> &WriterErrorCodes;
-
-  WriterContext(bool IsSparse, std::mutex &ErrLock,
-                SmallSet<instrprof_error, 4> &WriterErrorCodes)
-      : Lock(), Writer(IsSparse), Err(Error::success()), ErrWhence(""),
-        ErrLock(ErrLock), WriterErrorCodes(WriterErrorCodes) {}
+  std::string ErrWhence;
+  /// Whether the inputs are IR level profiles, once one has been loaded.
+  Optional<bool> IsIRLevelProfile;
+
+  ShardedWriterContext(bool IsSparse, unsigned NumShards)
+      : Err(Error::success()) {
+    for (unsigned I = 0; I < NumShards; ++I)
+      Shards.emplace_back(llvm::make_unique<Shard>(IsSparse));
+  }
+
+  /// Record a hard error, unless there already is one.
+  void setError(Error E, StringRef Whence) {
+    std::unique_lock<std::mutex> ErrGuard{ErrLock};
+    if (Err) {
+      consumeError(std::move(E));
+      return;
+    }
+    Err = std::move(E);
+    ErrWhence = Whence;
+  }
+
+  bool hasError() {
+    std::unique_lock<std::mutex> ErrGuard{ErrLock};
+    return bool(Err);
+  }
 };
 
-/// Load an input into a writer context.
-static void loadInput(const WeightedFile &Input, WriterContext *WC) {
-  std::unique_lock<std::mutex> CtxGuard{WC->Lock};
+/// The number of records read from an input before they are added to their
+/// shard, so that each shard lock is taken once per batch.
+static const unsigned ShardBatchSize = 64;
 
+/// Load an input and fold it into the shards of \p WC.
+static void loadInput(const WeightedFile &Input, ShardedWriterContext *WC) {
   // If there's a pending hard error, don't do more work.
-  if (WC->Err)
+  if (WC->hasError())
     return;
 
-  WC->ErrWhence = Input.Filename;
-
   auto ReaderOrErr = InstrProfReader::create(Input.Filename);
   if (Error E = ReaderOrErr.takeError()) {
     // Skip the empty profiles by returning sliently.
     instrprof_error IPE = InstrProfError::take(std::move(E));
     if (IPE != instrprof_error::empty_raw_profile)
-      WC->Err = make_error<InstrProfError>(IPE);
+      WC->setError(make_error<InstrProfError>(IPE), Input.Filename);
     return;
   }
 
   auto Reader = std::move(ReaderOrErr.get());
   bool IsIRProfile = Reader->isIRLevelProfile();
-  if (WC->Writer.setIsIRLevelProfile(IsIRProfile)) {
-    WC->Err = make_error<StringError>(
-        "Merge IR generated profile with Clang generated profile.",
-        std::error_code());
-    return;
+  {
+    std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
+    if (!WC->IsIRLevelProfile)
+      WC->IsIRLevelProfile = IsIRProfile;
+    if (*WC->IsIRLevelProfile != IsIRProfile) {
+      ErrGuard.unlock();
+      WC->setError(make_error<StringError>(
+                       "Merge IR generated profile with Clang generated "
+                       "profile.",
+                       std::error_code()),
+                   Input.Filename);
+      return;
+    }
   }
 
+  // The records refer to names owned by the reader, which outlives them.
+  std::vector<std::vector<NamedInstrProfRecord>> Batches(WC->Shards.size());
+  auto AddBatch = [&](unsigned ShardIdx) {
+    std::vector<NamedInstrProfRecord> &Batch = Batches[ShardIdx];
+    ShardedWriterContext::Shard &S = *WC->Shards[ShardIdx];
+    std::unique_lock<std::mutex> ShardGuard{S.Lock};
+    for (NamedInstrProfRecord &I : Batch) {
+      const StringRef FuncName = I.Name;
+      bool Reported = false;
+      S.Writer.addRecord(std::move(I), Input.Weight, [&](Error E) {
+        if (Reported) {
+          consumeError(std::move(E));
+          return;
+        }
+        Reported = true;
+        // Only show hint the first time an error occurs.
+        instrprof_error IPE = InstrProfError::take(std::move(E));
+        std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
+        bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
+        handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
+                               FuncName, firstTime);
+      });
+    }
+    Batch.clear();
+  };
+
   for (auto &I : *Reader) {
-    const StringRef FuncName = I.Name;
-    bool Reported = false;
-    WC->Writer.addRecord(std::move(I), Input.Weight, [&](Error E) {
-      if (Reported) {
-        consumeError(std::move(E));
-        return;
-      }
-      Reported = true;
-      // Only show hint the first time an error occurs.
-      instrprof_error IPE = InstrProfError::take(std::move(E));
-      std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
-      bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
-      handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
-                             FuncName, firstTime);
-    });
+    unsigned ShardIdx = hash_value(I.Name) % WC->Shards.size();
+    Batches[ShardIdx].push_back(std::move(I));
+    if (Batches[ShardIdx].size() == ShardBatchSize)
+      AddBatch(ShardIdx);
   }
+  for (unsigned ShardIdx = 0; ShardIdx < Batches.size(); ++ShardIdx)
+    if (!Batches[ShardIdx].empty())
+      AddBatch(ShardIdx);
   if (Reader->hasError())
-    WC->Err = Reader->getError();
-}
-
-/// Merge the \p Src writer context into \p Dst.
-static void mergeWriterContexts(WriterContext *Dst, WriterContext *Src) {
-  bool Reported = false;
-  Dst->Writer.mergeRecordsFromWriter(std::move(Src->Writer), [&](Error E) {
-    if (Reported) {
-      consumeError(std::move(E));
-      return;
-    }
-    Reported = true;
-    Dst->Err = std::move(E);
-  });
+    WC->setError(Reader->getError(), Input.Filename);
 }
 
 static void mergeInstrProfile(const WeightedFileVector &Inputs,
@@ -206,59 +256,40 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   if (EC)
     exitWithErrorCode(EC, OutputFilename);
 
-  std::mutex ErrorLock;
-  SmallSet<instrprof_error, 4> WriterErrorCodes;
-
   // If NumThreads is not specified, auto-detect a good default.
   if (NumThreads == 0)
     NumThreads = std::max(1U, std::min(std::thread::hardware_concurrency(),
-                                       unsigned(Inputs.size() / 2)));
-
-  // Initialize the writer contexts.
-  SmallVector<std::unique_ptr<WriterContext>, 4> Contexts;
-  for (unsigned I = 0; I < NumThreads; ++I)
-    Contexts.emplace_back(llvm::make_unique<WriterContext>(
-        OutputSparse, ErrorLock, WriterErrorCodes));
+                                       unsigned(Inputs.size())));
 
+  // Use a few shards per thread, so that threads rarely wait on each other.
+  ShardedWriterContext WC(OutputSparse, NumThreads == 1 ? 1 : NumThreads * 4);
   if (NumThreads == 1) {
     for (const auto &Input : Inputs)
-      loadInput(Input, Contexts[0].get());
+      loadInput(Input, &WC);
   } else {
     ThreadPool Pool(NumThreads);
-
-    // Load the inputs in parallel (N/NumThreads serial steps).
-    unsigned Ctx = 0;
-    for (const auto &Input : Inputs) {
-      Pool.async(loadInput, Input, Contexts[Ctx].get());
-      Ctx = (Ctx + 1) % NumThreads;
-    }
+    for (const auto &Input : Inputs)
+      Pool.async(loadInput, Input, &WC);
     Pool.wait();
-
-    // Merge the writer contexts together (~ lg(NumThreads) serial steps).
-    unsigned Mid = Contexts.size() / 2;
-    unsigned End = Contexts.size();
-    assert(Mid > 0 && "Expected more than one context");
-    do {
-      for (unsigned I = 0; I < Mid; ++I)
-        Pool.async(mergeWriterContexts, Contexts[I].get(),
-                   Contexts[I + Mid].get());
-      Pool.wait();
-      if (End & 1) {
-        Pool.async(mergeWriterContexts, Contexts[0].get(),
-                   Contexts[End - 1].get());
-        Pool.wait();
-      }
-      End = Mid;
-      Mid /= 2;
-    } while (Mid > 0);
   }
 
   // Handle deferred hard errors encountered during merging.
-  for (std::unique_ptr<WriterContext> &WC : Contexts)
-    if (WC->Err)
-      exitWithError(std::move(WC->Err), WC->ErrWhence);
+  if (WC.Err)
+    exitWithError(std::move(WC.Err), WC.ErrWhence);
+
+  // The shards hold disjoint sets of functions. Move them into a single
+  // writer one at a time, freeing each shard as it goes.
+  InstrProfWriter Writer(OutputSparse);
+  if (WC.IsIRLevelProfile)
+    if (Error E = Writer.setIsIRLevelProfile(*WC.IsIRLevelProfile))
+      exitWithError(std::move(E));
+  for (auto &S : WC.Shards) {
+    Writer.mergeRecordsFromWriter(std::move(S->Writer), [&](Error E) {
+      exitWithError(std::move(E));
+    });
+    S.reset();
+  }
 
-  InstrProfWriter &Writer = Contexts[0]->Writer;
   if (OutputFormat == PF_Text) {
     if (Error E = Writer.writeText(Output))
       exitWithError(std::move(E));
@@ -268,8 +299,8 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
 }
 
 static sampleprof::SampleProfileFormat FormatMap[] = {
-    sampleprof::SPF_None, sampleprof::SPF_Text, sampleprof::SPF_Binary,
-    sampleprof::SPF_GCC};
+    sampleprof::SPF_None, sampleprof::SPF_Text, sampleprof::SPF_Compact_Binary,
+    sampleprof::SPF_GCC, sampleprof::SPF_Binary};
 
 static void mergeSampleProfile(const WeightedFileVector &Inputs,
                                StringRef OutputFilename,
@@ -418,6 +449,9 @@ static int merge_main(int argc, const char *argv[]) {
   cl::opt<ProfileFormat> OutputFormat(
       cl::desc("Format of output profile"), cl::init(PF_Binary),
       cl::values(clEnumValN(PF_Binary, "binary", "Binary encoding (default)"),
+                 clEnumValN(PF_Compact_Binary, "compbinary",
+                            "Compact binary encoding (only meaningful for "
+                            "-sample)"),
                  clEnumValN(PF_Text, "text", "Text encoding"),
                  clEnumValN(PF_GCC, "gcc",
                             "GCC encoding (only meaningful for -sample)")));
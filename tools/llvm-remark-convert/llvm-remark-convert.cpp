@@ -0,0 +1,71 @@
+//===- llvm-remark-convert.cpp - Binary optimization remarks converter ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program converts a binary optimization remarks file, as written with
+// -pass-remarks-format=binary, to the YAML optimization record format read by
+// tools such as opt-viewer and llvm-opt-report.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/BinaryRemarks.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static cl::opt<std::string> InputFilename(cl::Positional,
+                                          cl::desc("<input file>"),
+                                          cl::init("-"));
+
+static cl::opt<std::string> OutputFilename("o", cl::desc("Output filename"),
+                                           cl::value_desc("filename"),
+                                           cl::init("-"));
+
+static void error(const Twine &Msg) {
+  errs() << "llvm-remark-convert: " << Msg << '\n';
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  PrettyStackTraceProgram X(argc, argv);
+
+  cl::ParseCommandLineOptions(argc, argv,
+                              "binary optimization remarks to YAML converter\n");
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFileOrSTDIN(InputFilename, /*FileSize=*/-1,
+                                   /*RequiresNullTerminator=*/false);
+  if (std::error_code EC = BufOrErr.getError())
+    error(InputFilename + ": " + EC.message());
+
+  Expected<remarks::Reader> ReaderOrErr =
+      remarks::Reader::create((*BufOrErr)->getBuffer());
+  if (!ReaderOrErr)
+    error(InputFilename + ": " + toString(ReaderOrErr.takeError()));
+
+  std::error_code EC;
+  ToolOutputFile Out(OutputFilename, EC, sys::fs::F_None);
+  if (EC)
+    error(OutputFilename + ": " + EC.message());
+
+  yaml::Output YOut(Out.os());
+  for (size_t I = 0, E = ReaderOrErr->size(); I != E; ++I)
+    remarks::writeYAML(YOut, ReaderOrErr->getRemark(I));
+
+  Out.keep();
+  return 0;
+}
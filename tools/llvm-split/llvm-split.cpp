@@ -40,6 +40,10 @@ static cl::opt<bool>
     PreserveLocals("preserve-locals", cl::Prefix, cl::init(false),
                    cl::desc("Split without externalizing locals"));
 
+static cl::opt<bool>
+    BalanceBySize("balance-by-size", cl::Prefix, cl::init(false),
+                  cl::desc("Balance partitions by estimated code size"));
+
 int main(int argc, char **argv) {
   LLVMContext Context;
   SMDiagnostic Err;
@@ -67,7 +71,7 @@ int main(int argc, char **argv) {
 
     // Declare success.
     Out->keep();
-  }, PreserveLocals);
+  }, PreserveLocals, BalanceBySize);
 
   return 0;
 }
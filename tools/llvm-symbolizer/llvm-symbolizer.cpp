@@ -30,6 +30,7 @@
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -73,6 +74,24 @@ static cl::opt<std::string>
     ClDwpName("dwp", cl::init(""),
               cl::desc("Path to DWP file to be use for any split CUs"));
 
+static cl::opt<std::string>
+    ClCacheDir("cache-dir", cl::init(""),
+               cl::desc("Directory in which to keep symbolization results "
+                        "across runs, keyed by the build ID of each binary"));
+
+static cl::opt<bool>
+    ClBatch("batch", cl::init(false),
+            cl::desc("Read all of the input before printing anything, and "
+                     "symbolize the addresses of different modules in "
+                     "parallel (not suitable for interactive use)"));
+
+static cl::opt<unsigned>
+    ClNumThreads("num-threads", cl::init(0),
+                 cl::desc("Number of threads to use with -batch "
+                          "(0 means one per core)"));
+static cl::alias ClNumThreadsAlias("j", cl::desc("Alias for -num-threads"),
+                                   cl::aliasopt(ClNumThreads));
+
 static cl::list<std::string>
 ClDsymHint("dsym-hint", cl::ZeroOrMore,
            cl::desc("Path to .dSYM bundles to search for debug info for the "
@@ -144,6 +163,74 @@ static bool parseCommand(StringRef InputString, bool &IsData,
   return !StringRef(pos, offset_length).getAsInteger(0, ModuleOffset);
 }
 
+static const int kMaxInputStringLength = 1024;
+
+static void printAddress(uint64_t ModuleOffset) {
+  outs() << "0x";
+  outs().write_hex(ModuleOffset);
+  StringRef Delimiter = (ClPrettyPrint == true) ? ": " : "\n";
+  outs() << Delimiter;
+}
+
+namespace {
+struct InputLine {
+  std::string Text;
+  bool IsCommand;
+  bool IsData;
+  std::string ModuleName;
+  uint64_t ModuleOffset;
+};
+} // end anonymous namespace
+
+// Reads all of the input up front, resolves its code addresses with the batch
+// interface and prints the results in input order.
+static void symbolizeBatch(LLVMSymbolizer &Symbolizer, DIPrinter &Printer) {
+  std::vector<InputLine> Lines;
+  char InputString[kMaxInputStringLength];
+  while (fgets(InputString, sizeof(InputString), stdin)) {
+    InputLine Line;
+    Line.Text = InputString;
+    Line.IsCommand = parseCommand(StringRef(InputString), Line.IsData,
+                                  Line.ModuleName, Line.ModuleOffset);
+    Lines.push_back(std::move(Line));
+  }
+
+  std::vector<LLVMSymbolizer::SymbolizeRequest> Requests;
+  for (const InputLine &Line : Lines)
+    if (Line.IsCommand && !Line.IsData)
+      Requests.push_back({Line.ModuleName, Line.ModuleOffset});
+  std::vector<Expected<DIInliningInfo>> InlinedResults;
+  std::vector<Expected<DILineInfo>> Results;
+  if (ClPrintInlining)
+    InlinedResults =
+        Symbolizer.symbolizeInlinedCode(Requests, ClDwpName, ClNumThreads);
+  else
+    Results = Symbolizer.symbolizeCode(Requests, ClDwpName, ClNumThreads);
+
+  size_t NextResult = 0;
+  for (InputLine &Line : Lines) {
+    if (!Line.IsCommand) {
+      outs() << Line.Text;
+      continue;
+    }
+    if (ClPrintAddress)
+      printAddress(Line.ModuleOffset);
+    if (Line.IsData) {
+      auto ResOrErr =
+          Symbolizer.symbolizeData(Line.ModuleName, Line.ModuleOffset);
+      Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
+    } else if (ClPrintInlining) {
+      auto &ResOrErr = InlinedResults[NextResult++];
+      Printer << (error(ResOrErr) ? DIInliningInfo() : ResOrErr.get());
+    } else {
+      auto &ResOrErr = Results[NextResult++];
+      Printer << (error(ResOrErr) ? DILineInfo() : ResOrErr.get());
+    }
+    outs() << "\n";
+  }
+  outs().flush();
+}
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal(argv[0]);
@@ -164,12 +251,17 @@ int main(int argc, char **argv) {
                 "\" (must have the '.dSYM' extension).\n";
     }
   }
+  Opts.CachePath = ClCacheDir;
   LLVMSymbolizer Symbolizer(Opts);
 
   DIPrinter Printer(outs(), ClPrintFunctions != FunctionNameKind::None,
                     ClPrettyPrint, ClPrintSourceContextLines, ClVerbose);
 
-  const int kMaxInputStringLength = 1024;
+  if (ClBatch) {
+    symbolizeBatch(Symbolizer, Printer);
+    return 0;
+  }
+
   char InputString[kMaxInputStringLength];
 
   while (true) {
@@ -185,12 +277,8 @@ int main(int argc, char **argv) {
       continue;
     }
 
-    if (ClPrintAddress) {
-      outs() << "0x";
-      outs().write_hex(ModuleOffset);
-      StringRef Delimiter = (ClPrettyPrint == true) ? ": " : "\n";
-      outs() << Delimiter;
-    }
+    if (ClPrintAddress)
+      printAddress(ModuleOffset);
     if (IsData) {
       auto ResOrErr = Symbolizer.symbolizeData(ModuleName, ModuleOffset);
       Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
@@ -0,0 +1,83 @@
+//===- thread-shard-helper.h - XRay Per-Thread Record Sharding ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Defines a helper to spread the records of an XRay trace across a thread
+// pool, sharded by thread id.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_TOOLS_LLVM_XRAY_THREAD_SHARD_HELPER_H
+#define LLVM_TOOLS_LLVM_XRAY_THREAD_SHARD_HELPER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/ThreadPool.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+namespace xray {
+
+// Collects items (typically trace records) into per-shard batches, where all
+// the items of one thread id belong to the same shard, and hands the batches
+// to a thread pool. The batches of a shard are consumed one at a time and in
+// the order they were pushed, so that state kept per thread id can live in the
+// shard without any locking. While the pool works on one round of batches the
+// caller is free to read and push the items of the next round.
+template <class ItemT> class ThreadShardedBatches {
+  ThreadPool &Pool;
+  std::vector<std::vector<ItemT>> Pending;
+  std::vector<std::vector<ItemT>> Running;
+  size_t PendingItems = 0;
+
+public:
+  // The number of items to collect before a round of batches is worth handing
+  // out to the pool.
+  static constexpr size_t RoundSize = 1 << 14;
+
+  ThreadShardedBatches(ThreadPool &Pool, unsigned NumShards)
+      : Pool(Pool), Pending(NumShards), Running(NumShards) {}
+
+  ~ThreadShardedBatches() { Pool.wait(); }
+
+  unsigned getNumShards() const { return Pending.size(); }
+
+  unsigned getShard(uint32_t TId) const { return TId % Pending.size(); }
+
+  // Queues the item for the shard owning thread \p TId. Returns true once a
+  // full round of items is pending.
+  bool push(uint32_t TId, ItemT Item) {
+    Pending[getShard(TId)].push_back(std::move(Item));
+    return ++PendingItems >= RoundSize;
+  }
+
+  // Waits for the previous round to be consumed, then hands every non-empty
+  // pending batch to \p Consume on the pool. \p Consume is called as
+  // Consume(Shard, ArrayRef<ItemT>) and must only touch the state of its shard.
+  template <class ConsumeFn> void flush(ConsumeFn Consume) {
+    Pool.wait();
+    std::swap(Pending, Running);
+    for (auto &Batch : Pending)
+      Batch.clear();
+    PendingItems = 0;
+    for (unsigned Shard = 0, E = Running.size(); Shard != E; ++Shard) {
+      if (Running[Shard].empty())
+        continue;
+      ArrayRef<ItemT> Batch = Running[Shard];
+      Pool.async([Consume, Shard, Batch] { Consume(Shard, Batch); });
+    }
+  }
+
+  // Waits for all the batches handed out so far to be consumed.
+  void wait() { Pool.wait(); }
+};
+
+} // namespace xray
+} // namespace llvm
+
+#endif // LLVM_TOOLS_LLVM_XRAY_THREAD_SHARD_HELPER_H
@@ -17,10 +17,14 @@
 #include <system_error>
 #include <utility>
 
+#include "thread-shard-helper.h"
 #include "xray-account.h"
 #include "xray-registry.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/XRay/InstrumentationMap.h"
 #include "llvm/XRay/Trace.h"
 
@@ -121,6 +125,15 @@ static cl::alias AccountInstrMap2("m", cl::aliasopt(AccountInstrMap),
                                   cl::desc("Alias for -instr_map"),
                                   cl::sub(Account));
 
+static cl::opt<unsigned>
+    AccountThreads("num-threads", cl::init(0),
+                   cl::desc("Number of threads to account the records with, "
+                            "sharded by thread id (default: autodetect)"),
+                   cl::sub(Account));
+static cl::alias AccountThreads2("j", cl::aliasopt(AccountThreads),
+                                 cl::desc("Alias for -num-threads"),
+                                 cl::sub(Account));
+
 namespace {
 
 template <class T, class U> void setMinMax(std::pair<T, T> &MM, U &&V) {
@@ -215,6 +228,95 @@ bool LatencyAccountant::accountRecord(const XRayRecord &Record) {
   return true;
 }
 
+uint32_t LatencyDistribution::getBucket(uint64_t Latency) {
+  // Latencies under 256 have a bucket each. Above, each power of two is split
+  // in 128 buckets, along the 7 bits that follow the leading one.
+  if (Latency < 256)
+    return Latency;
+  unsigned Log2 = Log2_64(Latency);
+  return 256 + (Log2 - 8) * 128 + ((Latency >> (Log2 - 7)) & 127);
+}
+
+uint64_t LatencyDistribution::getBucketLatency(uint32_t Bucket) {
+  if (Bucket < 256)
+    return Bucket;
+  unsigned Log2 = (Bucket - 256) / 128 + 8;
+  uint64_t Low = uint64_t(128 + (Bucket - 256) % 128) << (Log2 - 7);
+  // Use the middle of the bucket.
+  return Low + (uint64_t(1) << (Log2 - 8));
+}
+
+void LatencyDistribution::moveSamplesToBuckets() {
+  for (uint64_t Latency : Samples)
+    ++Buckets[getBucket(Latency)];
+  Samples.clear();
+  Samples.shrink_to_fit();
+}
+
+void LatencyDistribution::add(uint64_t Latency) {
+  ++Count;
+  Min = std::min(Min, Latency);
+  Max = std::max(Max, Latency);
+  Sum += Latency;
+  if (!isExact()) {
+    ++Buckets[getBucket(Latency)];
+    return;
+  }
+  Samples.push_back(Latency);
+  if (Samples.size() > ExactLimit)
+    moveSamplesToBuckets();
+}
+
+void LatencyDistribution::merge(LatencyDistribution &&Other) {
+  if (Other.empty())
+    return;
+  if (empty()) {
+    *this = std::move(Other);
+    return;
+  }
+  Count += Other.Count;
+  Min = std::min(Min, Other.Min);
+  Max = std::max(Max, Other.Max);
+  Sum += Other.Sum;
+  if (isExact() && Other.isExact()) {
+    Samples.insert(Samples.end(), Other.Samples.begin(), Other.Samples.end());
+    if (Samples.size() > ExactLimit)
+      moveSamplesToBuckets();
+    return;
+  }
+  if (isExact())
+    moveSamplesToBuckets();
+  Other.moveSamplesToBuckets();
+  for (const auto &Bucket : Other.Buckets)
+    Buckets[Bucket.first] += Bucket.second;
+}
+
+uint64_t LatencyDistribution::getLatencyOfRank(uint64_t Rank) const {
+  assert(Rank < Count && "rank out of range");
+  uint64_t Seen = 0;
+  for (const auto &Bucket : Buckets) {
+    Seen += Bucket.second;
+    if (Seen > Rank)
+      return std::max(Min, std::min(Max, getBucketLatency(Bucket.first)));
+  }
+  return Max;
+}
+
+void LatencyAccountant::mergeShard(LatencyAccountant &&Shard) {
+  for (auto &FT : Shard.FunctionLatencies)
+    FunctionLatencies[FT.first].merge(std::move(FT.second));
+  for (auto &ThreadStack : Shard.PerThreadFunctionStack)
+    PerThreadFunctionStack[ThreadStack.first] = std::move(ThreadStack.second);
+  PerThreadMinMaxTSC.insert(Shard.PerThreadMinMaxTSC.begin(),
+                            Shard.PerThreadMinMaxTSC.end());
+  for (const auto &CPUMinMax : Shard.PerCPUMinMaxTSC) {
+    auto &MM = PerCPUMinMaxTSC[CPUMinMax.first];
+    setMinMax(MM, CPUMinMax.second.first);
+    setMinMax(MM, CPUMinMax.second.second);
+  }
+  CurrentMaxTSC = std::max(CurrentMaxTSC, Shard.CurrentMaxTSC);
+}
+
 namespace {
 
 // We consolidate the data into a struct which we can output in various forms.
@@ -250,6 +352,21 @@ ResultRow getStats(std::vector<uint64_t> &Timings) {
   return R;
 }
 
+ResultRow getStats(LatencyDistribution &Latencies) {
+  if (Latencies.isExact())
+    return getStats(Latencies.samples());
+  ResultRow R;
+  R.Sum = Latencies.sum();
+  R.Min = Latencies.min();
+  R.Max = Latencies.max();
+  uint64_t Count = Latencies.size();
+  R.Median = Latencies.getLatencyOfRank(Count / 2);
+  R.Pct90 = Latencies.getLatencyOfRank(std::floor(Count * 0.9));
+  R.Pct99 = Latencies.getLatencyOfRank(std::floor(Count * 0.99));
+  R.Count = Count;
+  return R;
+}
+
 } // namespace
 
 template <class F>
@@ -432,6 +549,107 @@ template <> struct format_provider<llvm::xray::RecordTypes> {
 };
 } // namespace llvm
 
+static Error inputLoadError(Error E) {
+  return joinErrors(
+      make_error<StringError>(
+          Twine("Failed loading input file '") + AccountInput + "'",
+          std::make_error_code(std::errc::executable_format_error)),
+      std::move(E));
+}
+
+static Error accountSerially(TraceStream &T, LatencyAccountant &FCA,
+                             const FuncIdConversionHelper &FuncIdHelper) {
+  // Account the records as they are read, so that the trace never has to be
+  // entirely in memory; only the latency of each call is kept. A malformed
+  // record ends the loop, after the records before it have been accounted.
+  Error Err = Error::success();
+  for (const auto &Record : T.records(Err)) {
+    if (FCA.accountRecord(Record))
+      continue;
+    errs()
+        << "Error processing record: "
+        << llvm::formatv(
+               R"({{type: {0}; cpu: {1}; record-type: {2}; function-id: {3}; tsc: {4}; thread-id: {5}}})",
+               Record.RecordType, Record.CPU, Record.Type, Record.FuncId,
+               Record.TId)
+        << '\n';
+    for (const auto &ThreadStack : FCA.getPerThreadFunctionStack()) {
+      errs() << "Thread ID: " << ThreadStack.first << "\n";
+      if (ThreadStack.second.empty()) {
+        errs() << "  (empty stack)\n";
+        continue;
+      }
+      auto Level = ThreadStack.second.size();
+      for (const auto &Entry : llvm::reverse(ThreadStack.second))
+        errs() << "  #" << Level-- << "\t"
+               << FuncIdHelper.SymbolOrNumber(Entry.first) << '\n';
+    }
+    if (!AccountKeepGoing) {
+      consumeError(std::move(Err));
+      return make_error<StringError>(
+          Twine("Failed accounting function calls in file '") + AccountInput +
+              "'.",
+          std::make_error_code(std::errc::executable_format_error));
+    }
+  }
+  if (Err)
+    return inputLoadError(std::move(Err));
+  return Error::success();
+}
+
+// Accounts the records of \p T on \p NumThreads threads. The records are
+// sharded by thread id, each shard is accounted by its own LatencyAccountant,
+// and the shards are merged into \p FCA at the end. Returns false if a shard
+// failed to account one of its records, in which case \p FCA is left untouched
+// and the trace has to be accounted serially to report the failure along with
+// the stacks of all the threads.
+static Expected<bool> accountInParallel(TraceStream &T, LatencyAccountant &FCA,
+                                        FuncIdConversionHelper &FuncIdHelper,
+                                        unsigned NumThreads) {
+  std::vector<LatencyAccountant> Shards;
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Shards.emplace_back(FuncIdHelper, AccountDeduceSiblingCalls);
+  // Not a std::vector<bool>, as the shards update their flags concurrently.
+  std::vector<char> Failed(NumThreads, false);
+  auto Consume = [&](unsigned Shard, ArrayRef<XRayRecord> Records) {
+    if (Failed[Shard])
+      return;
+    for (const auto &Record : Records)
+      if (!Shards[Shard].accountRecord(Record)) {
+        Failed[Shard] = true;
+        return;
+      }
+  };
+
+  ThreadPool Pool(NumThreads);
+  ThreadShardedBatches<XRayRecord> Batches(Pool, NumThreads);
+  uint64_t FirstTSC = 0;
+  Error Err = Error::success();
+  for (const auto &Record : T.records(Err)) {
+    // Every record is checked against the first timestamp of the whole trace,
+    // so no batch is handed out before that timestamp is known.
+    if (FirstTSC == 0 && Record.TSC != 0) {
+      FirstTSC = Record.TSC;
+      for (auto &Shard : Shards)
+        Shard.setFirstTSC(FirstTSC);
+    }
+    if (Batches.push(Record.TId, Record) && FirstTSC != 0)
+      Batches.flush(Consume);
+  }
+  Batches.flush(Consume);
+  Batches.wait();
+
+  if (any_of(Failed, [](char ShardFailed) { return ShardFailed; })) {
+    consumeError(std::move(Err));
+    return false;
+  }
+  if (Err)
+    return std::move(Err);
+  for (auto &Shard : Shards)
+    FCA.mergeShard(std::move(Shard));
+  return true;
+}
+
 static CommandRegistration Unused(&Account, []() -> Error {
   InstrumentationMap Map;
   if (!AccountInstrMap.empty()) {
@@ -458,42 +676,32 @@ static CommandRegistration Unused(&Account, []() -> Error {
   llvm::xray::FuncIdConversionHelper FuncIdHelper(AccountInstrMap, Symbolizer,
                                                   FunctionAddresses);
   xray::LatencyAccountant FCA(FuncIdHelper, AccountDeduceSiblingCalls);
-  auto TraceOrErr = loadTraceFile(AccountInput);
+  auto TraceOrErr = openTraceFile(AccountInput);
   if (!TraceOrErr)
-    return joinErrors(
-        make_error<StringError>(
-            Twine("Failed loading input file '") + AccountInput + "'",
-            std::make_error_code(std::errc::executable_format_error)),
-        TraceOrErr.takeError());
-
-  auto &T = *TraceOrErr;
-  for (const auto &Record : T) {
-    if (FCA.accountRecord(Record))
-      continue;
-    errs()
-        << "Error processing record: "
-        << llvm::formatv(
-               R"({{type: {0}; cpu: {1}; record-type: {2}; function-id: {3}; tsc: {4}; thread-id: {5}}})",
-               Record.RecordType, Record.CPU, Record.Type, Record.FuncId,
-               Record.TId)
-        << '\n';
-    for (const auto &ThreadStack : FCA.getPerThreadFunctionStack()) {
-      errs() << "Thread ID: " << ThreadStack.first << "\n";
-      if (ThreadStack.second.empty()) {
-        errs() << "  (empty stack)\n";
-        continue;
-      }
-      auto Level = ThreadStack.second.size();
-      for (const auto &Entry : llvm::reverse(ThreadStack.second))
-        errs() << "  #" << Level-- << "\t"
-               << FuncIdHelper.SymbolOrNumber(Entry.first) << '\n';
+    return inputLoadError(TraceOrErr.takeError());
+
+  unsigned NumThreads = AccountThreads ? unsigned(AccountThreads)
+                                       : heavyweight_hardware_concurrency();
+  bool Accounted = false;
+  if (NumThreads > 1) {
+    auto AccountedOrErr =
+        accountInParallel(*TraceOrErr, FCA, FuncIdHelper, NumThreads);
+    if (!AccountedOrErr)
+      return inputLoadError(AccountedOrErr.takeError());
+    Accounted = *AccountedOrErr;
+    if (!Accounted) {
+      // Start over from the beginning of the trace to report the failure.
+      TraceOrErr = openTraceFile(AccountInput);
+      if (!TraceOrErr)
+        return inputLoadError(TraceOrErr.takeError());
     }
-    if (!AccountKeepGoing)
-      return make_error<StringError>(
-          Twine("Failed accounting function calls in file '") + AccountInput +
-              "'.",
-          std::make_error_code(std::errc::executable_format_error));
   }
+  if (!Accounted) {
+    if (auto E = accountSerially(*TraceOrErr, FCA, FuncIdHelper))
+      return E;
+  }
+
+  auto &T = *TraceOrErr;
   switch (AccountOutputFormat) {
   case AccountOutputFormats::TEXT:
     FCA.exportStatsAsText(OS, T.getFileHeader());
@@ -14,6 +14,8 @@
 #ifndef LLVM_TOOLS_LLVM_XRAY_XRAY_ACCOUNT_H
 #define LLVM_TOOLS_LLVM_XRAY_XRAY_ACCOUNT_H
 
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <utility>
 #include <vector>
@@ -26,9 +28,51 @@
 namespace llvm {
 namespace xray {
 
+/// The latencies of the calls to a function. The first ExactLimit latencies
+/// are kept, so that the statistics of short traces are exact. Past that, the
+/// latencies are counted in buckets 1/128th of a power of two wide. This
+/// bounds the memory used per function, whatever the length of the trace,
+/// and the percentiles are then within 1/256th of the exact ones.
+class LatencyDistribution {
+public:
+  static const size_t ExactLimit = 4096;
+
+private:
+  uint64_t Count = 0;
+  uint64_t Min = std::numeric_limits<uint64_t>::max();
+  uint64_t Max = 0;
+  double Sum = 0;
+  // The latencies, while there are at most ExactLimit of them.
+  std::vector<uint64_t> Samples;
+  // The number of latencies in each bucket, once there are more.
+  std::map<uint32_t, uint64_t> Buckets;
+
+  static uint32_t getBucket(uint64_t Latency);
+  static uint64_t getBucketLatency(uint32_t Bucket);
+  void moveSamplesToBuckets();
+
+public:
+  void add(uint64_t Latency);
+  void merge(LatencyDistribution &&Other);
+
+  uint64_t size() const { return Count; }
+  bool empty() const { return Count == 0; }
+  uint64_t min() const { return Min; }
+  uint64_t max() const { return Max; }
+  double sum() const { return Sum; }
+
+  /// Returns true if every latency is still kept, in samples().
+  bool isExact() const { return Buckets.empty(); }
+  std::vector<uint64_t> &samples() { return Samples; }
+
+  /// Returns the latency of the given rank, counted from 0 in increasing order
+  /// of latency, as estimated from the buckets.
+  uint64_t getLatencyOfRank(uint64_t Rank) const;
+};
+
 class LatencyAccountant {
 public:
-  typedef std::map<int32_t, std::vector<uint64_t>> FunctionLatencyMap;
+  typedef std::map<int32_t, LatencyDistribution> FunctionLatencyMap;
   typedef std::map<llvm::sys::ProcessInfo::ProcessId,
                    std::pair<uint64_t, uint64_t>>
       PerThreadMinMaxTSCMap;
@@ -48,7 +92,7 @@ private:
   uint64_t CurrentMaxTSC = 0;
 
   void recordLatency(int32_t FuncId, uint64_t Latency) {
-    FunctionLatencies[FuncId].push_back(Latency);
+    FunctionLatencies[FuncId].add(Latency);
   }
 
 public:
@@ -68,6 +112,16 @@ public:
     return PerCPUMinMaxTSC;
   }
 
+  /// Accounts the following records as if a record with timestamp \p TSC had
+  /// been seen first. This lets an accountant that only sees some of the
+  /// threads of a trace check the records against the start of the trace.
+  void setFirstTSC(uint64_t TSC) { CurrentMaxTSC = TSC; }
+
+  /// Folds the latencies and the timestamp ranges accounted by \p Shard into
+  /// this accountant. The two accountants must have seen disjoint sets of
+  /// threads.
+  void mergeShard(LatencyAccountant &&Shard);
+
   /// Returns false in case we fail to account the provided record. This happens
   /// in the following cases:
   ///
@@ -19,13 +19,16 @@
 #include <numeric>
 
 #include "func-id-helper.h"
+#include "thread-shard-helper.h"
 #include "xray-registry.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatAdapters.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/XRay/Graph.h"
 #include "llvm/XRay/InstrumentationMap.h"
 #include "llvm/XRay/Trace.h"
@@ -66,6 +69,15 @@ static cl::opt<bool>
                      cl::desc("Aggregate stack times across threads"),
                      cl::sub(Stack), cl::init(false));
 
+static cl::opt<unsigned>
+    StackThreads("num-threads", cl::init(0),
+                 cl::desc("Number of threads to build the stacks with, sharded "
+                          "by thread id (default: autodetect)"),
+                 cl::sub(Stack));
+static cl::alias StackThreads2("j", cl::aliasopt(StackThreads),
+                               cl::desc("Alias for -num-threads"),
+                               cl::sub(Stack));
+
 /// A helper struct to work with formatv and XRayRecords. Makes it easier to use
 /// instrumentation map names or addresses in formatted output.
 struct format_xray_record : public FormatAdapter<XRayRecord> {
@@ -400,6 +412,25 @@ public:
 
   bool isEmpty() const { return Roots.empty(); }
 
+  /// Moves the tries built by \p Shards into this empty trie. Each shard must
+  /// have accounted the threads whose ids are congruent to its index modulo
+  /// the number of shards. \p ThreadIds lists the threads in the order they
+  /// first entered a function, so that the threads are reported in the same
+  /// order as if the records had all been accounted by this trie.
+  void takeShards(MutableArrayRef<StackTrie> Shards,
+                  ArrayRef<uint32_t> ThreadIds) {
+    assert(isEmpty() && "Shards can only be taken by an empty trie");
+    for (auto TId : ThreadIds) {
+      auto &Shard = Shards[TId % Shards.size()];
+      Roots[TId] = std::move(Shard.Roots[TId]);
+    }
+    for (auto &Shard : Shards) {
+      for (auto &ThreadStack : Shard.ThreadStackMap)
+        ThreadStackMap[ThreadStack.first] = std::move(ThreadStack.second);
+      NodeStore.splice_after(NodeStore.before_begin(), Shard.NodeStore);
+    }
+  }
+
   void printStack(raw_ostream &OS, const TrieNode *Top,
                   FuncIdConversionHelper &FN) {
     // Traverse the pointers up to the parent, noting the sums, then print
@@ -472,9 +503,12 @@ public:
         if (MaybeFoundIter == RootValues.end()) {
           RootValues.push_back(Node);
         } else {
-          RootValues.push_back(mergeTrieNodes(**MaybeFoundIter, *Node, nullptr,
-                                              AggregatedNodeStore));
+          // Erase the found root before appending the merged one, as the
+          // append may reallocate and invalidate the iterator.
+          auto *Merged = mergeTrieNodes(**MaybeFoundIter, *Node, nullptr,
+                                        AggregatedNodeStore);
           RootValues.erase(MaybeFoundIter);
+          RootValues.push_back(Merged);
         }
       }
     }
@@ -565,6 +599,140 @@ std::string CreateErrorMessage(StackTrie::AccountRecordStatus Error,
   }
 }
 
+static Error inputLoadError(StringRef Filename, Error E) {
+  return joinErrors(
+      make_error<StringError>(
+          Twine("Failed loading input file '") + Filename + "'",
+          std::make_error_code(std::errc::invalid_argument)),
+      std::move(E));
+}
+
+// Accounts all the input files to \p ST, one record at a time.
+static Error accountSerially(StackTrie &ST,
+                             const FuncIdConversionHelper &FuncIdHelper) {
+  // The records of each file are accounted as they are read, so that the traces
+  // never have to be entirely in memory.
+  for (const auto &Filename : StackInputs) {
+    auto TraceOrErr = openTraceFile(Filename);
+    if (!TraceOrErr) {
+      if (!StackKeepGoing)
+        return inputLoadError(Filename, TraceOrErr.takeError());
+      logAllUnhandledErrors(TraceOrErr.takeError(), errs(), "");
+      continue;
+    }
+    auto &T = *TraceOrErr;
+    StackTrie::AccountRecordState AccountRecordState =
+        StackTrie::AccountRecordState::CreateInitialState();
+    Error Err = Error::success();
+    for (const auto &Record : T.records(Err)) {
+      auto error = ST.accountRecord(Record, &AccountRecordState);
+      if (error != StackTrie::AccountRecordStatus::OK) {
+        if (!StackKeepGoing) {
+          consumeError(std::move(Err));
+          return make_error<StringError>(
+              CreateErrorMessage(error, Record, FuncIdHelper),
+              make_error_code(errc::illegal_byte_sequence));
+        }
+        errs() << CreateErrorMessage(error, Record, FuncIdHelper);
+      }
+    }
+    if (Err) {
+      if (!StackKeepGoing)
+        return inputLoadError(Filename, std::move(Err));
+      logAllUnhandledErrors(std::move(Err), errs(), "");
+    }
+  }
+  return Error::success();
+}
+
+namespace {
+
+// A record along with the unwinding state of its trace before the record. The
+// state depends on the record that precedes it in the trace, whichever thread
+// that record came from, so it is computed while the records are dispatched.
+struct ShardedRecord {
+  XRayRecord Record;
+  bool WasLastRecordExit;
+};
+
+} // namespace
+
+// Accounts all the input files to \p ST on \p NumThreads threads. The records
+// are sharded by thread id, each shard builds its own StackTrie, and the tries
+// are moved into \p ST at the end. Returns false if a shard failed to account
+// one of its records, in which case \p ST is left untouched and the inputs have
+// to be accounted serially to report the failures in order. Errors loading the
+// inputs that are not fatal are logged to \p InputErrs.
+static Expected<bool> accountInParallel(StackTrie &ST, unsigned NumThreads,
+                                        raw_ostream &InputErrs) {
+  std::vector<StackTrie> Shards(NumThreads);
+  // Not a std::vector<bool>, as the shards update their flags concurrently.
+  std::vector<char> Failed(NumThreads, false);
+  auto Consume = [&](unsigned Shard, ArrayRef<ShardedRecord> Records) {
+    if (Failed[Shard])
+      return;
+    for (const auto &R : Records) {
+      StackTrie::AccountRecordState AccountRecordState = {R.WasLastRecordExit};
+      if (Shards[Shard].accountRecord(R.Record, &AccountRecordState) !=
+          StackTrie::AccountRecordStatus::OK) {
+        Failed[Shard] = true;
+        return;
+      }
+    }
+  };
+  auto AnyShardFailed = [&] {
+    return any_of(Failed, [](char ShardFailed) { return ShardFailed; });
+  };
+
+  ThreadPool Pool(NumThreads);
+  ThreadShardedBatches<ShardedRecord> Batches(Pool, NumThreads);
+  SetVector<uint32_t> ThreadIds;
+  for (const auto &Filename : StackInputs) {
+    auto TraceOrErr = openTraceFile(Filename);
+    if (!TraceOrErr) {
+      if (!StackKeepGoing)
+        return inputLoadError(Filename, TraceOrErr.takeError());
+      logAllUnhandledErrors(TraceOrErr.takeError(), InputErrs, "");
+      continue;
+    }
+    bool WasLastRecordExit = false;
+    Error Err = Error::success();
+    for (const auto &Record : TraceOrErr->records(Err)) {
+      bool IsFull = Batches.push(Record.TId, {Record, WasLastRecordExit});
+      switch (Record.Type) {
+      case RecordTypes::ENTER:
+      case RecordTypes::ENTER_ARG:
+        // The roots of a thread are created when it first enters a function.
+        ThreadIds.insert(Record.TId);
+        WasLastRecordExit = false;
+        break;
+      case RecordTypes::EXIT:
+      case RecordTypes::TAIL_EXIT:
+        WasLastRecordExit = true;
+        break;
+      }
+      if (IsFull)
+        Batches.flush(Consume);
+    }
+    Batches.flush(Consume);
+    Batches.wait();
+    // Failures are reported in the order of the inputs, so stop before an
+    // error in a later input could get reported.
+    if (AnyShardFailed()) {
+      consumeError(std::move(Err));
+      return false;
+    }
+    if (Err) {
+      if (!StackKeepGoing)
+        return inputLoadError(Filename, std::move(Err));
+      logAllUnhandledErrors(std::move(Err), InputErrs, "");
+    }
+  }
+
+  ST.takeShards(Shards, ThreadIds.getArrayRef());
+  return true;
+}
+
 static CommandRegistration Unused(&Stack, []() -> Error {
   // Load each file provided as a command-line argument. For each one of them
   // account to a single StackTrie, and just print the whole trie for now.
@@ -594,31 +762,24 @@ static CommandRegistration Unused(&Stack, []() -> Error {
                                       Map.getFunctionAddresses());
   // TODO: Someday, support output to files instead of just directly to
   // standard output.
-  for (const auto &Filename : StackInputs) {
-    auto TraceOrErr = loadTraceFile(Filename);
-    if (!TraceOrErr) {
-      if (!StackKeepGoing)
-        return joinErrors(
-            make_error<StringError>(
-                Twine("Failed loading input file '") + Filename + "'",
-                std::make_error_code(std::errc::invalid_argument)),
-            TraceOrErr.takeError());
-      logAllUnhandledErrors(TraceOrErr.takeError(), errs(), "");
-      continue;
-    }
-    auto &T = *TraceOrErr;
-    StackTrie::AccountRecordState AccountRecordState =
-        StackTrie::AccountRecordState::CreateInitialState();
-    for (const auto &Record : T) {
-      auto error = ST.accountRecord(Record, &AccountRecordState);
-      if (error != StackTrie::AccountRecordStatus::OK) {
-        if (!StackKeepGoing)
-          return make_error<StringError>(
-              CreateErrorMessage(error, Record, FuncIdHelper),
-              make_error_code(errc::illegal_byte_sequence));
-        errs() << CreateErrorMessage(error, Record, FuncIdHelper);
-      }
-    }
+  unsigned NumThreads =
+      StackThreads ? unsigned(StackThreads) : heavyweight_hardware_concurrency();
+  bool Accounted = false;
+  if (NumThreads > 1) {
+    std::string InputErrors;
+    raw_string_ostream InputErrs(InputErrors);
+    auto AccountedOrErr = accountInParallel(ST, NumThreads, InputErrs);
+    if (!AccountedOrErr)
+      return AccountedOrErr.takeError();
+    Accounted = *AccountedOrErr;
+    // The serial pass below reports these errors again along with the
+    // failures, so they're only reported when it doesn't run.
+    if (Accounted)
+      errs() << InputErrs.str();
+  }
+  if (!Accounted) {
+    if (auto E = accountSerially(ST, FuncIdHelper))
+      return E;
   }
   if (ST.isEmpty()) {
     return make_error<StringError>(
@@ -15,6 +15,7 @@
 #include "BreakpointPrinter.h"
 #include "NewPMDriver.h"
 #include "PassPrinters.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/CallGraphSCCPass.h"
@@ -25,6 +26,7 @@
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/IRPrintingPasses.h"
@@ -249,9 +251,18 @@ static cl::opt<unsigned> PassRemarksHotnessThreshold(
 
 static cl::opt<std::string>
     RemarksFilename("pass-remarks-output",
-                    cl::desc("YAML output filename for pass remarks"),
+                    cl::desc("Output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+enum RemarksFormatKind { RF_YAML, RF_Binary };
+
+static cl::opt<RemarksFormatKind> RemarksFormat(
+    "pass-remarks-format",
+    cl::desc("The format of the pass remarks output file"), cl::init(RF_YAML),
+    cl::values(clEnumValN(RF_YAML, "yaml", "YAML optimization records"),
+               clEnumValN(RF_Binary, "binary",
+                          "Binary remarks, see llvm-remark-convert")));
+
 static inline void addPass(legacy::PassManagerBase &PM, Pass *P) {
   // Add the pass to the pass manager...
   PM.add(P);
@@ -439,9 +450,19 @@ int main(int argc, char **argv) {
       errs() << EC.message() << '\n';
       return 1;
     }
-    Context.setDiagnosticsOutputFile(
-        llvm::make_unique<yaml::Output>(OptRemarkFile->os()));
+    if (RemarksFormat == RF_Binary)
+      Context.setDiagnosticsBinaryOutput(
+          llvm::make_unique<remarks::Writer>(OptRemarkFile->os()));
+    else
+      Context.setDiagnosticsOutputFile(
+          llvm::make_unique<yaml::Output>(OptRemarkFile->os()));
   }
+  // Binary remarks are written out on every way out of main, while the remarks
+  // file is still open.
+  auto FinalizeRemarks = make_scope_exit([&]() {
+    if (remarks::Writer *W = Context.getDiagnosticsBinaryOutput())
+      W->finalize();
+  });
 
   // Load the input module...
   std::unique_ptr<Module> M = parseIRFile(InputFilename, Err, Context);
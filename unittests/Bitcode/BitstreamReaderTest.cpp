@@ -140,6 +140,104 @@ TEST(BitstreamReaderTest, readRecordWithBlobWhileStreaming) {
   }
 }
 
+TEST(BitstreamReaderTest, readRecordWithArrays) {
+  // Values that need one, two and several VBR6 chunks.
+  SmallVector<uint64_t, 1> Numbers;
+  for (unsigned I = 0, E = 256; I != E; ++I)
+    Numbers.push_back(I % 3 ? I % 31 : (uint64_t(I) << (I % 40)) + I);
+  SmallVector<uint64_t, 1> Chars;
+  for (char C : StringRef("the_quick.brown.fox.jumps_over_the_lazy_DOG_42"))
+    Chars.push_back(C);
+
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  enum { FixedRec = 1, VBRRec, Char6Rec, WideRec, UnabbrevRec };
+
+  // Try a bunch of different sizes, so that the arrays start and end at
+  // different offsets in the words being decoded.
+  for (unsigned Size = 0, E = Numbers.size(); Size <= E; Size += 7) {
+    ArrayRef<uint64_t> In = makeArrayRef(Numbers).take_front(Size);
+    ArrayRef<uint64_t> CharsIn =
+        makeArrayRef(Chars).take_front(std::min<size_t>(Size, Chars.size()));
+    SmallVector<uint64_t, 1> Fixed, Wide;
+    for (uint64_t V : In) {
+      Fixed.push_back(V & 0x1fff);
+      Wide.push_back((V & 0xffffffff) | (uint64_t(1) << 31));
+    }
+
+    SmallVector<char, 1> Buffer;
+    {
+      BitstreamWriter Stream(Buffer);
+      Stream.EnterSubblock(BlockID, 3);
+
+      auto Abbrev = std::make_shared<BitCodeAbbrev>();
+      Abbrev->Add(BitCodeAbbrevOp(FixedRec));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 13));
+      unsigned FixedAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+      Abbrev = std::make_shared<BitCodeAbbrev>();
+      Abbrev->Add(BitCodeAbbrevOp(VBRRec));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+      unsigned VBRAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+      Abbrev = std::make_shared<BitCodeAbbrev>();
+      Abbrev->Add(BitCodeAbbrevOp(Char6Rec));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+      unsigned Char6Abbrev = Stream.EmitAbbrev(std::move(Abbrev));
+      Abbrev = std::make_shared<BitCodeAbbrev>();
+      Abbrev->Add(BitCodeAbbrevOp(WideRec));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+      unsigned WideAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+      Stream.EmitRecord(FixedRec, Fixed, FixedAbbrev);
+      Stream.EmitRecord(VBRRec, In, VBRAbbrev);
+      Stream.EmitRecord(Char6Rec, CharsIn, Char6Abbrev);
+      Stream.EmitRecord(WideRec, Wide, WideAbbrev);
+      Stream.EmitRecord(UnabbrevRec, In);
+      Stream.ExitBlock();
+    }
+
+    BitstreamCursor Stream(
+        ArrayRef<uint8_t>((const uint8_t *)Buffer.begin(), Buffer.size()));
+    BitstreamEntry Entry =
+        Stream.advance(BitstreamCursor::AF_DontAutoprocessAbbrevs);
+    ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+    ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+
+    auto ExpectRecord = [&](unsigned Code, ArrayRef<uint64_t> Expected) {
+      BitstreamEntry Entry = Stream.advance();
+      ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+      SmallVector<uint64_t, 1> Record;
+      ASSERT_EQ(Code, Stream.readRecord(Entry.ID, Record));
+      EXPECT_EQ(Expected, makeArrayRef(Record));
+    };
+    ExpectRecord(FixedRec, Fixed);
+    ExpectRecord(VBRRec, In);
+    ExpectRecord(Char6Rec, CharsIn);
+    ExpectRecord(WideRec, Wide);
+    ExpectRecord(UnabbrevRec, In);
+    EXPECT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+  }
+}
+
+TEST(BitstreamReaderTest, readFixedArrayOfWords) {
+  uint8_t Bytes[24];
+  for (unsigned I = 0; I != sizeof(Bytes); ++I)
+    Bytes[I] = I * 37 + 1;
+
+  SimpleBitstreamCursor Expected(Bytes), Cursor(Bytes);
+  (void)Expected.Read(4);
+  (void)Cursor.Read(4);
+  SmallVector<uint64_t, 2> Vals;
+  Cursor.readFixedArray(64, 2, Vals);
+  ASSERT_EQ(2u, Vals.size());
+  EXPECT_EQ(Expected.Read(64), Vals[0]);
+  EXPECT_EQ(Expected.Read(64), Vals[1]);
+  EXPECT_EQ(Expected.GetCurrentBitNo(), Cursor.GetCurrentBitNo());
+  EXPECT_EQ(Expected.Read(60), Cursor.Read(60));
+}
+
 TEST(BitstreamReaderTest, shortRead) {
   uint8_t Bytes[] = {8, 7, 6, 5, 4, 3, 2, 1};
   for (unsigned I = 1; I != 8; ++I) {
@@ -0,0 +1,208 @@
+//===- llvm/unittest/DebugInfo/CodeView/TypeStreamMergerTest.cpp ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/CodeView/TypeStreamMerger.h"
+
+#include "llvm/DebugInfo/CodeView/TypeTableBuilder.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/BinaryStreamReader.h"
+#include "llvm/Testing/Support/Error.h"
+
+#include "gtest/gtest.h"
+
+#include <deque>
+
+using namespace llvm;
+using namespace llvm::codeview;
+
+namespace {
+
+// Compares merging several streams at once with merging them one at a time.
+class TypeStreamMergerTest : public testing::Test {
+protected:
+  // Starts a new source stream. Records are written without deduplication so
+  // that a stream can contain duplicates, like the streams of real objects.
+  TypeTableBuilder &startStream() {
+    Builders.push_back(llvm::make_unique<TypeTableBuilder>(Storage, false));
+    return *Builders.back();
+  }
+
+  std::vector<CVTypeArray> finishStreams() {
+    std::vector<CVTypeArray> Streams;
+    for (const auto &Builder : Builders) {
+      Buffers.emplace_back();
+      for (ArrayRef<uint8_t> Record : Builder->records())
+        Buffers.back().insert(Buffers.back().end(), Record.begin(),
+                              Record.end());
+      BinaryStreamReader Reader(Buffers.back(), support::little);
+      Streams.emplace_back();
+      EXPECT_THAT_ERROR(Reader.readArray(Streams.back(), Reader.getLength()),
+                        Succeeded());
+    }
+    Builders.clear();
+    return Streams;
+  }
+
+  static TypeIndex writePointer(TypeTableBuilder &TTB, TypeIndex Referent) {
+    PointerRecord R(Referent, PointerKind::Near32, PointerMode::Pointer,
+                    PointerOptions::None, 4);
+    return TTB.writeKnownType(R);
+  }
+
+  static TypeIndex writeProcedure(TypeTableBuilder &TTB,
+                                  ArrayRef<TypeIndex> Args) {
+    ArgListRecord AL(TypeRecordKind::ArgList, Args);
+    TypeIndex ArgList = TTB.writeKnownType(AL);
+    ProcedureRecord R(TypeIndex::Void(), CallingConvention::NearC,
+                      FunctionOptions::None, Args.size(), ArgList);
+    return TTB.writeKnownType(R);
+  }
+
+  static TypeIndex writeFuncId(TypeTableBuilder &TTB, TypeIndex Type,
+                               StringRef Name) {
+    FuncIdRecord R(TypeIndex(), Type, Name);
+    return TTB.writeKnownType(R);
+  }
+
+  static TypeIndex writeStringId(TypeTableBuilder &TTB, StringRef S) {
+    StringIdRecord R(TypeIndex(), S);
+    return TTB.writeKnownType(R);
+  }
+
+  // The streams of two objects sharing a header, and a copy of the first one.
+  std::vector<CVTypeArray> makeTypesAndIds() {
+    TypeTableBuilder &A = startStream();
+    writeStringId(A, "a.cpp");
+    TypeIndex IntPtr = writePointer(A, TypeIndex::Int32());
+    writeFuncId(A, writeProcedure(A, {TypeIndex::Int32(), IntPtr}), "f");
+
+    TypeTableBuilder &B = startStream();
+    TypeIndex CharPtr = writePointer(B, TypeIndex::NarrowCharacter());
+    IntPtr = writePointer(B, TypeIndex::Int32());
+    writeFuncId(B, writeProcedure(B, {TypeIndex::Int32(), IntPtr}), "f");
+    writeFuncId(B, writeProcedure(B, {CharPtr}), "g");
+    writeStringId(B, "a.cpp");
+    writePointer(B, TypeIndex::Int32());
+
+    TypeTableBuilder &C = startStream();
+    writeStringId(C, "a.cpp");
+    IntPtr = writePointer(C, TypeIndex::Int32());
+    writeFuncId(C, writeProcedure(C, {TypeIndex::Int32(), IntPtr}), "f");
+    return finishStreams();
+  }
+
+  void expectSameTypeAndIdMerge(ArrayRef<CVTypeArray> Streams,
+                                size_t ExpectedIds, size_t ExpectedTypes) {
+    BumpPtrAllocator Allocator;
+    TypeTableBuilder Ids(Allocator), Types(Allocator);
+    std::vector<SmallVector<TypeIndex, 0>> Maps(Streams.size());
+    for (size_t I = 0; I != Streams.size(); ++I)
+      ASSERT_THAT_ERROR(mergeTypeAndIdRecords(Ids, Types, Maps[I], Streams[I]),
+                        Succeeded());
+    EXPECT_EQ(ExpectedIds, Ids.records().size());
+    EXPECT_EQ(ExpectedTypes, Types.records().size());
+
+    for (unsigned Threads : {1, 3}) {
+      TypeTableBuilder ParallelIds(Allocator), ParallelTypes(Allocator);
+      std::vector<SmallVector<TypeIndex, 0>> ParallelMaps(Streams.size());
+      ASSERT_THAT_ERROR(mergeTypeAndIdRecords(ParallelIds, ParallelTypes,
+                                              ParallelMaps, Streams, Threads),
+                        Succeeded());
+      EXPECT_EQ(Ids.records(), ParallelIds.records());
+      EXPECT_EQ(Types.records(), ParallelTypes.records());
+      EXPECT_EQ(Maps, ParallelMaps);
+    }
+  }
+
+  BumpPtrAllocator Storage;
+  std::vector<std::unique_ptr<TypeTableBuilder>> Builders;
+  std::deque<std::vector<uint8_t>> Buffers;
+};
+
+TEST_F(TypeStreamMergerTest, TypesAndIds) {
+  // Types: int*, char*, the argument lists and procedures of f and g.
+  // Ids: "a.cpp", f and g.
+  expectSameTypeAndIdMerge(makeTypesAndIds(), 3, 6);
+}
+
+TEST_F(TypeStreamMergerTest, ForwardReference) {
+  // A stream that isn't topologically sorted, like the streams written by
+  // MASM, can't be hashed, and is merged the slow way along with the others.
+  TypeTableBuilder &A = startStream();
+  writePointer(A, TypeIndex::fromArrayIndex(1));
+  ModifierRecord Const(TypeIndex::Int32(), ModifierOptions::Const);
+  A.writeKnownType(Const);
+  TypeTableBuilder &B = startStream();
+  writePointer(B, writeProcedure(B, {}));
+  writeStringId(B, "b.cpp");
+  std::vector<CVTypeArray> Streams = finishStreams();
+  expectSameTypeAndIdMerge(Streams, 1, 5);
+}
+
+TEST_F(TypeStreamMergerTest, TypesThenIds) {
+  // Separate type and id streams, as in PDBs.
+  TypeTableBuilder &TypesA = startStream();
+  TypeIndex IntPtr = writePointer(TypesA, TypeIndex::Int32());
+  TypeIndex ProcA = writeProcedure(TypesA, {IntPtr});
+  TypeTableBuilder &TypesB = startStream();
+  writePointer(TypesB, TypeIndex::NarrowCharacter());
+  IntPtr = writePointer(TypesB, TypeIndex::Int32());
+  TypeIndex ProcB = writeProcedure(TypesB, {IntPtr});
+  std::vector<CVTypeArray> TypeStreams = finishStreams();
+
+  TypeTableBuilder &IdsA = startStream();
+  writeFuncId(IdsA, ProcA, "f");
+  TypeTableBuilder &IdsB = startStream();
+  writeStringId(IdsB, "b.cpp");
+  writeFuncId(IdsB, ProcB, "f");
+  std::vector<CVTypeArray> IdStreams = finishStreams();
+
+  BumpPtrAllocator Allocator;
+  TypeTableBuilder Types(Allocator), Ids(Allocator);
+  std::vector<SmallVector<TypeIndex, 0>> TypeMaps(2), IdMaps(2);
+  for (size_t I = 0; I != 2; ++I) {
+    ASSERT_THAT_ERROR(mergeTypeRecords(Types, TypeMaps[I], TypeStreams[I]),
+                      Succeeded());
+    ASSERT_THAT_ERROR(
+        mergeIdRecords(Ids, TypeMaps[I], IdMaps[I], IdStreams[I]),
+        Succeeded());
+  }
+  EXPECT_EQ(4u, Types.records().size());
+  EXPECT_EQ(2u, Ids.records().size());
+
+  TypeTableBuilder ParallelTypes(Allocator), ParallelIds(Allocator);
+  std::vector<SmallVector<TypeIndex, 0>> ParallelTypeMaps(2),
+      ParallelIdMaps(2);
+  ASSERT_THAT_ERROR(
+      mergeTypeRecords(ParallelTypes, ParallelTypeMaps, TypeStreams, 2),
+      Succeeded());
+  ASSERT_THAT_ERROR(mergeIdRecords(ParallelIds, ParallelTypeMaps,
+                                   ParallelIdMaps, IdStreams, 2),
+                    Succeeded());
+  EXPECT_EQ(Types.records(), ParallelTypes.records());
+  EXPECT_EQ(Ids.records(), ParallelIds.records());
+  EXPECT_EQ(TypeMaps, ParallelTypeMaps);
+  EXPECT_EQ(IdMaps, ParallelIdMaps);
+}
+
+TEST_F(TypeStreamMergerTest, PrefilledDestination) {
+  // Records already in the destination are reused, as by the serial merge.
+  std::vector<CVTypeArray> Streams = makeTypesAndIds();
+  BumpPtrAllocator Allocator;
+  TypeTableBuilder Ids(Allocator), Types(Allocator);
+  writePointer(Types, TypeIndex::NarrowCharacter());
+  std::vector<SmallVector<TypeIndex, 0>> Maps(Streams.size());
+  ASSERT_THAT_ERROR(mergeTypeAndIdRecords(Ids, Types, Maps, Streams, 2),
+                    Succeeded());
+  EXPECT_EQ(6u, Types.records().size());
+  // char* of the second stream maps to the existing record.
+  EXPECT_EQ(TypeIndex::fromArrayIndex(0), Maps[1][0]);
+}
+
+} // end anonymous namespace
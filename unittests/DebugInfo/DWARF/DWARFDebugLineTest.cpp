@@ -0,0 +1,201 @@
+//===- llvm/unittest/DebugInfo/DWARFDebugLineTest.cpp ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/DWARF/DWARFDebugLine.h"
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <string>
+
+using namespace llvm;
+using namespace dwarf;
+
+namespace {
+
+using FileLineInfoKind = DILineInfoSpecifier::FileLineInfoKind;
+
+class LineProgramBuilder {
+  std::string Program;
+  raw_string_ostream OS;
+
+public:
+  LineProgramBuilder() : OS(Program) {}
+
+  void u8(uint8_t V) { OS << char(V); }
+  void uleb(uint64_t V) { encodeULEB128(V, OS); }
+  void sleb(int64_t V) { encodeSLEB128(V, OS); }
+  void u64(uint64_t V) {
+    for (unsigned I = 0; I != 8; ++I)
+      u8(V >> (8 * I));
+  }
+
+  void setAddress(uint64_t Address) {
+    u8(0);
+    uleb(9);
+    u8(DW_LNE_set_address);
+    u64(Address);
+  }
+  void defineFile(StringRef Name) {
+    u8(0);
+    uleb(1 + Name.size() + 1 + 3);
+    u8(DW_LNE_define_file);
+    OS << Name << '\0';
+    uleb(0);
+    uleb(0);
+    uleb(0);
+  }
+  void endSequence() {
+    u8(0);
+    uleb(1);
+    u8(DW_LNE_end_sequence);
+  }
+  void advancePC(uint64_t Delta) {
+    u8(DW_LNS_advance_pc);
+    uleb(Delta);
+  }
+  void advanceLine(int64_t Delta) {
+    u8(DW_LNS_advance_line);
+    sleb(Delta);
+  }
+  void setFile(uint64_t File) {
+    u8(DW_LNS_set_file);
+    uleb(File);
+  }
+  void copy() { u8(DW_LNS_copy); }
+
+  /// Wraps the program in a version 2 line table with a single file, "a.c".
+  std::string finalize() {
+    std::string Header;
+    raw_string_ostream HOS(Header);
+    HOS << char(1)                  // minimum_instruction_length
+        << char(1)                  // default_is_stmt
+        << char(-5)                 // line_base
+        << char(14)                 // line_range
+        << char(13);                // opcode_base
+    const char OpcodeLengths[] = {0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+    HOS.write(OpcodeLengths, sizeof(OpcodeLengths));
+    HOS << '\0';                    // No include directories.
+    HOS << "a.c" << '\0' << char(0) << char(0) << char(0);
+    HOS << '\0';                    // End of file names.
+    HOS.flush();
+    OS.flush();
+
+    std::string Table;
+    raw_string_ostream TOS(Table);
+    auto Write32 = [&](uint32_t V) {
+      for (unsigned I = 0; I != 4; ++I)
+        TOS << char(V >> (8 * I));
+    };
+    Write32(2 + 4 + Header.size() + Program.size()); // unit_length
+    TOS << char(2) << char(0);                        // version
+    Write32(Header.size());                           // header_length
+    TOS << Header << Program;
+    return TOS.str();
+  }
+};
+
+// Two sequences, out of address order, the second of which defines and uses
+// a second file.
+std::string makeLineTable() {
+  LineProgramBuilder B;
+  B.setAddress(0x2000);
+  B.advanceLine(9);
+  B.copy();
+  B.advancePC(4);
+  B.advanceLine(1);
+  B.copy();
+  B.advancePC(4);
+  B.endSequence();
+
+  B.setAddress(0x1000);
+  B.defineFile("b.c");
+  B.setFile(2);
+  B.advanceLine(19);
+  B.copy();
+  B.advancePC(8);
+  B.endSequence();
+  return B.finalize();
+}
+
+TEST(DWARFDebugLine, SequenceIndex) {
+  std::string Data = makeLineTable();
+  DWARFDataExtractor Extractor(Data, /*IsLittleEndian=*/true, 8);
+
+  DWARFDebugLine::LineTable Index;
+  uint32_t Offset = 0;
+  ASSERT_TRUE(Index.parseSequenceIndex(Extractor, &Offset));
+  EXPECT_EQ(Data.size(), Offset);
+  EXPECT_TRUE(Index.Rows.empty());
+  ASSERT_EQ(2u, Index.Sequences.size());
+  EXPECT_EQ(0x1000u, Index.Sequences[0].LowPC);
+  EXPECT_EQ(0x1008u, Index.Sequences[0].HighPC);
+  EXPECT_EQ(0x2000u, Index.Sequences[1].LowPC);
+  EXPECT_EQ(0x2008u, Index.Sequences[1].HighPC);
+  // The file defined in the program is part of the index.
+  EXPECT_EQ(2u, Index.Prologue.FileNames.size());
+
+  DWARFDebugLine::LineTable::RowVector Rows;
+  Index.parseSequenceRows(Extractor, Index.Sequences[1], Rows);
+  ASSERT_EQ(3u, Rows.size());
+  EXPECT_EQ(0x2000u, Rows[0].Address);
+  EXPECT_EQ(10u, Rows[0].Line);
+  EXPECT_EQ(0x2004u, Rows[1].Address);
+  EXPECT_EQ(11u, Rows[1].Line);
+  EXPECT_TRUE(Rows[2].EndSequence);
+
+  Index.parseSequenceRows(Extractor, Index.Sequences[0], Rows);
+  ASSERT_EQ(2u, Rows.size());
+  EXPECT_EQ(2u, Rows[0].File);
+  EXPECT_EQ(20u, Rows[0].Line);
+  EXPECT_EQ(2u, Index.Prologue.FileNames.size());
+}
+
+TEST(DWARFDebugLine, LazyLookupMatchesFullTable) {
+  std::string Data = makeLineTable();
+  DWARFDataExtractor Extractor(Data, /*IsLittleEndian=*/true, 8);
+
+  DWARFDebugLine Full;
+  const DWARFDebugLine::LineTable *FullTable =
+      Full.getOrParseLineTable(Extractor, 0);
+  ASSERT_TRUE(FullTable);
+
+  DWARFDebugLine Lazy;
+  // Keep a single row cached, so that every other lookup evicts a sequence.
+  Lazy.setMaxCachedSequenceRows(1);
+  const DWARFDebugLine::LineTable *LazyTable =
+      Lazy.getOrParseSequenceIndex(Extractor, 0);
+  ASSERT_TRUE(LazyTable);
+  EXPECT_TRUE(LazyTable->Rows.empty());
+
+  const uint64_t Addresses[] = {0x0fff, 0x1000, 0x1007, 0x1008, 0x2003,
+                                0x2000, 0x2004, 0x2007, 0x2008, 0x1004};
+  for (uint64_t Address : Addresses) {
+    DILineInfo Expected, Actual;
+    bool ExpectedFound = FullTable->getFileLineInfoForAddress(
+        Address, nullptr, FileLineInfoKind::Default, Expected);
+    bool ActualFound = Lazy.getFileLineInfoForAddress(
+        Extractor, *LazyTable, Address, nullptr, FileLineInfoKind::Default,
+        Actual);
+    EXPECT_EQ(ExpectedFound, ActualFound) << Address;
+    EXPECT_EQ(Expected, Actual) << Address;
+  }
+
+  DILineInfo Info;
+  ASSERT_TRUE(Lazy.getFileLineInfoForAddress(Extractor, *LazyTable, 0x1004,
+                                             nullptr,
+                                             FileLineInfoKind::Default, Info));
+  EXPECT_EQ("b.c", Info.FileName);
+  EXPECT_EQ(20u, Info.Line);
+
+  // Once the table is fully parsed, it is used for lookups directly.
+  EXPECT_EQ(FullTable, Full.getOrParseSequenceIndex(Extractor, 0));
+}
+
+} // end anonymous namespace
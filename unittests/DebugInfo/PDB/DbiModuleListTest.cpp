@@ -0,0 +1,57 @@
+//===- llvm/unittest/DebugInfo/PDB/DbiModuleListTest.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/PDB/Native/DbiModuleList.h"
+#include "llvm/DebugInfo/PDB/Native/RawTypes.h"
+#include "llvm/Support/BinaryByteStream.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Testing/Support/Error.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::pdb;
+
+static void appendDescriptor(std::vector<uint8_t> &Data, StringRef Name) {
+  Data.resize(Data.size() + sizeof(ModuleInfoHeader));
+  // The module name, then the object file name.
+  for (int I = 0; I != 2; ++I) {
+    Data.insert(Data.end(), Name.bytes_begin(), Name.bytes_end());
+    Data.push_back(0);
+  }
+  Data.resize(alignTo(Data.size(), 4));
+}
+
+TEST(DbiModuleListTest, LooksUpDescriptorsOnDemand) {
+  // Two modules, followed by a third whose descriptor is truncated.
+  std::vector<uint8_t> ModInfo;
+  appendDescriptor(ModInfo, "a.obj");
+  appendDescriptor(ModInfo, "b.obj");
+  ModInfo.resize(ModInfo.size() + 8);
+
+  // The file info substream: the header, the module indices and the file
+  // counts of the three modules, which have no source files.
+  std::vector<uint8_t> FileInfo(sizeof(FileInfoSubstreamHeader) + 3 * 2 * 2);
+  FileInfo[0] = 3;
+
+  BinaryByteStream ModInfoStream(ModInfo, support::little);
+  BinaryByteStream FileInfoStream(FileInfo, support::little);
+  DbiModuleList Modules;
+  EXPECT_THAT_ERROR(Modules.initialize(ModInfoStream, FileInfoStream),
+                    Succeeded());
+  EXPECT_EQ(3u, Modules.getModuleCount());
+
+  // Looking up the first modules, in any order, doesn't read the descriptor
+  // of the third one.
+  EXPECT_EQ("b.obj", Modules.getModuleDescriptor(1).getModuleName());
+  EXPECT_EQ("a.obj", Modules.getModuleDescriptor(0).getModuleName());
+  EXPECT_EQ("b.obj", Modules.getModuleDescriptor(1).getObjFileName());
+}
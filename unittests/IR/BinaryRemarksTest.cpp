@@ -0,0 +1,168 @@
+//===- unittests/IR/BinaryRemarksTest.cpp - Binary remarks tests ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/BinaryRemarks.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::remarks;
+
+namespace {
+
+RemarkLocation makeLoc(StringRef File, unsigned Line, unsigned Column) {
+  RemarkLocation Loc;
+  Loc.File = File;
+  Loc.Line = Line;
+  Loc.Column = Column;
+  return Loc;
+}
+
+// An inlining remark with a hotness and a located argument, and a remark with
+// neither a location nor arguments.
+std::vector<Remark> makeRemarks() {
+  std::vector<Remark> Remarks(2);
+  Remark &Inlined = Remarks[0];
+  Inlined.Kind = RemarkKind::Passed;
+  Inlined.PassName = "inline";
+  Inlined.RemarkName = "Inlined";
+  Inlined.FunctionName = "main";
+  Inlined.Loc = makeLoc("t.c", 4, 10);
+  Inlined.Hotness = 30;
+  RemarkArgument Callee;
+  Callee.Key = "Callee";
+  Callee.Val = "foo";
+  Callee.Loc = makeLoc("t.c", 1, 0);
+  Inlined.Args.push_back(Callee);
+  RemarkArgument String;
+  String.Key = "String";
+  String.Val = " inlined into ";
+  Inlined.Args.push_back(String);
+
+  Remark &Missed = Remarks[1];
+  Missed.Kind = RemarkKind::AnalysisAliasing;
+  Missed.PassName = "licm";
+  Missed.RemarkName = "LoadWithLoopInvariantAddressInvalidated";
+  Missed.FunctionName = "foo";
+  return Remarks;
+}
+
+std::string writeRemarks(ArrayRef<Remark> Remarks) {
+  std::string Data;
+  raw_string_ostream OS(Data);
+  Writer W(OS);
+  for (const Remark &R : Remarks)
+    W.emit(R);
+  EXPECT_EQ(Remarks.size(), W.size());
+  W.finalize();
+  return OS.str();
+}
+
+std::string toYAML(ArrayRef<Remark> Remarks) {
+  std::string Data;
+  raw_string_ostream OS(Data);
+  yaml::Output YOut(OS);
+  for (const Remark &R : Remarks)
+    writeYAML(YOut, R);
+  return OS.str();
+}
+
+TEST(BinaryRemarks, RoundTrip) {
+  std::vector<Remark> Remarks = makeRemarks();
+  std::string Data = writeRemarks(Remarks);
+  EXPECT_TRUE(isBinaryRemarks(Data));
+
+  Expected<Reader> ReaderOrErr = Reader::create(Data);
+  ASSERT_TRUE(bool(ReaderOrErr));
+  ASSERT_EQ(2u, ReaderOrErr->size());
+
+  Remark Inlined = ReaderOrErr->getRemark(0);
+  EXPECT_EQ(RemarkKind::Passed, Inlined.Kind);
+  EXPECT_EQ("inline", Inlined.PassName);
+  EXPECT_EQ("Inlined", Inlined.RemarkName);
+  EXPECT_EQ("main", Inlined.FunctionName);
+  ASSERT_TRUE(Inlined.Loc.hasValue());
+  EXPECT_EQ("t.c", Inlined.Loc->File);
+  EXPECT_EQ(4u, Inlined.Loc->Line);
+  EXPECT_EQ(10u, Inlined.Loc->Column);
+  ASSERT_TRUE(Inlined.Hotness.hasValue());
+  EXPECT_EQ(30u, *Inlined.Hotness);
+  ASSERT_EQ(2u, Inlined.Args.size());
+  EXPECT_EQ("Callee", Inlined.Args[0].Key);
+  EXPECT_EQ("foo", Inlined.Args[0].Val);
+  ASSERT_TRUE(Inlined.Args[0].Loc.hasValue());
+  EXPECT_EQ(1u, Inlined.Args[0].Loc->Line);
+  EXPECT_EQ(" inlined into ", Inlined.Args[1].Val);
+  EXPECT_FALSE(Inlined.Args[1].Loc.hasValue());
+
+  Remark Missed = ReaderOrErr->getRemark(1);
+  EXPECT_EQ(RemarkKind::AnalysisAliasing, Missed.Kind);
+  EXPECT_EQ("foo", Missed.FunctionName);
+  EXPECT_FALSE(Missed.Loc.hasValue());
+  EXPECT_FALSE(Missed.Hotness.hasValue());
+  EXPECT_TRUE(Missed.Args.empty());
+
+  // The remarks read back convert to the same YAML as the originals.
+  std::vector<Remark> Copy = {Inlined, Missed};
+  EXPECT_EQ(toYAML(Remarks), toYAML(Copy));
+}
+
+TEST(BinaryRemarks, YAML) {
+  std::vector<Remark> Remarks = makeRemarks();
+  EXPECT_EQ("--- !Passed\n"
+            "Pass:            inline\n"
+            "Name:            Inlined\n"
+            "DebugLoc:        { File: t.c, Line: 4, Column: 10 }\n"
+            "Function:        main\n"
+            "Hotness:         30\n"
+            "Args:            \n"
+            "  - Callee:          foo\n"
+            "    DebugLoc:        { File: t.c, Line: 1, Column: 0 }\n"
+            "  - String:          ' inlined into '\n"
+            "...\n"
+            "--- !AnalysisAliasing\n"
+            "Pass:            licm\n"
+            "Name:            LoadWithLoopInvariantAddressInvalidated\n"
+            "Function:        foo\n"
+            "...\n",
+            toYAML(Remarks));
+}
+
+TEST(BinaryRemarks, Empty) {
+  std::string Data = writeRemarks({});
+  Expected<Reader> ReaderOrErr = Reader::create(Data);
+  ASSERT_TRUE(bool(ReaderOrErr));
+  EXPECT_EQ(0u, ReaderOrErr->size());
+}
+
+TEST(BinaryRemarks, Invalid) {
+  std::string Data = writeRemarks(makeRemarks());
+
+  auto ExpectInvalid = [](StringRef Data) {
+    Expected<Reader> ReaderOrErr = Reader::create(Data);
+    EXPECT_FALSE(bool(ReaderOrErr));
+    consumeError(ReaderOrErr.takeError());
+  };
+  ExpectInvalid("");
+  ExpectInvalid("LLVMRMRK");
+  ExpectInvalid("--- !Passed\n");
+  ExpectInvalid(StringRef(Data).drop_back());
+
+  std::string BadVersion = Data;
+  BadVersion[8] = 2;
+  ExpectInvalid(BadVersion);
+
+  // The first remark follows the header; make its kind unknown.
+  std::string BadKind = Data;
+  BadKind[sizeof(storage::Header)] = 15;
+  ExpectInvalid(BadKind);
+}
+
+} // end anonymous namespace
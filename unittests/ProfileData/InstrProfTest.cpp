@@ -137,6 +137,34 @@ TEST_P(MaybeSparseInstrProfTest, get_function_counts) {
   ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, std::move(E2)));
 }
 
+TEST_P(MaybeSparseInstrProfTest, get_instr_prof_record_ref) {
+  Writer.addRecord({"foo", 0x1234, {1, 2}}, Err);
+  Writer.addRecord({"foo", 0x1235, {3, 4, 5}}, Err);
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  Expected<IndexedInstrProfRecordRef> R =
+      Reader->getInstrProfRecordRef("foo", 0x1235);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(0x1235U, R->Hash);
+  ASSERT_EQ(3U, R->Counts.size());
+  ASSERT_EQ(3U, R->Counts[0]);
+  ASSERT_EQ(4U, R->Counts[1]);
+  ASSERT_EQ(5U, R->Counts[2]);
+
+  R = Reader->getInstrProfRecordRef("foo", 0x1234);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(2U, R->Counts.size());
+  ASSERT_EQ(1U, R->Counts[0]);
+  ASSERT_EQ(2U, R->Counts[1]);
+
+  R = Reader->getInstrProfRecordRef("foo", 0x5678);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::hash_mismatch, R.takeError()));
+
+  R = Reader->getInstrProfRecordRef("bar", 0x1234);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, R.takeError()));
+}
+
 // Profile data is copied from general.proftext
 TEST_F(InstrProfTest, get_profile_summary) {
   Writer.addRecord({"func1", 0x1234, {97531}}, Err);
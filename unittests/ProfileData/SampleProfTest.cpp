@@ -10,6 +10,10 @@
 #include "llvm/ProfileData/SampleProf.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
@@ -168,6 +172,57 @@ TEST_F(SampleProfTest, roundtrip_binary_profile) {
   testRoundTrip(SampleProfileFormat::SPF_Binary);
 }
 
+TEST_F(SampleProfTest, roundtrip_compact_binary_profile) {
+  testRoundTrip(SampleProfileFormat::SPF_Compact_Binary);
+}
+
+TEST_F(SampleProfTest, compact_binary_profile_loads_module_functions) {
+  createWriter(SampleProfileFormat::SPF_Compact_Binary);
+
+  StringRef FooName("_Z3fooi");
+  FunctionSamples FooSamples;
+  FooSamples.setName(FooName);
+  FooSamples.addTotalSamples(7711);
+  FooSamples.addHeadSamples(610);
+  FooSamples.addBodySamples(1, 0, 610);
+
+  StringRef BarName("_Z3bari");
+  FunctionSamples BarSamples;
+  BarSamples.setName(BarName);
+  BarSamples.addTotalSamples(20301);
+  BarSamples.addHeadSamples(1437);
+  BarSamples.addBodySamples(1, 0, 1437);
+
+  StringMap<FunctionSamples> Profiles;
+  Profiles[FooName] = std::move(FooSamples);
+  Profiles[BarName] = std::move(BarSamples);
+  ASSERT_TRUE(NoError(Writer->write(Profiles)));
+  Writer->getOutputStream().flush();
+
+  auto Profile = MemoryBuffer::getMemBufferCopy(Data);
+  readProfile(Profile);
+
+  // Only foo is defined in the module, under a suffixed name.
+  Module M("my_module", Context);
+  FunctionType *FnType = FunctionType::get(Type::getVoidTy(Context), false);
+  Function *Foo = Function::Create(FnType, GlobalValue::ExternalLinkage,
+                                   "_Z3fooi.llvm.42", &M);
+  ReturnInst::Create(Context, BasicBlock::Create(Context, "entry", Foo));
+  Function *Bar =
+      Function::Create(FnType, GlobalValue::ExternalLinkage, BarName, &M);
+
+  Reader->collectFuncsToUse(M);
+  ASSERT_TRUE(NoError(Reader->read()));
+
+  StringMap<FunctionSamples> &ReadProfiles = Reader->getProfiles();
+  ASSERT_EQ(1u, ReadProfiles.size());
+  FunctionSamples *ReadFooSamples = Reader->getSamplesFor(*Foo);
+  ASSERT_TRUE(ReadFooSamples);
+  ASSERT_EQ(7711u, ReadFooSamples->getTotalSamples());
+  ASSERT_EQ(610u, ReadFooSamples->getHeadSamples());
+  ASSERT_EQ(nullptr, Reader->getSamplesFor(*Bar));
+}
+
 TEST_F(SampleProfTest, sample_overflow_saturation) {
   const uint64_t Max = std::numeric_limits<uint64_t>::max();
   sampleprof_error Result;
@@ -9,6 +9,9 @@
 
 #include "llvm/Support/CachePruning.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -65,6 +68,18 @@ TEST(CachePruningPolicyParser, MaxSizeBytes) {
   EXPECT_EQ(4ull * 1024ull * 1024ull * 1024ull, P->MaxSizeBytes);
 }
 
+TEST(CachePruningPolicyParser, PruneBy) {
+  auto P = parseCachePruningPolicy("");
+  ASSERT_TRUE(bool(P));
+  EXPECT_FALSE(P->PruneByCost);
+  P = parseCachePruningPolicy("prune_by=cost");
+  ASSERT_TRUE(bool(P));
+  EXPECT_TRUE(P->PruneByCost);
+  P = parseCachePruningPolicy("prune_by=size");
+  ASSERT_TRUE(bool(P));
+  EXPECT_FALSE(P->PruneByCost);
+}
+
 TEST(CachePruningPolicyParser, Multiple) {
   auto P = parseCachePruningPolicy("prune_after=1s:cache_size=50%");
   ASSERT_TRUE(bool(P));
@@ -92,6 +107,82 @@ TEST(CachePruningPolicyParser, Errors) {
   EXPECT_EQ(
       "'foo' not an integer",
       toString(parseCachePruningPolicy("cache_size_bytes=foom").takeError()));
+  EXPECT_EQ("'foo' must be one of 'size' or 'cost'",
+            toString(parseCachePruningPolicy("prune_by=foo").takeError()));
   EXPECT_EQ("Unknown key: 'foo'",
             toString(parseCachePruningPolicy("foo=bar").takeError()));
 }
+
+static void writeEntry(StringRef Dir, StringRef Name, size_t Size) {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, Name);
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+  ASSERT_FALSE(EC);
+  OS << std::string(Size, 'x');
+}
+
+static bool entryExists(StringRef Dir, StringRef Name) {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, Name);
+  return sys::fs::exists(Path);
+}
+
+TEST(CachePruning, PruneByCost) {
+  SmallString<128> Dir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("cache-pruning-test", Dir));
+
+  writeEntry(Dir, "llvmcache-cheap", 4000);
+  writeEntry(Dir, "llvmcache-costly", 4000);
+  writeEntry(Dir, "llvmcache-small", 1000);
+
+  auto P = parseCachePruningPolicy(
+      "prune_interval=0s:cache_size=100%:cache_size_bytes=7000:prune_by=cost");
+  ASSERT_TRUE(bool(P));
+  // Per byte, the first entry is the cheapest to recreate, then the third one.
+  P->GetEntryCost = [](StringRef Path) -> Optional<uint32_t> {
+    StringRef Name = sys::path::filename(Path);
+    if (Name == "llvmcache-cheap")
+      return 10;
+    if (Name == "llvmcache-costly")
+      return 1000;
+    if (Name == "llvmcache-small")
+      return 20;
+    return None;
+  };
+  EXPECT_TRUE(pruneCache(Dir, *P));
+  EXPECT_FALSE(entryExists(Dir, "llvmcache-cheap"));
+  EXPECT_TRUE(entryExists(Dir, "llvmcache-costly"));
+  EXPECT_TRUE(entryExists(Dir, "llvmcache-small"));
+
+  // Pruning by size removes the largest entry instead.
+  writeEntry(Dir, "llvmcache-cheap", 4000);
+  SmallString<128> TimestampFile(Dir);
+  sys::path::append(TimestampFile, "llvmcache.timestamp");
+  ASSERT_FALSE(sys::fs::remove(TimestampFile));
+  P->PruneByCost = false;
+  EXPECT_TRUE(pruneCache(Dir, *P));
+  EXPECT_EQ(1, entryExists(Dir, "llvmcache-cheap") +
+                   entryExists(Dir, "llvmcache-costly"));
+  EXPECT_TRUE(entryExists(Dir, "llvmcache-small"));
+
+  ASSERT_FALSE(sys::fs::remove_directories(Dir));
+}
+
+TEST(CachePruning, PruneByCostWithoutCosts) {
+  SmallString<128> Dir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("cache-pruning-test", Dir));
+
+  writeEntry(Dir, "llvmcache-large", 4000);
+  writeEntry(Dir, "llvmcache-small", 1000);
+
+  // Without GetEntryCost, the largest entries are removed first.
+  auto P = parseCachePruningPolicy(
+      "prune_interval=0s:cache_size=100%:cache_size_bytes=3000:prune_by=cost");
+  ASSERT_TRUE(bool(P));
+  EXPECT_TRUE(pruneCache(Dir, *P));
+  EXPECT_FALSE(entryExists(Dir, "llvmcache-large"));
+  EXPECT_TRUE(entryExists(Dir, "llvmcache-small"));
+
+  ASSERT_FALSE(sys::fs::remove_directories(Dir));
+}
@@ -15,6 +15,7 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
 
 uint32_t array[1024 * 1024];
@@ -50,4 +51,34 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+#if LLVM_ENABLE_THREADS
+TEST(Parallel, nested_task_groups) {
+  // Syncing a TaskGroup from inside a task must not deadlock, even when there
+  // are more outer tasks than worker threads.
+  std::atomic<unsigned> Count(0);
+  {
+    parallel::detail::TaskGroup Outer;
+    for (unsigned I = 0; I < 64; ++I)
+      Outer.spawn([&Count] {
+        parallel::detail::TaskGroup Inner;
+        for (unsigned J = 0; J < 64; ++J)
+          Inner.spawn([&Count] { ++Count; });
+        Inner.sync();
+        ++Count;
+      });
+  }
+  ASSERT_EQ(Count, 64u * 65u);
+}
+
+TEST(Parallel, shared_queue_executor) {
+  std::atomic<unsigned> Count(0);
+  {
+    parallel::detail::TaskGroup TG(parallel::detail::ExecutorKind::SharedQueue);
+    for (unsigned I = 0; I < 1000; ++I)
+      TG.spawn([&Count] { ++Count; });
+  }
+  ASSERT_EQ(Count, 1000u);
+}
+#endif
+
 #endif
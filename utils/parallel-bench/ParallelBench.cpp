@@ -0,0 +1,84 @@
+//===- ParallelBench - Benchmark the Parallel.h executors -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program runs many small tasks through parallel::detail::TaskGroup on
+// the work-stealing and on the shared-queue executor and outputs the run time
+// of each.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+
+using namespace llvm;
+using namespace llvm::parallel::detail;
+
+static cl::opt<unsigned>
+    NumTasks("tasks", cl::desc("Number of tasks to spawn per run"),
+             cl::init(1 << 20));
+
+static cl::opt<unsigned>
+    TaskWork("work", cl::desc("Number of loop iterations done by each task"),
+             cl::init(100));
+
+static cl::opt<unsigned>
+    NestedWidth("nested-width",
+                cl::desc("Number of tasks spawned by each outer task in the "
+                         "nested run (work-stealing executor only)"),
+                cl::init(256));
+
+static std::atomic<uint64_t> Sink{0};
+
+static void doWork() {
+  uint64_t X = 0;
+  for (unsigned I = 0; I != TaskWork; ++I)
+    X = X * 6364136223846793005ULL + I;
+  Sink += X;
+}
+
+static void runFlat(ExecutorKind Kind) {
+  TaskGroup TG(Kind);
+  for (unsigned I = 0; I != NumTasks; ++I)
+    TG.spawn(doWork);
+}
+
+static void runNested() {
+  TaskGroup Outer;
+  for (unsigned I = 0, E = NumTasks / NestedWidth; I != E; ++I)
+    Outer.spawn([] {
+      TaskGroup Inner;
+      for (unsigned J = 0; J != NestedWidth; ++J)
+        Inner.spawn(doWork);
+    });
+}
+
+static void runTimed(Timer &T, function_ref<void()> Run) {
+  T.startTimer();
+  Run();
+  T.stopTimer();
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "Parallel.h executor benchmark\n");
+  if (NestedWidth == 0)
+    NestedWidth = 1;
+
+  TimerGroup Group("parallel", "Parallel.h executor benchmark");
+  Timer SharedQueue("shared-queue", "Shared queue: flat tasks", Group);
+  Timer WorkStealing("work-stealing", "Work stealing: flat tasks", Group);
+  Timer Nested("work-stealing.nested", "Work stealing: nested tasks", Group);
+
+  runTimed(SharedQueue, [] { runFlat(ExecutorKind::SharedQueue); });
+  runTimed(WorkStealing, [] { runFlat(ExecutorKind::WorkStealing); });
+  runTimed(Nested, runNested);
+  return 0;
+}